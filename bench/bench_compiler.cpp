@@ -0,0 +1,189 @@
+// nanoscript-bench — microbenchmarks for each compiler stage plus end-to-end
+// throughput per BuildConfig, over programs from the synthetic generator.
+//
+//   nanoscript-bench --benchmark_filter=Lexer
+//   nanoscript-bench --benchmark_format=json > baseline.json
+
+#include "generator.hpp"
+
+#include "fold.hpp"
+#include "interp.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "types.hpp"
+#ifdef NANOSCRIPT_BENCH_CODEGEN
+#include "codegen.hpp"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+
+namespace {
+
+struct Workload {
+    std::string source;
+    size_t      tokens = 0;
+    size_t      lines  = 0;
+};
+
+// One program per size, generated once and shared by every benchmark
+const Workload& workload(int64_t statements) {
+    static std::map<int64_t, Workload> cache;
+    auto [it, inserted] = cache.try_emplace(statements);
+    if (inserted) {
+        GeneratorOptions opts;
+        opts.statements = static_cast<uint32_t>(statements);
+        opts.variables  = static_cast<uint32_t>(std::max<int64_t>(statements / 5, 1));
+        it->second.source = generateProgram(opts);
+        DiagnosticEngine diag("bench.nano");
+        it->second.tokens = Lexer(it->second.source, diag).tokenize().size();
+        it->second.lines  = static_cast<size_t>(
+            std::count(it->second.source.begin(), it->second.source.end(), '\n'));
+    }
+    return it->second;
+}
+
+void setThroughput(benchmark::State& state, const Workload& w) {
+    const auto n = static_cast<double>(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(w.source.size()));
+    state.counters["tokens/s"] =
+        benchmark::Counter(n * static_cast<double>(w.tokens), benchmark::Counter::kIsRate);
+    state.counters["lines/s"] =
+        benchmark::Counter(n * static_cast<double>(w.lines), benchmark::Counter::kIsRate);
+}
+
+void sizes(benchmark::internal::Benchmark* b) {
+    b->ArgName("stmts")->Arg(1000)->Arg(10000)->Arg(100000)
+     ->Unit(benchmark::kMillisecond);
+}
+
+// The same, crossed with alloca (0) vs direct-SSA (1) lowering
+void sizesConfigsAndLowering(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"stmts", "config", "ssa"})
+     ->ArgsProduct({{1000, 10000}, {0, 1, 2, 3}, {0, 1}})
+     ->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+// ── Front end ─────────────────────────────────────────────────────────────
+
+static void BM_Lexer(benchmark::State& state) {
+    const Workload& w = workload(state.range(0));
+    DiagnosticEngine diag("bench.nano");
+    for (auto _ : state) {
+        auto tokens = Lexer(w.source, diag).tokenize();
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    setThroughput(state, w);
+}
+BENCHMARK(BM_Lexer)->Apply(sizes);
+
+static void BM_Parser(benchmark::State& state) {
+    const Workload&          w      = workload(state.range(0));
+    DiagnosticEngine         diag("bench.nano");
+    const std::vector<Token> tokens = Lexer(w.source, diag).tokenize();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Token> copy = tokens;
+        state.ResumeTiming();
+        auto ast = Parser(std::move(copy), w.source, diag).parse();
+        benchmark::DoNotOptimize(ast.get());
+        state.PauseTiming();
+        ast.reset();   // arena teardown is not parsing
+        state.ResumeTiming();
+    }
+    setThroughput(state, w);
+}
+BENCHMARK(BM_Parser)->Apply(sizes);
+
+static void BM_Fold(benchmark::State& state) {
+    const Workload& w = workload(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto ast = parseSource(w.source, "bench.nano");
+        state.ResumeTiming();
+        optimizeAST(*ast);
+        benchmark::DoNotOptimize(ast->statements.data());
+        state.PauseTiming();
+        ast.reset();
+        state.ResumeTiming();
+    }
+    setThroughput(state, w);
+}
+BENCHMARK(BM_Fold)->Apply(sizes);
+
+static void BM_Bytecode(benchmark::State& state) {
+    const Workload& w   = workload(state.range(0));
+    auto            ast = parseSource(w.source, "bench.nano");
+    for (auto _ : state) {
+        Interpreter interp(*ast);
+        benchmark::DoNotOptimize(interp.instructionCount());
+    }
+    setThroughput(state, w);
+}
+BENCHMARK(BM_Bytecode)->Apply(sizes);
+
+#ifdef NANOSCRIPT_BENCH_CODEGEN
+
+// ── Backend ───────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr BuildConfig CONFIGS[] = {
+    BuildConfig::Debug, BuildConfig::Fast, BuildConfig::Development, BuildConfig::Shipping,
+};
+
+void sizesAndConfigs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"stmts", "config"})
+     ->ArgsProduct({{1000, 10000}, {0, 1, 2, 3}})   // debug, fast, development, shipping
+     ->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+// IR generation + the config's pipeline + verification, on the unfolded
+// AST: generated programs are all-constant, so folding would leave codegen
+// almost nothing to do.
+static void BM_Codegen(benchmark::State& state) {
+    const Workload&   w      = workload(state.range(0));
+    const BuildConfig config = CONFIGS[state.range(1)];
+    CodegenOptions    options;
+    options.ssa = state.range(2) != 0;
+    auto ast    = parseSource(w.source, "bench.nano");
+    for (auto _ : state) {
+        Codegen cg("bench.nano", "/tmp", config, /*wasm=*/false, options);
+        cg.generate(*ast);
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w);
+}
+BENCHMARK(BM_Codegen)->Apply(sizesConfigsAndLowering);
+
+// Source bytes → object file, exactly as compileFile runs it minus the link
+static void BM_EndToEnd(benchmark::State& state) {
+    const Workload&   w      = workload(state.range(0));
+    const BuildConfig config = CONFIGS[state.range(1)];
+    const std::string object =
+        (std::filesystem::temp_directory_path() / "nanoscript-bench.o").string();
+    for (auto _ : state) {
+        auto ast = parseSource(w.source, "bench.nano");
+        checkTypes(*ast);
+        optimizeAST(*ast);
+        Codegen cg("bench.nano", "/tmp", config);
+        cg.generate(*ast);
+        cg.writeObject(object);
+    }
+    std::filesystem::remove(object);
+    setThroughput(state, w);
+}
+BENCHMARK(BM_EndToEnd)->Apply(sizesAndConfigs);
+
+#endif // NANOSCRIPT_BENCH_CODEGEN
+
+BENCHMARK_MAIN();
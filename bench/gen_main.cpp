@@ -0,0 +1,62 @@
+// nanoscript-gen — write a synthetic NanoScript program to stdout (or -o FILE)
+
+#include "generator.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void printUsage() {
+    std::cerr <<
+        "Usage: nanoscript-gen [options] [-o output.nano]\n"
+        "\n"
+        "  --statements=N   top-level statements          (default: 10000)\n"
+        "  --variables=N    distinct variables            (default: 2000)\n"
+        "  --expr-depth=N   max expression nesting        (default: 6)\n"
+        "  --if-depth=N     max nesting of if bodies      (default: 4)\n"
+        "  --out-percent=N  share of out statements, %    (default: 2)\n"
+        "  --seed=N         RNG seed                      (default: 1)\n";
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions opts;
+    std::string      output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&](const char* flag, auto& field) {
+            const std::string prefix = std::string(flag) + "=";
+            if (arg.rfind(prefix, 0) != 0) return false;
+            field = static_cast<std::remove_reference_t<decltype(field)>>(
+                std::strtoull(arg.c_str() + prefix.size(), nullptr, 10));
+            return true;
+        };
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (value("--statements", opts.statements) ||
+                   value("--variables", opts.variables) ||
+                   value("--expr-depth", opts.exprDepth) ||
+                   value("--if-depth", opts.ifDepth) ||
+                   value("--out-percent", opts.outPercent) ||
+                   value("--seed", opts.seed)) {
+            continue;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    const std::string program = generateProgram(opts);
+    if (output.empty()) {
+        std::cout << program;
+        return 0;
+    }
+    std::ofstream out(output, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: cannot write '" << output << "'\n";
+        return 1;
+    }
+    out << program;
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+class Generator {
+public:
+    explicit Generator(const GeneratorOptions& opts) : opts_(opts), rng_(opts.seed) {
+        out_.reserve(static_cast<size_t>(opts.statements) * 48);
+    }
+
+    std::string run() {
+        // Seed a few variables so the first expressions have something to read
+        const uint32_t seeded = std::clamp<uint32_t>(opts_.variables, 1, 8);
+        for (; defined_ < seeded; ++defined_)
+            out_ += "v" + std::to_string(defined_) + " = " +
+                    std::to_string(pick(1, 1000)) + ";\n";
+        for (uint32_t i = 0; i < opts_.statements; ++i)
+            statement(0);
+        return std::move(out_);
+    }
+
+private:
+    const GeneratorOptions& opts_;
+    std::mt19937_64         rng_;
+    std::string             out_;
+    uint32_t                defined_ = 0;   // v0 .. v(defined_-1) are assigned
+
+    uint32_t pick(uint32_t lo, uint32_t hi) {
+        return std::uniform_int_distribution<uint32_t>(lo, hi)(rng_);
+    }
+
+    void indent(uint32_t depth) { out_.append(depth * 4, ' '); }
+
+    void variable() {
+        out_ += 'v';
+        out_ += std::to_string(pick(0, defined_ - 1));
+    }
+
+    void expr(uint32_t depth) {
+        if (depth >= opts_.exprDepth || pick(0, 99) < 25) {
+            if (pick(0, 1)) variable();
+            else            out_ += std::to_string(pick(0, 9999));
+            return;
+        }
+        static constexpr const char* ARITH[] = {" + ", " - ", " * "};
+        static constexpr const char* CMP[]   = {" == ", " != ", " < ", " > ", " <= ", " >= "};
+        const uint32_t kind = pick(0, 99);
+        out_ += '(';
+        expr(depth + 1);
+        if (kind < 70) {
+            out_ += ARITH[pick(0, 2)];
+            expr(depth + 1);
+        } else if (kind < 85) {
+            out_ += CMP[pick(0, 5)];
+            expr(depth + 1);
+        } else {
+            out_ += " / ";
+            out_ += std::to_string(pick(1, 97));   // never zero
+        }
+        out_ += ')';
+    }
+
+    void statement(uint32_t depth) {
+        const uint32_t kind = pick(0, 99);
+        indent(depth);
+        if (kind < opts_.outPercent) {
+            out_ += "out ";
+            expr(0);
+            out_ += ";\n";
+        } else if (kind < opts_.outPercent + 12 && depth < opts_.ifDepth) {
+            out_ += "if (";
+            expr(opts_.exprDepth / 2);
+            out_ += ") {\n";
+            for (uint32_t n = pick(1, 4); n > 0; --n)
+                statement(depth + 1);
+            indent(depth);
+            out_ += "}\n";
+        } else {
+            // Introduce new variables until the budget is spent, then reuse
+            const uint32_t target = defined_ < opts_.variables && pick(0, 3) == 0
+                ? defined_ : pick(0, defined_ - 1);
+            out_ += 'v';
+            out_ += std::to_string(target);
+            out_ += " = ";
+            expr(0);
+            out_ += ";\n";
+            if (target == defined_) ++defined_;
+        }
+    }
+};
+
+} // namespace
+
+std::string generateProgram(const GeneratorOptions& opts) {
+    return Generator(opts).run();
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// Shape of a synthetic NanoScript program. Every program generated is
+/// valid: variables are assigned before they are read and divisors are
+/// non-zero literals, so it lexes, parses, compiles and runs.
+struct GeneratorOptions {
+    uint32_t statements = 10000;  // top-level statements (bodies add more)
+    uint32_t variables  = 2000;   // distinct identifiers
+    uint32_t exprDepth  = 6;      // max binary-operator nesting per expression
+    uint32_t ifDepth    = 4;      // max nesting of `if` bodies
+    uint32_t outPercent = 2;      // share of statements that are `out`
+    uint64_t seed       = 1;      // same options + seed → same program
+};
+
+std::string generateProgram(const GeneratorOptions& opts);
@@ -0,0 +1,307 @@
+#include "json.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+// ── Construction / access ─────────────────────────────────────────────────
+
+Json Json::object(std::initializer_list<Member> members) {
+    Json j;
+    j.type_   = Type::Object;
+    j.object_ = members;
+    return j;
+}
+
+Json Json::array(std::vector<Json> items) {
+    Json j;
+    j.type_  = Type::Array;
+    j.array_ = std::move(items);
+    return j;
+}
+
+static const std::string               EMPTY_STRING;
+static const std::vector<Json>         EMPTY_ARRAY;
+static const std::vector<Json::Member> EMPTY_OBJECT;
+static const Json                      NULL_JSON;
+
+const std::string& Json::asString() const {
+    return type_ == Type::String ? string_ : EMPTY_STRING;
+}
+
+const std::vector<Json>& Json::items() const {
+    return type_ == Type::Array ? array_ : EMPTY_ARRAY;
+}
+
+const std::vector<Json::Member>& Json::members() const {
+    return type_ == Type::Object ? object_ : EMPTY_OBJECT;
+}
+
+const Json& Json::operator[](std::string_view key) const {
+    for (const Member& m : members())
+        if (m.first == key) return m.second;
+    return NULL_JSON;
+}
+
+bool Json::contains(std::string_view key) const {
+    for (const Member& m : members())
+        if (m.first == key) return true;
+    return false;
+}
+
+Json& Json::set(std::string key, Json value) {
+    if (type_ != Type::Object) *this = object();
+    for (Member& m : object_)
+        if (m.first == key) return m.second = std::move(value);
+    object_.emplace_back(std::move(key), std::move(value));
+    return object_.back().second;
+}
+
+Json& Json::push(Json value) {
+    if (type_ != Type::Array) *this = array();
+    array_.push_back(std::move(value));
+    return array_.back();
+}
+
+// ── Parser ────────────────────────────────────────────────────────────────
+
+namespace {
+
+class Reader {
+public:
+    explicit Reader(std::string_view text) : s_(text) {}
+
+    Json document() {
+        Json v = value();
+        skipSpace();
+        if (pos_ != s_.size()) fail("trailing characters");
+        return v;
+    }
+
+private:
+    std::string_view s_;
+    size_t           pos_   = 0;
+    int              depth_ = 0;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("JSON: ") + what + " at offset " +
+                                 std::to_string(pos_));
+    }
+
+    void skipSpace() {
+        while (pos_ < s_.size() &&
+               (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\n' || s_[pos_] == '\r'))
+            ++pos_;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos_ < s_.size() && s_[pos_] == c) { ++pos_; return true; }
+        return false;
+    }
+
+    void expectWord(std::string_view w) {
+        if (s_.substr(pos_, w.size()) != w) fail("invalid literal");
+        pos_ += w.size();
+    }
+
+    Json value() {
+        skipSpace();
+        if (pos_ >= s_.size()) fail("unexpected end");
+        if (++depth_ > 256) fail("nesting too deep");
+        Json v;
+        switch (s_[pos_]) {
+            case '{': v = objectValue(); break;
+            case '[': v = arrayValue();  break;
+            case '"': v = Json(string()); break;
+            case 't': expectWord("true");  v = Json(true);  break;
+            case 'f': expectWord("false"); v = Json(false); break;
+            case 'n': expectWord("null");  break;
+            default:  v = number(); break;
+        }
+        --depth_;
+        return v;
+    }
+
+    Json objectValue() {
+        ++pos_;   // '{'
+        Json obj = Json::object();
+        if (consume('}')) return obj;
+        do {
+            skipSpace();
+            if (pos_ >= s_.size() || s_[pos_] != '"') fail("expected member name");
+            std::string key = string();
+            if (!consume(':')) fail("expected ':'");
+            obj.set(std::move(key), value());
+        } while (consume(','));
+        if (!consume('}')) fail("expected '}'");
+        return obj;
+    }
+
+    Json arrayValue() {
+        ++pos_;   // '['
+        Json arr = Json::array();
+        if (consume(']')) return arr;
+        do {
+            arr.push(value());
+        } while (consume(','));
+        if (!consume(']')) fail("expected ']'");
+        return arr;
+    }
+
+    Json number() {
+        const char* begin = s_.data() + pos_;
+        size_t      end   = pos_;
+        while (end < s_.size() &&
+               (std::isdigit(static_cast<unsigned char>(s_[end])) || s_[end] == '-' ||
+                s_[end] == '+' || s_[end] == '.' || s_[end] == 'e' || s_[end] == 'E'))
+            ++end;
+        if (end == pos_) fail("unexpected character");
+        const std::string digits(begin, end - pos_);
+        char*        stop = nullptr;
+        const double n    = std::strtod(digits.c_str(), &stop);
+        if (stop != digits.c_str() + digits.size()) fail("malformed number");
+        pos_ = end;
+        return Json(n);
+    }
+
+    unsigned hex4() {
+        if (pos_ + 4 > s_.size()) fail("truncated \\u escape");
+        unsigned v = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = s_[pos_++];
+            v <<= 4;
+            if      (c >= '0' && c <= '9') v |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') v |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') v |= static_cast<unsigned>(c - 'A' + 10);
+            else fail("bad \\u escape");
+        }
+        return v;
+    }
+
+    static void appendUTF8(std::string& out, unsigned cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    std::string string() {
+        ++pos_;   // opening quote
+        std::string out;
+        for (;;) {
+            if (pos_ >= s_.size()) fail("unterminated string");
+            const char c = s_[pos_++];
+            if (c == '"') return out;
+            if (c != '\\') { out += c; continue; }
+            if (pos_ >= s_.size()) fail("unterminated escape");
+            switch (s_[pos_++]) {
+                case '"':  out += '"';  break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/';  break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    unsigned cp = hex4();
+                    // Surrogate pair → one code point
+                    if (cp >= 0xD800 && cp < 0xDC00 && s_.substr(pos_, 2) == "\\u") {
+                        pos_ += 2;
+                        const unsigned lo = hex4();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    appendUTF8(out, cp);
+                    break;
+                }
+                default: fail("bad escape");
+            }
+        }
+    }
+};
+
+} // namespace
+
+Json Json::parse(std::string_view text) {
+    return Reader(text).document();
+}
+
+// ── Writer ────────────────────────────────────────────────────────────────
+
+static void writeString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+void Json::write(std::string& out) const {
+    switch (type_) {
+        case Type::Null:   out += "null"; break;
+        case Type::Bool:   out += bool_ ? "true" : "false"; break;
+        case Type::Number: {
+            char buf[32];
+            if (std::isfinite(number_) && number_ == std::floor(number_) &&
+                std::fabs(number_) < 9.007199254740992e15)
+                std::snprintf(buf, sizeof buf, "%lld", static_cast<long long>(number_));
+            else
+                std::snprintf(buf, sizeof buf, "%.17g", std::isfinite(number_) ? number_ : 0.0);
+            out += buf;
+            break;
+        }
+        case Type::String: writeString(out, string_); break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < array_.size(); ++i) {
+                if (i) out += ',';
+                array_[i].write(out);
+            }
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < object_.size(); ++i) {
+                if (i) out += ',';
+                writeString(out, object_[i].first);
+                out += ':';
+                object_[i].second.write(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+std::string Json::dump() const {
+    std::string out;
+    write(out);
+    return out;
+}
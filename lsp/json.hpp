@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Just enough JSON for JSON-RPC: a tree value with ordered objects,
+/// a strict parser and a compact writer. Numbers are doubles, which holds
+/// every id and position LSP sends.
+class Json {
+public:
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+    using Member = std::pair<std::string, Json>;
+
+    Json() = default;
+    Json(std::nullptr_t) {}
+    Json(bool b)               : type_(Type::Bool), bool_(b) {}
+    Json(int n)                : type_(Type::Number), number_(n) {}
+    Json(int64_t n)            : type_(Type::Number), number_(static_cast<double>(n)) {}
+    Json(size_t n)             : type_(Type::Number), number_(static_cast<double>(n)) {}
+    Json(double n)             : type_(Type::Number), number_(n) {}
+    Json(const char* s)        : type_(Type::String), string_(s) {}
+    Json(std::string s)        : type_(Type::String), string_(std::move(s)) {}
+    Json(std::string_view s)   : type_(Type::String), string_(s) {}
+
+    /// {"key": value, …} in the order given.
+    static Json object(std::initializer_list<Member> members = {});
+    static Json array(std::vector<Json> items = {});
+
+    /// Throws std::runtime_error on malformed input.
+    static Json parse(std::string_view text);
+    std::string dump() const;
+
+    Type type()     const { return type_; }
+    bool isNull()   const { return type_ == Type::Null; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isString() const { return type_ == Type::String; }
+    bool isArray()  const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    // Lenient accessors: a missing or mistyped value reads as empty / 0
+    bool               asBool()   const { return type_ == Type::Bool && bool_; }
+    double             asNumber() const { return type_ == Type::Number ? number_ : 0; }
+    int64_t            asInt()    const { return static_cast<int64_t>(asNumber()); }
+    const std::string& asString() const;
+    const std::vector<Json>&   items()   const;
+    const std::vector<Member>& members() const;
+
+    /// Member lookup; a null Json when absent or not an object.
+    const Json& operator[](std::string_view key) const;
+    bool        contains(std::string_view key) const;
+
+    /// Insert or overwrite a member (turns a null into an object).
+    Json& set(std::string key, Json value);
+    /// Append an element (turns a null into an array).
+    Json& push(Json value);
+
+private:
+    Type                type_   = Type::Null;
+    bool                bool_   = false;
+    double              number_ = 0;
+    std::string         string_;
+    std::vector<Json>   array_;
+    std::vector<Member> object_;
+
+    void write(std::string& out) const;
+};
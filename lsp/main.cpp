@@ -0,0 +1,159 @@
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "server.hpp"
+
+// ── Transport ─────────────────────────────────────────────────────────────
+// JSON-RPC messages framed by "Content-Length: N\r\n\r\n" headers on stdio.
+// A reader thread blocks on stdin and queues bodies, so the main loop can
+// sleep until either a message arrives or a debounce deadline passes.
+
+class Inbox {
+public:
+    void push(std::string body) {
+        { std::lock_guard<std::mutex> lock(mutex_); queue_.push_back(std::move(body)); }
+        ready_.notify_one();
+    }
+    void close() {
+        { std::lock_guard<std::mutex> lock(mutex_); closed_ = true; }
+        ready_.notify_one();
+    }
+
+    enum class Status { Message, Timeout, Closed };
+
+    /// Wait for a message until `deadline` (forever when nullopt).
+    Status pop(std::string& body, std::optional<LanguageServer::Clock::time_point> deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto ready = [&] { return !queue_.empty() || closed_; };
+        if (deadline) {
+            if (!ready_.wait_until(lock, *deadline, ready)) return Status::Timeout;
+        } else {
+            ready_.wait(lock, ready);
+        }
+        if (queue_.empty()) return Status::Closed;
+        body = std::move(queue_.front());
+        queue_.pop_front();
+        return Status::Message;
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable ready_;
+    std::deque<std::string> queue_;
+    bool                    closed_ = false;
+};
+
+/// One framed body from stdin; false at end of input or on a broken header.
+static bool readMessage(std::string& body) {
+    size_t length = 0;
+    bool   sized  = false;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) break;   // end of headers
+        static constexpr std::string_view HEADER = "Content-Length:";
+        if (line.compare(0, HEADER.size(), HEADER) == 0) {
+            // Parsed without exceptions: a throw here would end the reader thread
+            const char* p   = line.data() + HEADER.size();
+            const char* end = line.data() + line.size();
+            while (p != end && (*p == ' ' || *p == '\t')) ++p;
+            const auto [last, ec] = std::from_chars(p, end, length);
+            if (ec != std::errc() || last != end) return false;
+            sized = true;
+        }
+        // Content-Type is the only other header, and always utf-8
+    }
+    if (!sized) return false;
+    body.resize(length);
+    return static_cast<bool>(std::cin.read(body.data(), static_cast<std::streamsize>(length)));
+}
+
+static void writeMessage(const Json& message) {
+    const std::string body = message.dump();
+    std::fprintf(stdout, "Content-Length: %zu\r\n\r\n", body.size());
+    std::fwrite(body.data(), 1, body.size(), stdout);
+    std::fflush(stdout);
+}
+
+// ── Entry point ───────────────────────────────────────────────────────────
+
+static void printUsage() {
+    std::cerr << "Usage: nanoscript-lsp [--stdio] [--debounce=MS]\n"
+                 "\n"
+                 "  --debounce=MS  Quiet time after an edit before the document\n"
+                 "                 is re-analysed and diagnostics published\n"
+                 "                 (default 150)\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::chrono::milliseconds debounce{150};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--debounce=", 0) == 0) {
+            const std::string val = arg.substr(11);
+            try {
+                size_t    used = 0;
+                const int ms   = std::stoi(val, &used);
+                if (ms < 0 || used != val.size()) throw std::invalid_argument(val);
+                debounce = std::chrono::milliseconds(ms);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid debounce '" << val << "'\n";
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--stdio") {
+            // The only transport; accepted because clients pass it
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+#ifdef _WIN32
+    // Content-Length counts bytes: no CRLF translation on either stream
+    _setmode(_fileno(stdin),  _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::ios::sync_with_stdio(false);
+
+    Inbox       inbox;
+    std::thread reader([&] {
+        std::string body;
+        while (readMessage(body)) inbox.push(std::move(body));
+        inbox.close();
+    });
+    reader.detach();   // may be blocked on stdin when the client says exit
+
+    LanguageServer server(writeMessage, debounce);
+    std::string    body;
+    while (!server.exited()) {
+        const Inbox::Status status = inbox.pop(body, server.nextDeadline());
+        if (status == Inbox::Status::Closed) break;
+        if (status == Inbox::Status::Message) {
+            Json message;
+            try {
+                message = Json::parse(body);
+            } catch (const std::exception& e) {
+                writeMessage(Json::object({
+                    {"jsonrpc", "2.0"}, {"id", nullptr},
+                    {"error", Json::object({{"code", -32700}, {"message", e.what()}})},
+                }));
+                continue;
+            }
+            server.handle(message);
+        }
+        server.analyzeDue();
+    }
+    return server.exitCode();
+}
@@ -0,0 +1,315 @@
+#include "server.hpp"
+
+#include "lexer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// JSON-RPC / LSP constants used below
+static constexpr int ERR_METHOD_NOT_FOUND   = -32601;
+static constexpr int ERR_INVALID_REQUEST    = -32600;
+static constexpr int SEVERITY_ERROR         = 1;
+static constexpr int COMPLETION_FUNCTION    = 3;
+static constexpr int COMPLETION_VARIABLE    = 6;
+static constexpr int COMPLETION_KEYWORD     = 14;
+static constexpr int INSERT_FORMAT_SNIPPET  = 2;
+static constexpr int SYNC_INCREMENTAL       = 2;
+
+// Diagnostics past this are dropped: a generated file with a broken prefix
+// would otherwise flood the client with one per read
+static constexpr size_t MAX_DIAGNOSTICS = 500;
+
+LanguageServer::LanguageServer(std::function<void(const Json&)> send,
+                               std::chrono::milliseconds debounce)
+    : send_(std::move(send)), debounce_(debounce) {}
+
+// ── Protocol ──────────────────────────────────────────────────────────────
+
+void LanguageServer::reply(const Json& id, Json result) {
+    send_(Json::object({{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}}));
+}
+
+void LanguageServer::replyError(const Json& id, int code, const std::string& message) {
+    send_(Json::object({{"jsonrpc", "2.0"}, {"id", id},
+                        {"error", Json::object({{"code", code}, {"message", message}})}}));
+}
+
+void LanguageServer::notify(const std::string& method, Json params) {
+    send_(Json::object({{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}}));
+}
+
+void LanguageServer::handle(const Json& message) {
+    const std::string& method    = message["method"].asString();
+    const bool         isRequest = message.contains("id");
+    const Json&        id        = message["id"];
+    const Json&        params    = message["params"];
+
+    if (method.empty()) {
+        // A response to something we never sent, or garbage
+        if (isRequest && !message.contains("result") && !message.contains("error"))
+            replyError(id, ERR_INVALID_REQUEST, "missing method");
+        return;
+    }
+    if (shutdown_ && method != "exit") {
+        if (isRequest) replyError(id, ERR_INVALID_REQUEST, "server is shutting down");
+        return;
+    }
+
+    if (method == "initialize")                   reply(id, initialize(params));
+    else if (method == "initialized")             {}
+    else if (method == "shutdown")                { shutdown_ = true; reply(id, nullptr); }
+    else if (method == "exit")                    exited_ = true;
+    else if (method == "textDocument/didOpen")    didOpen(params);
+    else if (method == "textDocument/didChange")  didChange(params);
+    else if (method == "textDocument/didClose")   didClose(params);
+    else if (method == "textDocument/completion") reply(id, completion(params));
+    else if (method == "textDocument/definition") reply(id, definition(params));
+    else if (isRequest)
+        replyError(id, ERR_METHOD_NOT_FOUND, "unsupported method '" + method + "'");
+    // Unknown notifications ($/cancelRequest, …) are ignored
+}
+
+Json LanguageServer::initialize(const Json& /*params*/) {
+    Json caps = Json::object({
+        {"textDocumentSync", Json::object({{"openClose", true},
+                                           {"change", SYNC_INCREMENTAL}})},
+        {"completionProvider", Json::object()},
+        {"definitionProvider", true},
+    });
+    return Json::object({
+        {"capabilities", std::move(caps)},
+        {"serverInfo", Json::object({{"name", "nanoscript-lsp"}})},
+    });
+}
+
+// ── Document sync ─────────────────────────────────────────────────────────
+
+LanguageServer::Document* LanguageServer::find(const Json& params) {
+    auto it = docs_.find(params["textDocument"]["uri"].asString());
+    return it == docs_.end() ? nullptr : it->second.get();
+}
+
+void LanguageServer::touch(Document& doc) {
+    doc.dirty    = true;
+    doc.deadline = Clock::now() + debounce_;
+}
+
+void LanguageServer::didOpen(const Json& params) {
+    const Json&        item = params["textDocument"];
+    const std::string& uri  = item["uri"].asString();
+    auto doc     = std::make_unique<Document>(uri);
+    doc->text    = item["text"].asString();
+    doc->version = item["version"].asInt();
+    indexLines(*doc);
+    // Analyse right away: the user is looking at a freshly opened file
+    analyze(uri, *doc);
+    docs_[uri] = std::move(doc);
+}
+
+void LanguageServer::didChange(const Json& params) {
+    Document* doc = find(params);
+    if (!doc) return;
+    for (const Json& change : params["contentChanges"].items()) {
+        if (!change.contains("range")) {
+            doc->text = change["text"].asString();   // full replacement
+        } else {
+            const size_t begin = offsetOf(*doc, change["range"]["start"]);
+            const size_t end   = std::max(begin, offsetOf(*doc, change["range"]["end"]));
+            doc->text.replace(begin, end - begin, change["text"].asString());
+        }
+        indexLines(*doc);
+    }
+    doc->version = params["textDocument"]["version"].asInt();
+    touch(*doc);
+}
+
+void LanguageServer::didClose(const Json& params) {
+    const std::string& uri = params["textDocument"]["uri"].asString();
+    docs_.erase(uri);
+    notify("textDocument/publishDiagnostics",
+           Json::object({{"uri", uri}, {"diagnostics", Json::array()}}));
+}
+
+// ── Analysis ──────────────────────────────────────────────────────────────
+
+void LanguageServer::analyze(const std::string& uri, Document& doc) {
+    doc.dirty = false;
+    Json diagnostics = Json::array();
+    auto diagnostic = [&](int line, int col, int length, const std::string& message) {
+        diagnostics.push(Json::object({
+            {"range",    range(doc, line, col, length)},
+            {"severity", SEVERITY_ERROR},
+            {"source",   "nanoscript"},
+            {"message",  message},
+        }));
+    };
+
+    try {
+        const IncrementalParse::Splice splice = doc.parse.update(doc.text);
+        const ProgramNode&             prog   = *doc.parse.program();
+        doc.index.apply(prog, splice);
+        for (const SymbolIndex::Occurrence& o : doc.index.undefinedReads(prog, MAX_DIAGNOSTICS)) {
+            const std::string_view name = prog.symbols.name(o.id);
+            diagnostic(o.line, o.col, static_cast<int>(name.size()),
+                       std::string(o.fn ? "Undefined function '" : "Undefined variable '") +
+                           std::string(name) + "'");
+        }
+    } catch (const SyntaxError& e) {
+        for (const Diagnostic& d : e.diagnostics)
+            diagnostic(d.line, d.col, 1, d.message);
+    } catch (const std::exception& e) {
+        diagnostic(1, 1, 0, e.what());
+    }
+
+    notify("textDocument/publishDiagnostics",
+           Json::object({{"uri", uri}, {"version", doc.version},
+                         {"diagnostics", std::move(diagnostics)}}));
+}
+
+void LanguageServer::analyzeDue() {
+    const Clock::time_point now = Clock::now();
+    for (auto& [uri, doc] : docs_)
+        if (doc->dirty && doc->deadline <= now)
+            analyze(uri, *doc);
+}
+
+std::optional<LanguageServer::Clock::time_point> LanguageServer::nextDeadline() const {
+    std::optional<Clock::time_point> next;
+    for (const auto& [uri, doc] : docs_)
+        if (doc->dirty && (!next || doc->deadline < *next))
+            next = doc->deadline;
+    return next;
+}
+
+// ── Requests ──────────────────────────────────────────────────────────────
+
+Json LanguageServer::completion(const Json& params) {
+    Json items = Json::array();
+    items.push(Json::object({
+        {"label", "if"}, {"kind", COMPLETION_KEYWORD}, {"detail", "Conditional statement"},
+        {"insertText", "if (${1:condition}) {\n\t$0\n}"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+    items.push(Json::object({
+        {"label", "while"}, {"kind", COMPLETION_KEYWORD}, {"detail", "Loop while a condition holds"},
+        {"insertText", "while (${1:condition}) {\n\t$0\n}"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+    items.push(Json::object({
+        {"label", "for"}, {"kind", COMPLETION_KEYWORD}, {"detail", "Counted loop: init; condition; step"},
+        {"insertText", "for (${1:i} = ${2:0}; ${1:i} < ${3:n}; ${1:i} = ${1:i} + 1) {\n\t$0\n}"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+    items.push(Json::object({
+        {"label", "out"}, {"kind", COMPLETION_KEYWORD},
+        {"detail", "Print int64 to stdout followed by newline"},
+        {"insertText", "out ${1:expr};"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+    items.push(Json::object({
+        {"label", "fn"}, {"kind", COMPLETION_KEYWORD}, {"detail", "Function definition"},
+        {"insertText", "fn ${1:name}(${2:a}) {\n\t$0\n}"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+    items.push(Json::object({
+        {"label", "return"}, {"kind", COMPLETION_KEYWORD},
+        {"detail", "Return an int64 from the function"},
+        {"insertText", "return ${1:expr};"},
+        {"insertTextFormat", INSERT_FORMAT_SNIPPET},
+    }));
+
+    Document* doc = find(params);
+    if (!doc) return items;
+    if (doc->dirty) analyze(params["textDocument"]["uri"].asString(), *doc);
+    // After a parse error this is the index of the last text that parsed
+    if (const ProgramNode* prog = doc->parse.program()) {
+        for (SymbolId id : doc->index.definedSymbols())
+            items.push(Json::object({
+                {"label",  prog->symbols.name(id)},
+                {"kind",   COMPLETION_VARIABLE},
+                {"detail", "int64"},
+            }));
+        for (SymbolId id : doc->index.definedFunctions())
+            items.push(Json::object({
+                {"label",  prog->symbols.name(id)},
+                {"kind",   COMPLETION_FUNCTION},
+                {"detail", "int64 function"},
+            }));
+    }
+    return items;
+}
+
+Json LanguageServer::definition(const Json& params) {
+    Document* doc = find(params);
+    if (!doc) return nullptr;
+    const std::string& uri = params["textDocument"]["uri"].asString();
+    if (doc->dirty) analyze(uri, *doc);
+    const ProgramNode* prog = doc->parse.program();
+    if (!prog || doc->parse.text() != doc->text) return nullptr;   // no AST for this text
+
+    // Byte position → 1-based line / column
+    const size_t offset = offsetOf(*doc, params["position"]);
+    const auto   lineIt = std::upper_bound(doc->lineStarts.begin(), doc->lineStarts.end(),
+                                           static_cast<uint32_t>(offset)) - 1;
+    const int line = static_cast<int>(lineIt - doc->lineStarts.begin()) + 1;
+    const int col  = static_cast<int>(offset - *lineIt) + 1;
+
+    const auto hit = doc->index.at(*prog, line, col);
+    if (!hit) return nullptr;
+    const auto def = doc->index.definition(*prog, *hit);
+    if (!def) return nullptr;
+    const int len = static_cast<int>(prog->symbols.name(def->id).size());
+    return Json::object({{"uri", uri}, {"range", range(*doc, def->line, def->col, len)}});
+}
+
+// ── Positions ─────────────────────────────────────────────────────────────
+// LSP counts characters in UTF-16 code units; the front end counts bytes.
+
+void LanguageServer::indexLines(Document& doc) {
+    doc.lineStarts.assign(1, 0);
+    const char* base = doc.text.data();
+    const char* end  = base + doc.text.size();
+    for (const char* p = base; (p = static_cast<const char*>(
+                                    std::memchr(p, '\n', static_cast<size_t>(end - p))));)
+        doc.lineStarts.push_back(static_cast<uint32_t>(++p - base));
+}
+
+// UTF-16 units a UTF-8 sequence starting with `lead` encodes to
+static int utf16Units(unsigned char lead) { return lead >= 0xF0 ? 2 : 1; }
+static bool isContinuation(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+size_t LanguageServer::offsetOf(const Document& doc, const Json& pos) {
+    const auto line = static_cast<size_t>(std::max<int64_t>(0, pos["line"].asInt()));
+    if (line >= doc.lineStarts.size()) return doc.text.size();
+    size_t       offset = doc.lineStarts[line];
+    const size_t end    = line + 1 < doc.lineStarts.size() ? doc.lineStarts[line + 1]
+                                                            : doc.text.size();
+    for (int64_t units = pos["character"].asInt(); units > 0 && offset < end;) {
+        const auto c = static_cast<unsigned char>(doc.text[offset]);
+        if (c == '\n' || c == '\r') break;
+        units -= utf16Units(c);
+        ++offset;
+        while (offset < end && isContinuation(static_cast<unsigned char>(doc.text[offset])))
+            ++offset;
+    }
+    return offset;
+}
+
+Json LanguageServer::position(const Document& doc, int line, int col) {
+    const auto index = static_cast<size_t>(std::max(line, 1) - 1);
+    if (index >= doc.lineStarts.size())
+        return Json::object({{"line", line - 1}, {"character", 0}});
+    const size_t begin = doc.lineStarts[index];
+    const size_t stop  = std::min(doc.text.size(), begin + static_cast<size_t>(std::max(col, 1) - 1));
+    int units = 0;
+    for (size_t i = begin; i < stop; ++i) {
+        const auto c = static_cast<unsigned char>(doc.text[i]);
+        if (!isContinuation(c)) units += utf16Units(c);
+    }
+    return Json::object({{"line", line - 1}, {"character", units}});
+}
+
+Json LanguageServer::range(const Document& doc, int line, int col, int length) {
+    return Json::object({{"start", position(doc, line, col)},
+                         {"end",   position(doc, line, col + length)}});
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "incremental.hpp"
+#include "json.hpp"
+#include "symbol_index.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// The Language Server Protocol over the real front end: completion,
+/// go-to-definition and diagnostics for open .nano documents.
+///
+/// Edits are applied to the document text as they arrive. Analysis (an
+/// IncrementalParse update plus the SymbolIndex splice) waits until the
+/// document has been quiet for the debounce delay, and is then published
+/// as diagnostics; a request on a document with pending edits analyses it
+/// first, so answers never lag the text.
+class LanguageServer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// `send` writes one JSON-RPC message to the client.
+    LanguageServer(std::function<void(const Json&)> send,
+                   std::chrono::milliseconds debounce);
+
+    /// Dispatch one request or notification from the client.
+    void handle(const Json& message);
+
+    /// Analyse (and publish diagnostics for) every document whose debounce
+    /// delay has passed.
+    void analyzeDue();
+    /// When analyzeDue() next has work; nullopt while nothing is pending.
+    std::optional<Clock::time_point> nextDeadline() const;
+
+    bool exited()   const { return exited_; }
+    int  exitCode() const { return shutdown_ ? 0 : 1; }
+
+private:
+    struct Document {
+        explicit Document(const std::string& uri) : parse(uri) {}
+
+        std::string           text;         // latest contents from the client
+        std::vector<uint32_t> lineStarts;   // byte offset of every line of text
+        int64_t               version = 0;
+        IncrementalParse      parse;        // AST of the last text that parsed
+        SymbolIndex           index;        // ... and its symbols
+        bool                  dirty   = true;
+        Clock::time_point     deadline;
+    };
+
+    // ── Protocol ──────────────────────────────────────────────────────────
+    void reply(const Json& id, Json result);
+    void replyError(const Json& id, int code, const std::string& message);
+    void notify(const std::string& method, Json params);
+
+    Json initialize(const Json& params);
+    void didOpen(const Json& params);
+    void didChange(const Json& params);
+    void didClose(const Json& params);
+    Json completion(const Json& params);
+    Json definition(const Json& params);
+
+    // ── Analysis ──────────────────────────────────────────────────────────
+    Document* find(const Json& params);
+    void      analyze(const std::string& uri, Document& doc);
+    void      touch(Document& doc);
+
+    // ── Positions: LSP (0-based, UTF-16) ↔ front end (1-based, bytes) ─────
+    static void     indexLines(Document& doc);
+    static size_t   offsetOf(const Document& doc, const Json& position);
+    static Json     position(const Document& doc, int line, int col);
+    static Json     range(const Document& doc, int line, int col, int length);
+
+    std::function<void(const Json&)> send_;
+    std::chrono::milliseconds        debounce_;
+    std::unordered_map<std::string, std::unique_ptr<Document>> docs_;
+    bool shutdown_ = false;
+    bool exited_   = false;
+};
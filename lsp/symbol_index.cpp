@@ -0,0 +1,217 @@
+#include "symbol_index.hpp"
+
+#include <algorithm>
+
+// ── Collection ────────────────────────────────────────────────────────────
+// Occurrences are recorded in codegen order: an assignment's target before
+// its value (the slot exists while the value is computed), an if's
+// condition before its body, a loop's init, condition, body, then step,
+// a function's name and parameters before its body.
+
+void SymbolIndex::collectReads(const ExprNode& expr, int base, std::vector<Entry>& out) {
+    switch (expr.kind) {
+        case NodeKind::Variable: {
+            const auto& n = static_cast<const VariableNode&>(expr);
+            out.push_back({n.name, n.line - base, n.col, false, false});
+            break;
+        }
+        case NodeKind::BinaryOp: {
+            const auto& n = static_cast<const BinaryOpNode&>(expr);
+            collectReads(*n.left,  base, out);
+            collectReads(*n.right, base, out);
+            break;
+        }
+        case NodeKind::Index: {
+            const auto& n = static_cast<const IndexNode&>(expr);
+            out.push_back({n.array, n.line - base, n.col, false, false});
+            collectReads(*n.index, base, out);
+            break;
+        }
+        case NodeKind::ArrayLiteral:
+            for (const ExprNode* e : static_cast<const ArrayLiteralNode&>(expr).elements)
+                collectReads(*e, base, out);
+            break;
+        case NodeKind::ArrayRepeat:
+            collectReads(*static_cast<const ArrayRepeatNode&>(expr).value, base, out);
+            break;
+        case NodeKind::Call: {
+            const auto& n = static_cast<const CallNode&>(expr);
+            out.push_back({n.callee, n.line - base, n.col, false, true});
+            for (const ExprNode* e : n.args)
+                collectReads(*e, base, out);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+std::vector<SymbolIndex::Entry> SymbolIndex::collect(const StmtNode& root) {
+    std::vector<Entry> out;
+    const int base = root.line;
+
+    std::vector<const StmtNode*> stack{&root};
+    while (!stack.empty()) {
+        const StmtNode& stmt = *stack.back();
+        stack.pop_back();
+        switch (stmt.kind) {
+            case NodeKind::Assignment: {
+                const auto& n = static_cast<const AssignmentNode&>(stmt);
+                out.push_back({n.varName, n.line - base, n.col, true, false});
+                collectReads(*n.value, base, out);
+                break;
+            }
+            case NodeKind::IndexAssign: {
+                // Stores into an existing array: a use of it, not a definition
+                const auto& n = static_cast<const IndexAssignNode&>(stmt);
+                out.push_back({n.array, n.line - base, n.col, false, false});
+                collectReads(*n.index, base, out);
+                collectReads(*n.value, base, out);
+                break;
+            }
+            case NodeKind::If: {
+                const auto& n = static_cast<const IfNode&>(stmt);
+                collectReads(*n.condition, base, out);
+                for (size_t i = n.body.size; i-- > 0;)   // popped in source order
+                    stack.push_back(n.body.data[i]);
+                break;
+            }
+            case NodeKind::While: {
+                const auto& n = static_cast<const WhileNode&>(stmt);
+                // The init is collected before the condition, not pushed
+                if (n.init) {
+                    const std::vector<Entry> init = collect(*n.init);
+                    for (const Entry& e : init)
+                        out.push_back({e.id, e.dline + n.init->line - base, e.col, e.def, e.fn});
+                }
+                collectReads(*n.condition, base, out);
+                if (n.step) stack.push_back(n.step);
+                for (size_t i = n.body.size; i-- > 0;)
+                    stack.push_back(n.body.data[i]);
+                break;
+            }
+            case NodeKind::Out:
+                collectReads(*static_cast<const OutNode&>(stmt).expr, base, out);
+                break;
+            case NodeKind::Return:
+                collectReads(*static_cast<const ReturnNode&>(stmt).value, base, out);
+                break;
+            case NodeKind::Function: {
+                // Parameters are assigned by the call, before the body runs
+                const auto& n = static_cast<const FunctionNode&>(stmt);
+                out.push_back({n.name, n.nameLine - base, n.nameCol, true, true});
+                for (const VariableNode* p : n.params)
+                    out.push_back({p->name, p->line - base, p->col, true, false});
+                for (size_t i = n.body.size; i-- > 0;)
+                    stack.push_back(n.body.data[i]);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return out;
+}
+
+// ── Maintenance ───────────────────────────────────────────────────────────
+
+void SymbolIndex::apply(const ProgramNode& program, const IncrementalParse::Splice& splice) {
+    if (defCount_.size() < program.symbols.size()) {
+        defCount_.resize(program.symbols.size(), 0);
+        fnCount_.resize(program.symbols.size(), 0);
+    }
+    auto count = [&](const std::vector<Entry>& entries, int delta) {
+        for (const Entry& e : entries)
+            if (e.def) (e.fn ? fnCount_ : defCount_)[e.id] += static_cast<uint32_t>(delta);
+    };
+
+    const auto first = perStatement_.begin() + static_cast<std::ptrdiff_t>(splice.first);
+    const auto last  = first + static_cast<std::ptrdiff_t>(splice.removed);
+    for (auto it = first; it != last; ++it)
+        count(*it, -1);
+    const auto at = perStatement_.erase(first, last);
+
+    std::vector<std::vector<Entry>> fresh;
+    fresh.reserve(splice.inserted);
+    for (size_t i = splice.first; i < splice.first + splice.inserted; ++i) {
+        fresh.push_back(collect(*program.statements[i]));
+        count(fresh.back(), +1);
+    }
+    perStatement_.insert(at, std::make_move_iterator(fresh.begin()),
+                         std::make_move_iterator(fresh.end()));
+    // The reused tail is stored relative to its statements' lines: no-op
+}
+
+// ── Queries ───────────────────────────────────────────────────────────────
+
+static std::vector<SymbolId> nonZero(const std::vector<uint32_t>& counts) {
+    std::vector<SymbolId> ids;
+    for (size_t id = 0; id < counts.size(); ++id)
+        if (counts[id]) ids.push_back(static_cast<SymbolId>(id));
+    return ids;
+}
+
+std::vector<SymbolId> SymbolIndex::definedSymbols() const { return nonZero(defCount_); }
+std::vector<SymbolId> SymbolIndex::definedFunctions() const { return nonZero(fnCount_); }
+
+std::optional<SymbolIndex::Occurrence>
+SymbolIndex::at(const ProgramNode& program, int line, int col) const {
+    // Last statement starting at or before the position
+    const auto& stmts = program.statements;
+    auto it = std::partition_point(stmts.begin(), stmts.end(), [&](const StmtNode* s) {
+        return s->line < line || (s->line == line && s->col <= col);
+    });
+    if (it == stmts.begin()) return std::nullopt;
+    const size_t index = static_cast<size_t>(it - stmts.begin()) - 1;
+    for (const Entry& e : perStatement_[index]) {
+        const Occurrence o   = resolve(program, index, e);
+        const int        len = static_cast<int>(program.symbols.name(e.id).size());
+        if (o.line == line && col >= o.col && col <= o.col + len)
+            return o;
+    }
+    return std::nullopt;
+}
+
+std::optional<SymbolIndex::Occurrence>
+SymbolIndex::definition(const ProgramNode& program, const Occurrence& use) const {
+    const std::vector<uint32_t>& counts = use.fn ? fnCount_ : defCount_;
+    if (use.id >= counts.size() || counts[use.id] == 0) return std::nullopt;
+
+    auto search = [&](size_t i) -> std::optional<Occurrence> {
+        for (const Entry& e : perStatement_[i])
+            if (e.def && e.fn == use.fn && e.id == use.id) return resolve(program, i, e);
+        return std::nullopt;
+    };
+    // A function's variables never leave it
+    if (!use.fn && isFunction(program, use.statement)) return search(use.statement);
+    for (size_t i = 0; i < perStatement_.size(); ++i) {
+        if (!use.fn && isFunction(program, i)) continue;
+        if (auto def = search(i)) return def;
+    }
+    return std::nullopt;
+}
+
+std::vector<SymbolIndex::Occurrence>
+SymbolIndex::undefinedReads(const ProgramNode& program, size_t limit) const {
+    std::vector<Occurrence> out;
+    std::vector<bool>       mainAssigned(program.symbols.size(), false);
+    std::vector<bool>       fnAssigned;
+    for (size_t i = 0; i < perStatement_.size() && out.size() < limit; ++i) {
+        std::vector<bool>* assigned = &mainAssigned;
+        if (isFunction(program, i)) {
+            fnAssigned.assign(program.symbols.size(), false);
+            assigned = &fnAssigned;
+        }
+        for (const Entry& e : perStatement_[i]) {
+            if (out.size() >= limit) break;
+            if (e.fn) {
+                if (!e.def && !fnCount_[e.id]) out.push_back(resolve(program, i, e));
+            } else if (e.def) {
+                (*assigned)[e.id] = true;
+            } else if (!(*assigned)[e.id]) {
+                out.push_back(resolve(program, i, e));
+            }
+        }
+    }
+    return out;
+}
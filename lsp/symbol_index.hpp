@@ -0,0 +1,75 @@
+#pragma once
+#include "ast.hpp"
+#include "incremental.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// Where every variable is assigned and read, and every function defined
+/// and called, kept per top-level statement
+/// and updated from IncrementalParse splices, so an edit only re-indexes
+/// the statements it re-parsed. Positions inside a statement are stored
+/// relative to its first line, which is exactly what a splice leaves
+/// untouched in the reused tail. A function's variables are its own: they
+/// resolve within its definition, main's within the other statements.
+class SymbolIndex {
+public:
+    /// One identifier in the source (1-based line, byte column).
+    struct Occurrence {
+        SymbolId id;
+        int      line;
+        int      col;
+        bool     def;         // assignment target or definition, else a read
+        bool     fn;          // a function's name, else a variable's
+        size_t   statement;   // the top-level statement it is in
+    };
+
+    /// Mirror `splice` (just applied to `program`) in the index.
+    void apply(const ProgramNode& program, const IncrementalParse::Splice& splice);
+
+    /// Variables assigned anywhere in the program.
+    std::vector<SymbolId> definedSymbols() const;
+
+    /// Functions defined in the program.
+    std::vector<SymbolId> definedFunctions() const;
+
+    /// The identifier covering `line`/`col`, if any.
+    std::optional<Occurrence> at(const ProgramNode& program, int line, int col) const;
+
+    /// What `use` names: a function's definition, or the first assignment
+    /// to the variable in its scope, in source order — where the compiler
+    /// creates it.
+    std::optional<Occurrence> definition(const ProgramNode& program, const Occurrence& use) const;
+
+    /// Reads preceded by no assignment to the same variable in its scope,
+    /// and calls of functions defined nowhere: what the compiler reports as
+    /// "Undefined variable" and "Undefined function". At most `limit` are
+    /// returned.
+    std::vector<Occurrence> undefinedReads(const ProgramNode& program, size_t limit) const;
+
+private:
+    struct Entry {
+        SymbolId id;
+        int      dline;   // line relative to the statement's
+        int      col;
+        bool     def;
+        bool     fn;
+    };
+
+    static std::vector<Entry> collect(const StmtNode& stmt);
+    static void               collectReads(const ExprNode& expr, int base,
+                                           std::vector<Entry>& out);
+    static Occurrence         resolve(const ProgramNode& program, size_t statement,
+                                      const Entry& e) {
+        return {e.id, program.statements[statement]->line + e.dline, e.col, e.def, e.fn,
+                statement};
+    }
+    static bool isFunction(const ProgramNode& program, size_t statement) {
+        return program.statements[statement]->kind == NodeKind::Function;
+    }
+
+    std::vector<std::vector<Entry>> perStatement_;   // parallel to statements
+    std::vector<uint32_t>           defCount_;       // SymbolId → assignments
+    std::vector<uint32_t>           fnCount_;        // SymbolId → function definitions
+};
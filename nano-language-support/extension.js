@@ -11,25 +11,50 @@ const KEYWORD_COMPLETIONS = [
         // Expands to a full if-block with tab stops
         insertText: new vscode.SnippetString('if (${1:condition}) {\n\t$0\n}'),
     },
+    {
+        label:      'while',
+        kind:       vscode.CompletionItemKind.Keyword,
+        detail:     'Loop while a condition holds',
+        insertText: new vscode.SnippetString('while (${1:condition}) {\n\t$0\n}'),
+    },
+    {
+        label:      'for',
+        kind:       vscode.CompletionItemKind.Keyword,
+        detail:     'Counted loop: init; condition; step',
+        insertText: new vscode.SnippetString(
+            'for (${1:i} = ${2:0}; ${1:i} < ${3:n}; ${1:i} = ${1:i} + 1) {\n\t$0\n}'),
+    },
     {
         label:      'out',
         kind:       vscode.CompletionItemKind.Keyword,
         detail:     'Print int64 to stdout followed by newline',
         insertText: new vscode.SnippetString('out ${1:expr};'),
     },
+    {
+        label:      'fn',
+        kind:       vscode.CompletionItemKind.Keyword,
+        detail:     'Function definition',
+        insertText: new vscode.SnippetString('fn ${1:name}(${2:a}) {\n\t$0\n}'),
+    },
+    {
+        label:      'return',
+        kind:       vscode.CompletionItemKind.Keyword,
+        detail:     'Return an int64 from the function',
+        insertText: new vscode.SnippetString('return ${1:expr};'),
+    },
 ];
 
-// ── Dynamic variable completions ───────────────────────────────────────────
-// Scans the document for every left-hand side of an assignment ( name = )
+// ── Dynamic variable completions (fallback) ────────────────────────────────
+// Used only when the language server is unavailable. Scans the document for every left-hand side of an assignment ( name = )
 // and surfaces them as Variable completions.
 
 function variablesInDocument(document) {
     const seen   = new Set();
     const items  = [];
     const text   = document.getText();
-    // Match: optional whitespace, identifier, optional whitespace, '='
+    // Match: line start or 'for (', identifier, optional whitespace, '='
     // Negative lookahead on '=' prevents matching '=='
-    const re = /^\s*([a-zA-Z_][a-zA-Z0-9_]*)\s*=(?!=)/gm;
+    const re = /(?:^\s*|\bfor\s*\(\s*)([a-zA-Z_][a-zA-Z0-9_]*)\s*=(?!=)/gm;
     let m;
     while ((m = re.exec(text)) !== null) {
         const name = m[1];
@@ -45,9 +70,54 @@ function variablesInDocument(document) {
     return items;
 }
 
-// ── Extension lifecycle ────────────────────────────────────────────────────
+// Every `fn name` in the document, as Function completions.
+function functionsInDocument(document) {
+    const seen  = new Set();
+    const items = [];
+    const re    = /\bfn\s+([a-zA-Z_][a-zA-Z0-9_]*)/g;
+    let m;
+    while ((m = re.exec(document.getText())) !== null) {
+        const name = m[1];
+        if (!seen.has(name)) {
+            seen.add(name);
+            const item  = new vscode.CompletionItem(name, vscode.CompletionItemKind.Function);
+            item.detail = 'int64 function';
+            items.push(item);
+        }
+    }
+    return items;
+}
 
-function activate(context) {
+// ── Language server ────────────────────────────────────────────────────────
+// nanoscript-lsp (built next to the compiler) parses with the real front end
+// and serves completion, go-to-definition and diagnostics. Without the
+// client module or the server binary the regex provider below stands in.
+
+let client = null;
+
+function startLanguageServer(context) {
+    let lc;
+    try {
+        lc = require('vscode-languageclient/node');
+    } catch (e) {
+        return Promise.resolve(false);   // `npm install` has not been run
+    }
+    const config  = vscode.workspace.getConfiguration('nanoscript');
+    const command = config.get('lsp.path') || 'nanoscript-lsp';
+    const args    = ['--stdio', `--debounce=${config.get('lsp.debounceMs')}`];
+    const server  = { command, args, transport: lc.TransportKind.stdio };
+
+    client = new lc.LanguageClient(
+        'nanoscript', 'NanoScript Language Server',
+        { run: server, debug: server },
+        { documentSelector: [{ scheme: 'file', language: 'nanoscript' },
+                             { scheme: 'untitled', language: 'nanoscript' }] });
+    return client.start().then(
+        () => { context.subscriptions.push(client); return true; },
+        () => { client = null; return false; });
+}
+
+function registerFallbackProvider(context) {
     const provider = vscode.languages.registerCompletionItemProvider(
         'nanoscript',
         {
@@ -60,7 +130,8 @@ function activate(context) {
                     return item;
                 });
 
-                return [...keywords, ...variablesInDocument(document)];
+                return [...keywords, ...variablesInDocument(document),
+                        ...functionsInDocument(document)];
             }
         }
         // No trigger characters — completions fire on the default Ctrl+Space / typing
@@ -69,6 +140,16 @@ function activate(context) {
     context.subscriptions.push(provider);
 }
 
-function deactivate() {}
+// ── Extension lifecycle ────────────────────────────────────────────────────
+
+function activate(context) {
+    return startLanguageServer(context).then(started => {
+        if (!started) registerFallbackProvider(context);
+    });
+}
+
+function deactivate() {
+    return client ? client.stop() : undefined;
+}
 
 module.exports = { activate, deactivate };
@@ -0,0 +1,185 @@
+#include "nano_rt.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define nano_write(fd, p, n) _write((fd), (p), (unsigned)(n))
+#else
+#include <unistd.h>  /* wasi-libc provides write() on fd 1 as well */
+#define nano_write(fd, p, n) write((fd), (p), (n))
+#endif
+
+/* Longest line: "-9223372036854775808\n" */
+#define NANO_MAX_LINE 21
+#define NANO_OUT_BUFFER_SIZE (256 * 1024)
+
+static char   out_buf[NANO_OUT_BUFFER_SIZE];
+static size_t out_len;
+static int    flush_registered;
+
+/* "00" "01" ... "99": two digits per division */
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+void nano_flush(void) {
+    size_t off = 0;
+    while (off < out_len) {
+        long n = (long)nano_write(1, out_buf + off, out_len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;   /* stdout closed — drop the rest, as stdio would */
+        off += (size_t)n;
+    }
+    out_len = 0;
+}
+
+/* Decimal digits of `v` (with '-'), written to end just before `end`. */
+static char* format_i64(char* end, int64_t v) {
+    char*    p = end;
+    uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    while (u >= 100) {
+        const unsigned d = (unsigned)(u % 100) * 2;
+        u /= 100;
+        *--p = DIGIT_PAIRS[d + 1];
+        *--p = DIGIT_PAIRS[d];
+    }
+    if (u >= 10) {
+        const unsigned d = (unsigned)u * 2;
+        *--p = DIGIT_PAIRS[d + 1];
+        *--p = DIGIT_PAIRS[d];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    if (v < 0) *--p = '-';
+    return p;
+}
+
+void nano_out_i64(int64_t v) {
+    if (!flush_registered) {
+        flush_registered = 1;
+        atexit(nano_flush);
+    }
+    if (out_len > sizeof out_buf - NANO_MAX_LINE)
+        nano_flush();
+
+    /* Digits are produced right to left into a scratch buffer */
+    char  tmp[NANO_MAX_LINE];
+    char* end = tmp + sizeof tmp;
+    char* p   = format_i64(end, v);
+
+    char* out = out_buf + out_len;
+    while (p < end) *out++ = *p++;
+    *out++ = '\n';
+    out_len = (size_t)(out - out_buf);
+}
+
+void nano_out_i64s(const int64_t* v, int64_t n) {
+    for (int64_t i = 0; i < n; ++i)
+        nano_out_i64(v[i]);
+}
+
+/* Append `s` to the message being built at `*p` */
+static void append(char** p, const char* s, const char* end) {
+    while (*s && *p < end) *(*p)++ = *s++;
+}
+
+void nano_index_error(int64_t index, int64_t length, int32_t line) {
+    char  msg[128];
+    char* p   = msg;
+    char* end = msg + sizeof msg;
+    char  num[NANO_MAX_LINE + 1];
+    num[NANO_MAX_LINE] = '\0';
+
+    append(&p, "Error: Index ", end);
+    append(&p, format_i64(num + NANO_MAX_LINE, index), end);
+    append(&p, " out of range for int64[", end);
+    append(&p, format_i64(num + NANO_MAX_LINE, length), end);
+    append(&p, "] at line ", end);
+    append(&p, format_i64(num + NANO_MAX_LINE, line), end);
+    append(&p, "\n", end);
+
+    /* What ran before the fault is printed first, as in the interpreter */
+    nano_flush();
+    nano_write(2, msg, (size_t)(p - msg));
+    exit(1);
+}
+
+void nano_arith_error(int32_t kind, int32_t line) {
+    char  msg[64];
+    char* p   = msg;
+    char* end = msg + sizeof msg;
+    char  num[NANO_MAX_LINE + 1];
+    num[NANO_MAX_LINE] = '\0';
+
+    append(&p, kind == NANO_DIVISION_BY_ZERO ? "Error: Division by zero at line "
+                                             : "Error: Integer overflow at line ", end);
+    append(&p, format_i64(num + NANO_MAX_LINE, line), end);
+    append(&p, "\n", end);
+
+    nano_flush();
+    nano_write(2, msg, (size_t)(p - msg));
+    exit(1);
+}
+
+/* --instrument=lines. The table lives in the program (or the JIT's
+ * memory), so the counts are written before it goes away. */
+
+static const nano_line_table* line_table;
+static int                    lines_registered;
+
+void nano_lines_register(const nano_line_table* table) {
+    line_table = table;
+    if (!lines_registered) {
+        lines_registered = 1;
+        atexit(nano_lines_dump);
+    }
+}
+
+/* qsort has no context argument */
+static const int64_t* sort_hits;
+
+static int hotter(const void* a, const void* b) {
+    const int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    if (sort_hits[x] != sort_hits[y]) return sort_hits[x] < sort_hits[y] ? 1 : -1;
+    return x < y ? -1 : x > y;   /* source order among equals */
+}
+
+void nano_lines_dump(void) {
+    const nano_line_table* t = line_table;
+    line_table = NULL;
+    if (!t || t->count == 0) return;
+
+    const char** label = malloc((size_t)t->count * sizeof *label);
+    int64_t*     order = malloc((size_t)t->count * sizeof *order);
+    if (!label || !order) {
+        free(label);
+        free(order);
+        return;
+    }
+    const char* s = t->labels;
+    for (int64_t i = 0; i < t->count; ++i) {
+        label[i] = s;
+        while (*s) ++s;
+        ++s;
+        order[i] = i;
+    }
+    sort_hits = t->hits;
+    qsort(order, (size_t)t->count, sizeof *order, hotter);
+
+    const char* path = getenv("NANO_LINES_FILE");
+    if (!path || !*path) path = "nano-lines.folded";
+    FILE* f = fopen(path, "w");
+    if (f) {
+        for (int64_t i = 0; i < t->count && t->hits[order[i]] > 0; ++i)
+            fprintf(f, "%s %lld\n", label[order[i]], (long long)t->hits[order[i]]);
+        fclose(f);
+    } else {
+        fprintf(stderr, "Warning: cannot write line counts to %s\n", path);
+    }
+    free(label);
+    free(order);
+}
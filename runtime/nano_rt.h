@@ -0,0 +1,59 @@
+#pragma once
+/* NanoScript runtime — linked into every compiled program, the JIT host
+ * and the interpreter, so all three produce identical bytes. */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Append `v` in decimal plus '\n' to the output buffer — the same bytes as
+ * printf("%lld\n", v). The buffer is flushed when full and at exit. */
+void nano_out_i64(int64_t v);
+
+/* nano_out_i64 for each of v[0..n), in order. */
+void nano_out_i64s(const int64_t* v, int64_t n);
+
+/* Out-of-range array index: flush the output, then print
+ * "Error: Index <index> out of range for int64[<length>] at line <line>"
+ * to stderr and exit(1) — the interpreter's message for the same fault. */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noreturn, cold))
+#endif
+void nano_index_error(int64_t index, int64_t length, int32_t line);
+
+/* nano_arith_error kinds */
+enum { NANO_DIVISION_BY_ZERO = 0, NANO_OVERFLOW = 1 };
+
+/* Arithmetic fault under --arith: flush the output, then print
+ * "Error: Division by zero at line <line>" or
+ * "Error: Integer overflow at line <line>" to stderr and exit(1). */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noreturn, cold))
+#endif
+void nano_arith_error(int32_t kind, int32_t line);
+
+/* Write out everything buffered so far. */
+void nano_flush(void);
+
+/* --instrument=lines: hits[i] counts executions of the statement whose
+ * "function;file:line:col" is the i-th NUL-terminated string in labels. */
+typedef struct nano_line_table {
+    int64_t     count;
+    int64_t*    hits;
+    const char* labels;
+} nano_line_table;
+
+/* Called first thing in an instrumented main: nano_lines_dump() runs at
+ * exit, error exits included. */
+void nano_lines_register(const nano_line_table* table);
+
+/* Write "<label> <hits>" per executed statement, hottest first — the folded
+ * stacks flamegraph.pl reads — to $NANO_LINES_FILE (default
+ * nano-lines.folded). Only the first call after nano_lines_register()
+ * writes. */
+void nano_lines_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ── Bump allocator ────────────────────────────────────────────────────────
+// Objects are carved sequentially out of large blocks and never freed one
+// by one: the whole arena is released at once when it is destroyed. Only
+// trivially destructible types may live here — no destructor ever runs.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        auto p = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(align - 1);
+        if (p + size > reinterpret_cast<uintptr_t>(end_)) {
+            grow(size + align);
+            p = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(align - 1);
+        }
+        cur_ = reinterpret_cast<char*>(p + size);
+        return reinterpret_cast<void*>(p);
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// Copy `n` trivially copyable elements into the arena.
+    template <typename T>
+    T* copyArray(const T* src, size_t n) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (n == 0) return nullptr;
+        auto* dst = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+        std::memcpy(dst, src, sizeof(T) * n);
+        return dst;
+    }
+
+    std::string_view copyString(std::string_view s) {
+        return {copyArray(s.data(), s.size()), s.size()};
+    }
+
+    /// Bytes handed out so far (excluding block slack).
+    size_t bytesUsed() const { return used_ + static_cast<size_t>(cur_ - begin_); }
+
+    /// The arena's fill level, for rewind().
+    struct Mark {
+        size_t blocks;
+        char*  begin;
+        char*  cur;
+        char*  end;
+        size_t used;
+    };
+    Mark mark() const { return {blocks_.size(), begin_, cur_, end_, used_}; }
+
+    /// Release everything allocated since `m`, which must be the latest
+    /// mark still in use: nothing made after it may be touched again.
+    void rewind(const Mark& m) {
+        blocks_.resize(m.blocks);
+        begin_ = m.begin;
+        cur_   = m.cur;
+        end_   = m.end;
+        used_  = m.used;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    void grow(size_t minSize) {
+        used_ += static_cast<size_t>(cur_ - begin_);
+        const size_t size = std::max(BLOCK_SIZE, minSize);
+        blocks_.push_back(std::make_unique<char[]>(size));
+        begin_ = cur_ = blocks_.back().get();
+        end_   = begin_ + size;
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char*  begin_ = nullptr;
+    char*  cur_   = nullptr;
+    char*  end_   = nullptr;
+    size_t used_  = 0;
+};
+
+// ── Arena-backed array of node pointers ───────────────────────────────────
+template <typename T>
+struct NodeList {
+    T* const* data = nullptr;
+    uint32_t  size = 0;
+
+    NodeList() = default;
+    NodeList(Arena& arena, T* const* items, size_t n)
+        : data(arena.copyArray(items, n)), size(static_cast<uint32_t>(n)) {}
+
+    T* const* begin() const { return data; }
+    T* const* end()   const { return data + size; }
+    bool      empty() const { return size == 0; }
+};
+
+// ── Identifier interning ──────────────────────────────────────────────────
+// Every distinct identifier is stored once (in the arena) and referred to
+// by a dense integer ID, so later stages can index plain arrays by name.
+using SymbolId = uint32_t;
+
+class SymbolTable {
+public:
+    explicit SymbolTable(Arena& arena) : arena_(arena) {}
+
+    SymbolId intern(std::string_view name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+        const auto id = static_cast<SymbolId>(names_.size());
+        const std::string_view owned = arena_.copyString(name);
+        names_.push_back(owned);
+        ids_.emplace(owned, id);
+        return id;
+    }
+
+    std::string_view name(SymbolId id) const { return names_[id]; }
+    size_t           size()            const { return names_.size(); }
+
+private:
+    Arena&                                         arena_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+    std::vector<std::string_view>                  names_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+/// What +, -, * and / do when the exact result does not fit in an int64
+/// (--arith). Division by zero is a runtime error in every mode.
+enum class ArithMode : uint8_t {
+    Wrap,       // two's complement, as unsigned arithmetic  [default]
+    Trap,       // a runtime error: "Integer overflow at line N"
+    Saturate,   // clamped to INT64_MIN / INT64_MAX
+};
+
+/// "wrap" / "trap" / "saturate", as --arith spells them.
+inline bool parseArithMode(std::string_view name, ArithMode& mode) {
+    if      (name == "wrap")     mode = ArithMode::Wrap;
+    else if (name == "trap")     mode = ArithMode::Trap;
+    else if (name == "saturate") mode = ArithMode::Saturate;
+    else return false;
+    return true;
+}
+
+// ── Checked int64 arithmetic ──────────────────────────────────────────────
+// Each stores the wrapped result in `out` and returns true when the exact
+// one does not fit — what llvm.s{add,sub,mul}.with.overflow compute. The
+// folder and the interpreter share them, so both agree with the IR.
+
+inline bool addOverflow(int64_t a, int64_t b, int64_t& out) {
+    out = static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+    return ((a ^ out) & (b ^ out)) < 0;   // both operands' sign lost
+}
+
+inline bool subOverflow(int64_t a, int64_t b, int64_t& out) {
+    out = static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+    return ((a ^ b) & (a ^ out)) < 0;     // signs differ and a's was lost
+}
+
+inline bool mulOverflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, &out);
+#else
+    out = static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+    return (a == -1 && b == std::numeric_limits<int64_t>::min()) ||
+           (a != 0 && out / a != b);
+#endif
+}
+
+/// `b` must not be 0. Only INT64_MIN / -1 overflows (to INT64_MIN).
+inline bool divOverflow(int64_t a, int64_t b, int64_t& out) {
+    if (a == std::numeric_limits<int64_t>::min() && b == -1) {
+        out = a;
+        return true;
+    }
+    out = a / b;
+    return false;
+}
+
+/// The bound an overflowed result saturates to.
+inline int64_t saturated(bool negative) {
+    return negative ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+}
@@ -1,32 +1,66 @@
 #pragma once
+#include "arena.hpp"
+
 #include <cstdint>
 #include <memory>
-#include <string>
+#include <string_view>
 #include <vector>
 
+// Every node lives in the owning ProgramNode's arena and is trivially
+// destructible: the tree is torn down in one shot with the arena, and
+// children are plain pointers. Identifiers are interned SymbolIds — names
+// are copied into the arena, so the tree does not borrow the source buffer.
+
 // ── Node kind tag — avoids dynamic_cast / RTTI dependency on LLVM ─────────
-enum class NodeKind {
+enum class NodeKind : uint8_t {
     IntLiteral,
     Variable,
     BinaryOp,
+    Index,
+    ArrayLiteral,
+    ArrayRepeat,
+    Call,
     Assignment,
+    IndexAssign,
     If,
+    While,
     Out,
+    Return,
+    Function,
     Program,
 };
 
+// ── Binary operators ──────────────────────────────────────────────────────
+enum class BinOp : uint8_t {
+    Add, Sub, Mul, Div,          // arithmetic
+    Eq, Ne, Lt, Gt, Le, Ge,      // comparisons (yield 0 / 1)
+};
+
+/// Source spelling, for diagnostics and dumps.
+constexpr std::string_view binOpSpelling(BinOp op) {
+    constexpr std::string_view table[] = {
+        "+", "-", "*", "/", "==", "!=", "<", ">", "<=", ">=",
+    };
+    return table[static_cast<uint8_t>(op)];
+}
+
+constexpr bool isComparison(BinOp op) { return op >= BinOp::Eq; }
+
 // ── Base ──────────────────────────────────────────────────────────────────
 struct ASTNode {
     NodeKind kind;
     int      line = 0;
     int      col  = 0;
-    virtual ~ASTNode() = default;
 protected:
     explicit ASTNode(NodeKind k) : kind(k) {}
 };
 
 // ── Expression nodes ──────────────────────────────────────────────────────
+// Every expression is an int64 or a fixed-size int64 array; checkTypes()
+// records which. Operators on arrays apply element-wise, and a scalar
+// operand is broadcast to every element.
 struct ExprNode : ASTNode {
+    uint32_t length = 0;   // 0: int64; N: int64[N] (set by checkTypes)
 protected:
     explicit ExprNode(NodeKind k) : ASTNode(k) {}
 };
@@ -38,24 +72,59 @@ struct IntLiteralNode : ExprNode {
 };
 
 struct VariableNode : ExprNode {
-    std::string name;
-    VariableNode(std::string n, int ln, int cl)
-        : ExprNode(NodeKind::Variable), name(std::move(n)) { line = ln; col = cl; }
+    SymbolId name;
+    VariableNode(SymbolId n, int ln, int cl)
+        : ExprNode(NodeKind::Variable), name(n) { line = ln; col = cl; }
 };
 
 struct BinaryOpNode : ExprNode {
-    std::string                opStr; // "+", "-", "*", "/", "==", "!=", "<", "<=", ">", ">="
-    std::unique_ptr<ExprNode>  left;
-    std::unique_ptr<ExprNode>  right;
-    BinaryOpNode(std::string op,
-                 std::unique_ptr<ExprNode> l,
-                 std::unique_ptr<ExprNode> r,
-                 int ln, int cl)
-        : ExprNode(NodeKind::BinaryOp),
-          opStr(std::move(op)), left(std::move(l)), right(std::move(r))
+    BinOp     op;
+    ExprNode* left;
+    ExprNode* right;
+    BinaryOpNode(BinOp o, ExprNode* l, ExprNode* r, int ln, int cl)
+        : ExprNode(NodeKind::BinaryOp), op(o), left(l), right(r)
     { line = ln; col = cl; }
 };
 
+/// `a[i]`: one element of array variable `a`.
+struct IndexNode : ExprNode {
+    SymbolId  array;
+    ExprNode* index;
+    IndexNode(SymbolId a, ExprNode* i, int ln, int cl)
+        : ExprNode(NodeKind::Index), array(a), index(i) { line = ln; col = cl; }
+};
+
+/// `[e1, e2, …]` — only as the whole right-hand side of an assignment.
+struct ArrayLiteralNode : ExprNode {
+    NodeList<ExprNode> elements;
+    ArrayLiteralNode(NodeList<ExprNode> e, int ln, int cl)
+        : ExprNode(NodeKind::ArrayLiteral), elements(e) { line = ln; col = cl; }
+};
+
+/// Longest array: 128 MiB of elements.
+constexpr uint32_t MAX_ARRAY_LENGTH = 1u << 24;
+
+/// `[value; count]`: `count` copies of the scalar `value`.
+struct ArrayRepeatNode : ExprNode {
+    ExprNode* value;
+    uint32_t  count;
+    ArrayRepeatNode(ExprNode* v, uint32_t n, int ln, int cl)
+        : ExprNode(NodeKind::ArrayRepeat), value(v), count(n) { line = ln; col = cl; }
+};
+
+/// Index of a function definition among the program's (see FunctionNode).
+constexpr uint32_t NO_FUNCTION = UINT32_MAX;
+
+/// `f(a, b)`: calls user function `callee` with int64 arguments; its value
+/// is the int64 the function returns.
+struct CallNode : ExprNode {
+    SymbolId           callee;
+    NodeList<ExprNode> args;
+    uint32_t           function = NO_FUNCTION;   // the definition called (set by checkTypes)
+    CallNode(SymbolId f, NodeList<ExprNode> a, int ln, int cl)
+        : ExprNode(NodeKind::Call), callee(f), args(a) { line = ln; col = cl; }
+};
+
 // ── Statement nodes ───────────────────────────────────────────────────────
 struct StmtNode : ASTNode {
 protected:
@@ -63,32 +132,98 @@ protected:
 };
 
 struct AssignmentNode : StmtNode {
-    std::string               varName;
-    std::unique_ptr<ExprNode> value;
-    AssignmentNode(std::string n, std::unique_ptr<ExprNode> v, int ln, int cl)
-        : StmtNode(NodeKind::Assignment), varName(std::move(n)), value(std::move(v))
+    SymbolId  varName;
+    ExprNode* value;
+    AssignmentNode(SymbolId n, ExprNode* v, int ln, int cl)
+        : StmtNode(NodeKind::Assignment), varName(n), value(v)
+    { line = ln; col = cl; }
+};
+
+/// `a[i] = value;` — stores one element of an existing array.
+struct IndexAssignNode : StmtNode {
+    SymbolId  array;
+    ExprNode* index;
+    ExprNode* value;
+    IndexAssignNode(SymbolId a, ExprNode* i, ExprNode* v, int ln, int cl)
+        : StmtNode(NodeKind::IndexAssign), array(a), index(i), value(v)
     { line = ln; col = cl; }
 };
 
 struct IfNode : StmtNode {
-    std::unique_ptr<ExprNode>              condition;
-    std::vector<std::unique_ptr<StmtNode>> body;
-    IfNode(std::unique_ptr<ExprNode> cond,
-           std::vector<std::unique_ptr<StmtNode>> b,
-           int ln, int cl)
-        : StmtNode(NodeKind::If), condition(std::move(cond)), body(std::move(b))
+    ExprNode*          condition;
+    NodeList<StmtNode> body;
+    IfNode(ExprNode* cond, NodeList<StmtNode> b, int ln, int cl)
+        : StmtNode(NodeKind::If), condition(cond), body(b)
+    { line = ln; col = cl; }
+};
+
+/// `while (cond) { body }`, and `for (init; cond; step) { body }` with the
+/// optional init run once before the first test and the optional step at
+/// the end of every iteration. Both are (index) assignments.
+struct WhileNode : StmtNode {
+    StmtNode*          init;        // nullptr for while, or for (; …)
+    ExprNode*          condition;
+    StmtNode*          step;        // nullptr for while, or for (…; )
+    NodeList<StmtNode> body;
+    WhileNode(StmtNode* i, ExprNode* cond, StmtNode* st, NodeList<StmtNode> b, int ln, int cl)
+        : StmtNode(NodeKind::While), init(i), condition(cond), step(st), body(b)
     { line = ln; col = cl; }
 };
 
 struct OutNode : StmtNode {
-    std::unique_ptr<ExprNode> expr;
-    OutNode(std::unique_ptr<ExprNode> e, int ln, int cl)
-        : StmtNode(NodeKind::Out), expr(std::move(e))
+    ExprNode* expr;
+    OutNode(ExprNode* e, int ln, int cl)
+        : StmtNode(NodeKind::Out), expr(e)
     { line = ln; col = cl; }
 };
 
+/// `return value;` — only inside a function body.
+struct ReturnNode : StmtNode {
+    ExprNode* value;
+    ReturnNode(ExprNode* v, int ln, int cl)
+        : StmtNode(NodeKind::Return), value(v) { line = ln; col = cl; }
+};
+
+enum class InlineHint : uint8_t { None, Inline, NoInline };
+
+/// `[inline | noinline] fn name(a, b) { body }`, a top-level statement that
+/// runs nothing where it stands. Parameters are int64s and so is the
+/// result; a body that ends without `return` returns 0. A function sees
+/// only its parameters and its own variables, and may call any function
+/// defined anywhere in the file, itself included.
+struct FunctionNode : StmtNode {
+    SymbolId               name;
+    NodeList<VariableNode> params;
+    NodeList<StmtNode>     body;
+    InlineHint             hint;
+    int                    nameLine, nameCol;   // line/col: the first keyword
+    uint32_t               index = 0;   // source order among functions (set by checkTypes)
+    FunctionNode(SymbolId n, NodeList<VariableNode> p, NodeList<StmtNode> b, InlineHint h,
+                 int nl, int nc, int ln, int cl)
+        : StmtNode(NodeKind::Function), name(n), params(p), body(b), hint(h),
+          nameLine(nl), nameCol(nc)
+    { line = ln; col = cl; }
+};
+
+// ── Source extent of a top-level statement ────────────────────────────────
+// Byte offsets [begin, end) from its first to past its last token, plus the
+// line/col at `end` so a lexer can resume right after it.
+struct StmtSpan {
+    uint32_t begin   = 0;
+    uint32_t end     = 0;
+    int      endLine = 1;
+    int      endCol  = 1;
+};
+
 // ── Program root ──────────────────────────────────────────────────────────
+// Owns the arena every other node is allocated from, and the symbol table.
+// Names have an arena of their own, so streaming codegen can rewind `arena`
+// past a lowered statement and keep the identifiers it introduced.
 struct ProgramNode : ASTNode {
-    std::vector<std::unique_ptr<StmtNode>> statements;
+    Arena                  arena;
+    Arena                  names;
+    SymbolTable            symbols{names};
+    std::vector<StmtNode*> statements;   // function definitions among them
+    std::vector<StmtSpan>  spans;        // parallel to statements
     ProgramNode() : ASTNode(NodeKind::Program) {}
 };
@@ -0,0 +1,236 @@
+#include "cache.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/BLAKE3.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Process.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr const char* ENTRY_EXT     = ".art";
+static constexpr const char* COMPANION_EXT = ".o";
+
+ArtifactCache::ArtifactCache(std::string dir, uint64_t maxBytes)
+    : dir_(std::move(dir)), maxBytes_(maxBytes) {}
+
+std::string ArtifactCache::defaultDir() {
+    if (const char* d = std::getenv("NANOSCRIPT_CACHE_DIR"); d && *d)
+        return d;
+    if (const char* x = std::getenv("XDG_CACHE_HOME"); x && *x)
+        return (fs::path(x) / "nanoscript").string();
+#ifdef _WIN32
+    if (const char* l = std::getenv("LOCALAPPDATA"); l && *l)
+        return (fs::path(l) / "nanoscript" / "cache").string();
+#endif
+    if (const char* h = std::getenv("HOME"); h && *h)
+        return (fs::path(h) / ".cache" / "nanoscript").string();
+    return (fs::temp_directory_path() / "nanoscript-cache").string();
+}
+
+std::string ArtifactCache::hashKey(std::string_view header, std::string_view content) {
+    llvm::BLAKE3 hasher;
+    hasher.update(llvm::StringRef(header));
+    hasher.update(llvm::StringRef(content));
+    return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+std::string ArtifactCache::entryPath(const std::string& key) const {
+    // Two-level fan-out keeps directories small at tens of thousands of entries
+    return (fs::path(dir_) / key.substr(0, 2) / (key + ENTRY_EXT)).string();
+}
+
+// ── Lookup / insert ───────────────────────────────────────────────────────
+
+bool ArtifactCache::fetch(const std::string& key, const std::string& output) {
+    const std::string entry = entryPath(key);
+    std::error_code   ec;
+    if (!fs::exists(entry, ec)) {
+        ++misses_;
+        return false;
+    }
+
+    fs::copy_file(entry, output, fs::copy_options::overwrite_existing, ec);
+    if (!ec && fs::exists(entry + COMPANION_EXT))
+        fs::copy_file(entry + COMPANION_EXT, output + COMPANION_EXT,
+                      fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        ++misses_;
+        return false;
+    }
+
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec); // LRU touch
+    ++hits_;
+    return true;
+}
+
+// Copy src to dst via a writer-unique temp name so readers never see a torn file
+static bool publish(const fs::path& src, const fs::path& dst) {
+    std::error_code ec;
+    const fs::path  tmp = dst.string() + ".tmp-" +
+        std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) +
+        "-" + std::to_string(llvm::sys::Process::getProcessId());
+    fs::copy_file(src, tmp, fs::copy_options::overwrite_existing, ec);
+    if (!ec) fs::rename(tmp, dst, ec);
+    if (ec) fs::remove(tmp, ec);
+    return !ec;
+}
+
+// Bytes an entry occupies on disk, companion included; 0 when absent
+static uint64_t entryBytes(const fs::path& entry) {
+    std::error_code ec;
+    uint64_t        bytes = 0;
+    if (const auto n = fs::file_size(entry, ec); !ec) bytes += n;
+    if (const auto n = fs::file_size(entry.string() + COMPANION_EXT, ec); !ec) bytes += n;
+    return bytes;
+}
+
+void ArtifactCache::store(const std::string& key, const std::string& output,
+                          const std::string& companion) {
+    const fs::path  entry = entryPath(key);
+    std::error_code ec;
+    fs::create_directories(entry.parent_path(), ec);
+    if (ec) return;
+
+    // Companion first: an entry is only visible once its .art exists
+    const uint64_t before = entryBytes(entry);
+    if (companion.empty() || publish(companion, entry.string() + COMPANION_EXT))
+        publish(output, entry);
+    storedBytes_ += static_cast<int64_t>(entryBytes(entry)) - static_cast<int64_t>(before);
+}
+
+// ── Eviction ──────────────────────────────────────────────────────────────
+
+struct CacheEntry {
+    fs::path            path;
+    fs::file_time_type  lastUse;
+    uint64_t            bytes;
+};
+
+static std::vector<CacheEntry> scanEntries(const std::string& dir, uint64_t& total) {
+    std::vector<CacheEntry> entries;
+    total = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || it->path().extension() != ENTRY_EXT)
+            continue;
+        uint64_t bytes = it->file_size(ec);
+        const fs::path companion = it->path().string() + COMPANION_EXT;
+        if (fs::exists(companion, ec))
+            bytes += fs::file_size(companion, ec);
+        entries.push_back({it->path(), it->last_write_time(ec), bytes});
+        total += bytes;
+    }
+    return entries;
+}
+
+// Rescan (the running total is only an estimate) and, if over budget, drop
+// least-recently-used entries down to 90%: the next scan then waits until
+// another tenth of the budget has been stored. Returns the bytes left.
+static uint64_t evict(const std::string& dir, uint64_t maxBytes) {
+    uint64_t total = 0;
+    auto entries = scanEntries(dir, total);
+    if (total <= maxBytes) return total;
+
+    const uint64_t target = maxBytes - maxBytes / 10;
+    std::sort(entries.begin(), entries.end(),
+              [](const CacheEntry& a, const CacheEntry& b) { return a.lastUse < b.lastUse; });
+    std::error_code ec;
+    for (const auto& e : entries) {
+        if (total <= target) break;
+        fs::remove(e.path, ec);
+        fs::remove(e.path.string() + COMPANION_EXT, ec);
+        total -= e.bytes;
+    }
+    return total;
+}
+
+// ── Persistent stats ──────────────────────────────────────────────────────
+
+struct CacheStats {
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;
+    uint64_t bytes     = 0;
+    bool     haveBytes = false;   // false until a store has seeded the total
+};
+
+static CacheStats readStats(const fs::path& statsFile) {
+    CacheStats    stats;
+    std::ifstream in(statsFile);
+    std::string   name;
+    uint64_t      val;
+    while (in >> name >> val) {
+        if      (name == "hits")   stats.hits   = val;
+        else if (name == "misses") stats.misses = val;
+        else if (name == "bytes")  stats.bytes  = val, stats.haveBytes = true;
+    }
+    return stats;
+}
+
+static void writeStats(const fs::path& statsFile, const CacheStats& stats) {
+    std::ofstream out(statsFile, std::ios::trunc);
+    out << "hits "   << stats.hits   << "\n"
+        << "misses " << stats.misses << "\n";
+    if (stats.haveBytes) out << "bytes " << stats.bytes << "\n";
+}
+
+void ArtifactCache::trim() {
+    const uint64_t h = hits_.exchange(0), m = misses_.exchange(0);
+    const int64_t  added = storedBytes_.exchange(0);
+    if (!h && !m && !added) return;
+
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    const fs::path statsFile = fs::path(dir_) / "stats";
+
+    // Serialise read-modify-write across concurrent compiler processes
+    int lockFd = -1;
+    if (llvm::sys::fs::openFileForWrite((fs::path(dir_) / "stats.lock").string(),
+                                        lockFd, llvm::sys::fs::CD_OpenAlways))
+        return;
+    if (!llvm::sys::fs::lockFile(lockFd)) {
+        CacheStats stats = readStats(statsFile);
+        stats.hits   += h;
+        stats.misses += m;
+        if (added) {
+            const uint64_t total = added < 0 && static_cast<uint64_t>(-added) > stats.bytes
+                ? 0 : stats.bytes + static_cast<uint64_t>(added);
+            // Only the first store into a cache without a total, or one
+            // that takes it over budget, walks the directory
+            stats.bytes     = !stats.haveBytes || total > maxBytes_ ? evict(dir_, maxBytes_)
+                                                                    : total;
+            stats.haveBytes = true;
+        }
+        writeStats(statsFile, stats);
+        llvm::sys::fs::unlockFile(lockFd);
+    }
+    llvm::sys::Process::SafelyCloseFileDescriptor(lockFd);
+}
+
+void ArtifactCache::printStats(std::ostream& os) {
+    trim();
+
+    const CacheStats stats = readStats(fs::path(dir_) / "stats");
+    const uint64_t   hits = stats.hits, misses = stats.misses;
+    uint64_t         total;
+    const auto entries = scanEntries(dir_, total);
+    const uint64_t lookups = hits + misses;
+
+    os << "Cache:    " << dir_ << "\n"
+       << "Entries:  " << entries.size() << "\n"
+       << "Size:     " << std::fixed << std::setprecision(1)
+       << (total / (1024.0 * 1024.0)) << " MiB of "
+       << (maxBytes_ / (1024.0 * 1024.0)) << " MiB\n"
+       << "Lookups:  " << lookups << " (" << hits << " hits, " << misses << " misses)\n"
+       << "Hit rate: " << std::setprecision(1)
+       << (lookups ? 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) : 0.0)
+       << "%\n";
+}
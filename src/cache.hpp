@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/// On-disk, content-addressed store of final artifacts.
+///
+/// Entries live at <dir>/<kk>/<key>.art, where key is a BLAKE3 digest of
+/// everything that can change the artifact (source bytes, build options,
+/// target triple, compiler + LLVM version). Lookups bump the entry's mtime,
+/// which is what trim() uses as the LRU clock. Writes go through a temp
+/// file + rename, so concurrent compilers never observe a partial entry.
+/// The stats file keeps a running byte total, so the directory is only
+/// scanned when stores push it past the budget.
+class ArtifactCache {
+public:
+    /// maxBytes — trim() evicts least-recently-used entries beyond this.
+    ArtifactCache(std::string dir, uint64_t maxBytes);
+
+    /// $NANOSCRIPT_CACHE_DIR, else $XDG_CACHE_HOME/nanoscript,
+    /// else ~/.cache/nanoscript.
+    static std::string defaultDir();
+
+    /// 64-char hex digest of the option header followed by the source bytes
+    /// (hashed in place — a large source is never copied into the key).
+    static std::string hashKey(std::string_view header, std::string_view content);
+
+    /// Copy the cached artifact (and its companion object, if one was
+    /// stored) to `output`. Counts a hit or a miss.
+    bool fetch(const std::string& key, const std::string& output);
+
+    /// Insert `output` (plus `companion` when non-empty) under `key`.
+    /// Failures are swallowed — the cache is an accelerator, never required.
+    void store(const std::string& key, const std::string& output,
+               const std::string& companion = "");
+
+    /// Fold this process's hit/miss counts and stored bytes into the
+    /// persistent stats; if that takes the total past maxBytes, evict
+    /// least-recently-used entries until the cache fits again.
+    void trim();
+
+    /// Hit rate (lifetime, including this process), entry count and size.
+    void printStats(std::ostream& os);
+
+private:
+    std::string entryPath(const std::string& key) const;
+
+    std::string           dir_;
+    uint64_t              maxBytes_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<int64_t>  storedBytes_{0};   // net bytes added by store()
+};
@@ -1,20 +1,139 @@
 #include "codegen.hpp"
-
+#include "nano_rt.h"
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/InlineCost.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/PatternMatch.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/MC/TargetRegistry.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/IPO/GlobalDCE.h>
+#include <llvm/Transforms/IPO/Inliner.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/GVN.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
 #include <llvm/TargetParser/Host.h>
 #include <llvm/TargetParser/Triple.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+// ── Target registry initialisation ────────────────────────────────────────
+// Native and wasm32 backends are both reachable from one compiler binary,
+// so register every target once per process; safe to call from any thread.
+
+void initializeLLVMTargets() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmParsers();
+        llvm::InitializeAllAsmPrinters();
+    });
+}
+
+// Backend opt level mirrors the IR pipeline chosen in optimize()
+llvm::CodeGenOptLevel codeGenOptLevel(BuildConfig config) {
+    switch (config) {
+        case BuildConfig::Debug:       return llvm::CodeGenOptLevel::None;
+        case BuildConfig::Fast:        return llvm::CodeGenOptLevel::Less;
+        case BuildConfig::Development: return llvm::CodeGenOptLevel::Default;
+        case BuildConfig::Shipping:    return llvm::CodeGenOptLevel::Aggressive;
+    }
+    return llvm::CodeGenOptLevel::Default;
+}
+
+// ── Target selection ──────────────────────────────────────────────────────
+
+TargetSpec resolveTarget(const TargetSpec& spec, bool wasm, bool wasmStartup) {
+    const std::string host = llvm::sys::getDefaultTargetTriple();
+    TargetSpec t;
+    t.triple = !spec.triple.empty() ? llvm::Triple::normalize(spec.triple)
+             : wasm                 ? std::string("wasm32-unknown-wasi")
+                                    : host;
+    if (spec.cpu == "native") {
+        if (llvm::Triple::normalize(t.triple) != llvm::Triple::normalize(host))
+            throw std::runtime_error("--cpu=native describes this machine (" + host +
+                                     "), not '" + t.triple + "'");
+        t.cpu = llvm::sys::getHostCPUName().str();
+        // Sorted, so the same machine always yields the same string (and cache key)
+        std::vector<std::string> features;
+        for (const auto& f : llvm::sys::getHostCPUFeatures())
+            features.push_back((f.getValue() ? "+" : "-") + f.getKey().str());
+        std::sort(features.begin(), features.end());
+        for (const std::string& f : features)
+            t.features += (t.features.empty() ? "" : ",") + f;
+    } else {
+        t.cpu = spec.cpu.empty() ? "generic" : spec.cpu;
+    }
+    if (wasm && wasmStartup)
+        t.features += (t.features.empty() ? "" : ",") + std::string(WASM_STARTUP_FEATURES);
+    // Explicit features come last, so they override the CPU's
+    if (!spec.features.empty())
+        t.features += (t.features.empty() ? "" : ",") + spec.features;
+    return t;
+}
+
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(const TargetSpec& target,
+                                                         llvm::CodeGenOptLevel level) {
+    initializeLLVMTargets();
+
+    std::string err;
+    const llvm::Target* backend = llvm::TargetRegistry::lookupTarget(target.triple, err);
+    if (!backend)
+        throw std::runtime_error("No LLVM backend for '" + target.triple + "': " + err);
+
+    llvm::TargetOptions opts;
+    std::unique_ptr<llvm::TargetMachine> tm(backend->createTargetMachine(
+        llvm::Triple(target.triple), target.cpu, target.features, opts,
+        llvm::Reloc::PIC_, /*CM=*/std::nullopt, level));
+    if (!tm)
+        throw std::runtime_error("Cannot create target machine for '" + target.triple + "'");
+    // LLVM only warns about an unknown CPU and falls back to generic
+    if (!tm->getMCSubtargetInfo()->isCPUStringValid(target.cpu))
+        throw std::runtime_error("Unknown CPU '" + target.cpu + "' for '" +
+                                 target.triple + "'");
+    return tm;
+}
 
 // ── Constructor ────────────────────────────────────────────────────────────
 
 Codegen::Codegen(const std::string& sourceFile, const std::string& sourceDir,
-                 BuildConfig config, bool wasm)
-    : builder_(context_), config_(config), wasm_(wasm)
+                 BuildConfig config, bool wasm, CodegenOptions options)
+    : config_(config), wasm_(wasm), options_(options),
+      target_(resolveTarget(options.target, wasm, options.wasmStartup)),
+      context_(std::make_unique<llvm::LLVMContext>()),
+      builder_(*context_),
+      sourceFile_(sourceFile)
 {
     setupModule();
 
@@ -22,11 +141,11 @@ Codegen::Codegen(const std::string& sourceFile, const std::string& sourceDir,
     if (config_ != BuildConfig::Shipping)
         setupDebugInfo(sourceFile, sourceDir);
 
-    declarePrintf();
+    declareRuntime();
 
-    int64Ty_ = llvm::Type::getInt64Ty(context_);
-    int32Ty_ = llvm::Type::getInt32Ty(context_);
-    ptrTy_   = llvm::PointerType::getUnqual(context_);   // opaque ptr
+    int64Ty_ = llvm::Type::getInt64Ty(*context_);
+    int32Ty_ = llvm::Type::getInt32Ty(*context_);
+    ptrTy_   = llvm::PointerType::getUnqual(*context_);   // opaque ptr
 
     if (diBuilder_)
         diInt64Ty_ = diBuilder_->createBasicType("int64", 64, llvm::dwarf::DW_ATE_signed);
@@ -35,29 +154,20 @@ Codegen::Codegen(const std::string& sourceFile, const std::string& sourceDir,
 // ── Module / target setup ─────────────────────────────────────────────────
 
 void Codegen::setupModule() {
-    module_ = std::make_unique<llvm::Module>("nanoscript", context_);
+    module_ = std::make_unique<llvm::Module>("nanoscript", *context_);
 
-    if (wasm_) {
-        // wasm32-wasi — used for all configs when --wasm is passed
-        module_->setTargetTriple(llvm::Triple("wasm32-unknown-wasi"));
-        module_->setDataLayout(
-            "e-m:e-p:32:32-p10:8:8-p20:8:8-i64:64-i128:128-n32:64-S128-ni:1:10:20");
-        if (config_ != BuildConfig::Shipping) {
-            module_->addModuleFlag(llvm::Module::Warning, "Dwarf Version",      5);
-            module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
-                                   llvm::DEBUG_METADATA_VERSION);
-        }
-    } else {
-        // Native — use the host triple so clang doesn't warn about a mismatch
-        module_->setTargetTriple(llvm::Triple(llvm::sys::getDefaultTargetTriple()));
-        module_->setDataLayout(
-            "e-m:o-p270:32:32-p271:32:32-p272:64:64-i64:64-i128:128-n32:64-S128-Fn32");
+    // The layout (pointer width, alignments, mangling) comes from the same
+    // TargetMachine that will emit the code, never a hardcoded string
+    llvm::TargetMachine& tm = targetMachine();
+    module_->setTargetTriple(tm.getTargetTriple());
+    module_->setDataLayout(tm.createDataLayout());
+
+    if (!wasm_)
         module_->addModuleFlag(llvm::Module::Max, "PIC Level", 2);
-        if (config_ != BuildConfig::Shipping) {
-            module_->addModuleFlag(llvm::Module::Warning, "Dwarf Version",      5);
-            module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
-                                   llvm::DEBUG_METADATA_VERSION);
-        }
+    if (config_ != BuildConfig::Shipping) {
+        module_->addModuleFlag(llvm::Module::Warning, "Dwarf Version",      5);
+        module_->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                               llvm::DEBUG_METADATA_VERSION);
     }
 }
 
@@ -76,28 +186,60 @@ void Codegen::setupDebugInfo(const std::string& sourceFile,
         /*RuntimeVersion=*/0);
 }
 
-// ── printf declaration ────────────────────────────────────────────────────
-
-void Codegen::declarePrintf() {
-    // printf(ptr fmt, ...) -> i32
-    auto* printfTy = llvm::FunctionType::get(
-        llvm::Type::getInt32Ty(context_),
-        {llvm::PointerType::getUnqual(context_)},
-        /*isVarArg=*/true);
-    printfFn_ = llvm::Function::Create(
-        printfTy, llvm::Function::ExternalLinkage, "printf", *module_);
-
-    // Global constant: "%lld\n\0"  (6 bytes)
-    auto* fmtData = llvm::ConstantDataArray::getString(context_, "%lld\n");
-    fmtStr_ = new llvm::GlobalVariable(
-        *module_,
-        fmtData->getType(),
-        /*isConstant=*/true,
-        llvm::GlobalValue::PrivateLinkage,
-        fmtData,
-        ".fmt");
-    fmtStr_->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
-    fmtStr_->setAlignment(llvm::Align(1));
+// ── Runtime declarations ──────────────────────────────────────────────────
+
+void Codegen::declareRuntime() {
+    // void nano_out_i64(i64) — buffered decimal output, flushed at exit
+    auto* outTy = llvm::FunctionType::get(
+        llvm::Type::getVoidTy(*context_),
+        {llvm::Type::getInt64Ty(*context_)},
+        /*isVarArg=*/false);
+    outFn_ = llvm::Function::Create(
+        outTy, llvm::Function::ExternalLinkage, "nano_out_i64", *module_);
+    outFn_->setDoesNotThrow();
+
+    // void nano_out_i64s(const i64*, i64) — each element, as nano_out_i64
+    auto* ptrTy    = llvm::PointerType::getUnqual(*context_);
+    auto* outArrTy = llvm::FunctionType::get(
+        llvm::Type::getVoidTy(*context_),
+        {ptrTy, llvm::Type::getInt64Ty(*context_)},
+        /*isVarArg=*/false);
+    outArrayFn_ = llvm::Function::Create(
+        outArrTy, llvm::Function::ExternalLinkage, "nano_out_i64s", *module_);
+    outArrayFn_->setDoesNotThrow();
+    outArrayFn_->addParamAttr(0, llvm::Attribute::ReadOnly);
+
+    // void nano_index_error(i64, i64, i32) — reports and exits. Cold and
+    // noreturn, so the bounds checks' failure paths are laid out of line.
+    auto* indexErrTy = llvm::FunctionType::get(
+        llvm::Type::getVoidTy(*context_),
+        {llvm::Type::getInt64Ty(*context_), llvm::Type::getInt64Ty(*context_),
+         llvm::Type::getInt32Ty(*context_)},
+        /*isVarArg=*/false);
+    indexErrorFn_ = llvm::Function::Create(
+        indexErrTy, llvm::Function::ExternalLinkage, "nano_index_error", *module_);
+    indexErrorFn_->setDoesNotThrow();
+    indexErrorFn_->setDoesNotReturn();
+    indexErrorFn_->addFnAttr(llvm::Attribute::Cold);
+
+    // void nano_arith_error(i32 kind, i32 line) — the --arith checks' report
+    auto* arithErrTy = llvm::FunctionType::get(
+        llvm::Type::getVoidTy(*context_),
+        {llvm::Type::getInt32Ty(*context_), llvm::Type::getInt32Ty(*context_)},
+        /*isVarArg=*/false);
+    arithErrorFn_ = llvm::Function::Create(
+        arithErrTy, llvm::Function::ExternalLinkage, "nano_arith_error", *module_);
+    arithErrorFn_->setDoesNotThrow();
+    arithErrorFn_->setDoesNotReturn();
+    arithErrorFn_->addFnAttr(llvm::Attribute::Cold);
+
+    // void nano_lines_register(const nano_line_table*) — --instrument=lines
+    linesFn_ = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(*context_),
+                                {llvm::PointerType::getUnqual(*context_)}, /*isVarArg=*/false),
+        llvm::Function::ExternalLinkage, "nano_lines_register", *module_);
+    linesFn_->setDoesNotThrow();
+    linesFn_->addParamAttr(0, llvm::Attribute::ReadOnly);
 }
 
 // ── main function scaffolding ─────────────────────────────────────────────
@@ -106,6 +248,7 @@ llvm::Function* Codegen::createMainFunction() {
     auto* mainTy = llvm::FunctionType::get(int32Ty_, /*isVarArg=*/false);
     auto* mainFn = llvm::Function::Create(
         mainTy, llvm::Function::ExternalLinkage, "main", *module_);
+    addTargetAttributes(mainFn);
 
     if (wasm_) {
         // wasm32-wasi: crt1's _start calls __main_void, not main directly.
@@ -135,23 +278,49 @@ llvm::Function* Codegen::createMainFunction() {
         mainFn->setSubprogram(diMainFunc_);
     }
 
-    auto* entry = llvm::BasicBlock::Create(context_, "entry", mainFn);
+    auto* entry = llvm::BasicBlock::Create(*context_, "entry", mainFn);
     builder_.SetInsertPoint(entry);
     builder_.SetCurrentDebugLocation(llvm::DebugLoc());
+    if (options_.instrumentLines) {
+        // Stand-ins until emitLineTable() knows how many statements there are
+        auto* none = llvm::ArrayType::get(int64Ty_, 0);
+        lineHits_  = new llvm::GlobalVariable(*module_, none, /*isConstant=*/false,
+                                              llvm::GlobalValue::InternalLinkage,
+                                              llvm::ConstantAggregateZero::get(none),
+                                              "nano.line.hits");
+        lineTable_ = new llvm::GlobalVariable(*module_, none, /*isConstant=*/true,
+                                              llvm::GlobalValue::InternalLinkage,
+                                              llvm::ConstantAggregateZero::get(none),
+                                              "nano.line.table");
+        builder_.CreateCall(linesFn_, {lineTable_});
+    }
     return mainFn;
 }
 
+void Codegen::addTargetAttributes(llvm::Function* fn) {
+    fn->addFnAttr("target-cpu", target_.cpu);
+    if (!target_.features.empty())
+        fn->addFnAttr("target-features", target_.features);
+    // What clang's -Oz puts on every function: the backend reads these,
+    // not the pipeline's level
+    if (wasm_ && options_.wasmStartup && config_ != BuildConfig::Debug) {
+        fn->addFnAttr(llvm::Attribute::OptimizeForSize);
+        fn->addFnAttr(llvm::Attribute::MinSize);
+    }
+}
+
 // ── Alloca helper ─────────────────────────────────────────────────────────
 
 llvm::AllocaInst* Codegen::createEntryAlloca(llvm::Function* fn,
-                                              const std::string& name) {
+                                              llvm::StringRef name,
+                                              llvm::Type* type) {
     auto savedIP = builder_.saveIP();
     auto& entry  = fn->getEntryBlock();
     auto  it     = entry.begin();
     while (it != entry.end() && llvm::isa<llvm::AllocaInst>(*it))
         ++it;
     builder_.SetInsertPoint(&entry, it);
-    auto* alloca = builder_.CreateAlloca(int64Ty_, nullptr, name);
+    auto* alloca = builder_.CreateAlloca(type ? type : int64Ty_, nullptr, name);
     builder_.restoreIP(savedIP);
     return alloca;
 }
@@ -159,32 +328,192 @@ llvm::AllocaInst* Codegen::createEntryAlloca(llvm::Function* fn,
 // ── Debug location helper ─────────────────────────────────────────────────
 
 void Codegen::setDebugLoc(int line, int col) {
-    if (!diMainFunc_) return;
+    if (!scope_.di) return;
     builder_.SetCurrentDebugLocation(
-        llvm::DILocation::get(context_,
+        llvm::DILocation::get(*context_,
                               static_cast<unsigned>(line),
                               static_cast<unsigned>(col),
-                              diMainFunc_));
+                              scope_.di));
+}
+
+// ── On-the-fly SSA construction ───────────────────────────────────────────
+// Braun et al. 2013. A block is sealed once all its predecessors are known;
+// reads in an unsealed block get an operandless phi that sealBlock() fills
+// in. Phis that turn out to merge a single value are folded away at once,
+// so straight-line code produces no phis at all.
+
+void Codegen::writeVariable(SymbolId id, llvm::BasicBlock* block, llvm::Value* value) {
+    currentDef_[{block, id}] = value;
+}
+
+llvm::Value* Codegen::readVariable(SymbolId id, llvm::BasicBlock* block) {
+    auto it = currentDef_.find({block, id});
+    if (it != currentDef_.end() && it->second)
+        return it->second;
+    return readVariableRecursive(id, block);
+}
+
+llvm::Value* Codegen::readVariableRecursive(SymbolId id, llvm::BasicBlock* block) {
+    llvm::Value* val;
+    if (!sealed_.count(block)) {
+        auto* phi = llvm::PHINode::Create(int64Ty_, 2, symbols_->name(id));
+        phi->insertInto(block, block->begin());
+        incompletePhis_[block].push_back({id, phi});
+        val = phi;
+    } else if (llvm::BasicBlock* pred = block->getSinglePredecessor()) {
+        val = readVariable(id, pred);
+    } else if (llvm::pred_empty(block)) {
+        // Entry reached on a path that never assigned: the slot's initial
+        // zero in the interpreter (codegen only gets here across an if or
+        // around a loop)
+        val = llvm::ConstantInt::get(int64Ty_, 0);
+    } else {
+        // Break cycles with an operandless phi before visiting predecessors
+        auto* phi = llvm::PHINode::Create(int64Ty_, 2, symbols_->name(id));
+        phi->insertInto(block, block->begin());
+        writeVariable(id, block, phi);
+        val = addPhiOperands(id, phi);
+    }
+    writeVariable(id, block, val);
+    return val;
+}
+
+llvm::Value* Codegen::addPhiOperands(SymbolId id, llvm::PHINode* phi) {
+    llvm::BasicBlock* block = phi->getParent();
+    for (llvm::BasicBlock* pred : llvm::predecessors(block))
+        phi->addIncoming(readVariable(id, pred), pred);
+    return tryRemoveTrivialPhi(phi);
+}
+
+llvm::Value* Codegen::tryRemoveTrivialPhi(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+    for (llvm::Value* op : phi->incoming_values()) {
+        if (op == same || op == phi) continue;   // unique value or self-reference
+        if (same) return phi;                    // merges at least two values
+        same = op;
+    }
+    if (!same)   // unreachable or only self-referencing
+        same = llvm::PoisonValue::get(int64Ty_);
+
+    // Phis using this one may become trivial in turn
+    llvm::SmallVector<llvm::WeakVH, 4> users;
+    for (llvm::User* u : phi->users())
+        if (u != phi && llvm::isa<llvm::PHINode>(u))
+            users.push_back(u);
+
+    phi->replaceAllUsesWith(same);   // also rewrites currentDef_ entries
+    phi->eraseFromParent();
+
+    for (llvm::WeakVH& u : users)
+        if (auto* p = llvm::dyn_cast_or_null<llvm::PHINode>(u))
+            tryRemoveTrivialPhi(p);
+    return same;
+}
+
+void Codegen::sealBlock(llvm::BasicBlock* block) {
+    auto it = incompletePhis_.find(block);
+    if (it != incompletePhis_.end()) {
+        auto pending = std::move(it->second);
+        incompletePhis_.erase(it);
+        for (auto& [id, phi] : pending)
+            addPhiOperands(id, phi);
+    }
+    sealed_.insert(block);
+}
+
+void Codegen::describeVariable(SymbolId id, llvm::Value* value, int line, int col) {
+    if (!diBuilder_) return;
+    llvm::DILocalVariable*& diVar = scope_.diVars[id];
+    if (!diVar)
+        diVar = diBuilder_->createAutoVariable(
+            scope_.di, symbols_->name(id), diFile_,
+            static_cast<unsigned>(line), diInt64Ty_);
+    auto* loc = llvm::DILocation::get(*context_,
+                                      static_cast<unsigned>(line),
+                                      static_cast<unsigned>(col),
+                                      scope_.di);
+    diBuilder_->insertDbgValueIntrinsic(
+        value, diVar, diBuilder_->createExpression(), loc,
+        builder_.GetInsertBlock());
+}
+
+void Codegen::describeMerged(size_t logMark, llvm::BasicBlock* block, int line, int col) {
+    // Compact the log to one entry per variable, in first-write order, so
+    // an enclosing if or loop still sees them
+    llvm::SmallDenseSet<SymbolId, 8> seen;
+    size_t kept = logMark;
+    for (size_t i = logMark; i < scope_.assignLog.size(); ++i)
+        if (seen.insert(scope_.assignLog[i]).second)
+            scope_.assignLog[kept++] = scope_.assignLog[i];
+    scope_.assignLog.resize(kept);
+    for (size_t i = logMark; i < kept; ++i) {
+        const SymbolId id = scope_.assignLog[i];
+        llvm::Value* merged = readVariable(id, block);
+        setDebugLoc(line, col);
+        describeVariable(id, merged, line, col);
+    }
 }
 
 // ── Top-level generate ────────────────────────────────────────────────────
 
 void Codegen::generate(const ProgramNode& program) {
-    llvm::Function* mainFn = createMainFunction();
+    lower(program);
+    optimizeAndVerify();
+}
+
+void Codegen::lower(const ProgramNode& program) {
+    TimeReport::Scope t(timing_, "codegen");
+    beginStream(program);
+    for (const StmtNode* stmt : program.statements)
+        genStatement(*stmt, mainFn_);
+    endStream();
+}
+
+void Codegen::optimizeAndVerify() {
+    {
+        TimeReport::Scope t(timing_, "optimize");
+        optimize();
+    }
 
-    for (const auto& stmt : program.statements)
-        genStatement(*stmt, mainFn);
+    TimeReport::Scope t(timing_, "verify");
+    verify();
+}
+
+void Codegen::beginStream(const ProgramNode& program) {
+    mainFn_ = createMainFunction();
+
+    // Symbol IDs are dense, so the variable table is a flat array
+    symbols_ = &program.symbols;
+    genFunctions(program);
+    scope_.di   = diMainFunc_;
+    scope_.once = true;
+    scope_.resize(program.symbols.size());
+    if (options_.ssa) sealBlock(&mainFn_->getEntryBlock());
+}
 
+void Codegen::lowerStatement(const StmtNode& stmt) {
+    scope_.resize(symbols_->size());   // the parser interns as it goes
+    genStatement(stmt, mainFn_);
+}
+
+void Codegen::endStream() {
+    finishMain();
+}
+
+void Codegen::finishMain() {
     setDebugLoc(1, 1);
     builder_.CreateRet(llvm::ConstantInt::get(int32Ty_, 0));
+    if (options_.instrumentLines) emitLineTable();
 
+    // Safe to repeat in watch mode: only nodes new since the last call
+    // still need resolving
     if (diBuilder_) {
         diBuilder_->finalizeSubprogram(diMainFunc_);
         diBuilder_->finalize();
     }
+}
 
-    optimize();
-
+void Codegen::verify() {
     std::string errors;
     llvm::raw_string_ostream es(errors);
     if (llvm::verifyModule(*module_, &es)) {
@@ -193,9 +522,161 @@ void Codegen::generate(const ProgramNode& program) {
     }
 }
 
+// ── Incremental generation (watch mode) ───────────────────────────────────
+
+void Codegen::generateFrom(const ProgramNode& program, size_t first) {
+    TimeReport::Scope t(timing_, "codegen");
+    symbols_ = &program.symbols;
+    const bool hasFunctions =
+        std::any_of(program.statements.begin(), program.statements.end(),
+                    [](const StmtNode* s) { return s->kind == NodeKind::Function; });
+
+    if (!mainFn_) {
+        mainFn_     = createMainFunction();
+        scope_.di   = diMainFunc_;
+        scope_.once = true;
+        first       = 0;
+    } else {
+        // SSA definitions span blocks and are not checkpointed, and calls
+        // are lowered against their callee's index and parameters
+        if (options_.ssa || hasFunctions || !functions_.empty()) first = 0;
+        truncateMain(std::min(first, checkpoints_.size() - 1));
+    }
+    if (first == 0) {
+        // Nothing calls the old functions any more
+        for (llvm::Function* fn : functions_) fn->eraseFromParent();
+        lineSites_.clear();
+        genFunctions(program);
+    }
+    scope_.resize(program.symbols.size());
+
+    if (options_.ssa) {
+        currentDef_.clear();
+        incompletePhis_.clear();
+        sealed_.clear();
+        scope_.assignLog.clear();
+        scope_.declared.assign(program.symbols.size(), false);
+        scope_.diVars.assign(program.symbols.size(), nullptr);
+        sealBlock(&mainFn_->getEntryBlock());
+    }
+
+    auto checkpoint = [&] {
+        llvm::BasicBlock* bb = builder_.GetInsertBlock();
+        checkpoints_.push_back({bb, bb->empty() ? nullptr : &bb->back(), scope_.allocaLog.size(),
+                                scope_.arrayLog.size(), lineSites_.size()});
+    };
+    for (size_t i = checkpoints_.size(); i < program.statements.size(); ++i) {
+        checkpoint();
+        genStatement(*program.statements[i], mainFn_);
+    }
+    checkpoint();   // before the ret, for edits that only append
+    finishMain();
+}
+
+void Codegen::truncateMain(size_t index) {
+    const Checkpoint cp = checkpoints_[index];
+    checkpoints_.resize(index);
+    lineSites_.resize(cp.sites);   // their counters are cut with the code
+
+    // Everything after the checkpoint in its block, every later block, and
+    // the slots of variables first assigned after it. A slot is the only
+    // thing that lands before `last` (allocas go to the entry block's top).
+    std::vector<llvm::Instruction*> dead;
+    auto it = cp.last ? std::next(cp.last->getIterator()) : cp.block->begin();
+    for (; it != cp.block->end(); ++it)
+        if (!llvm::isa<llvm::AllocaInst>(*it))
+            dead.push_back(&*it);
+    std::vector<llvm::BasicBlock*> deadBlocks;
+    for (auto bb = std::next(cp.block->getIterator()); bb != mainFn_->end(); ++bb) {
+        if (&*bb == scope_.trap) continue;   // shared with live checks
+        deadBlocks.push_back(&*bb);
+        for (llvm::Instruction& inst : *bb)
+            dead.push_back(&inst);
+    }
+    // A slot's zero store sits among the entry block's live code
+    const llvm::SmallPtrSet<llvm::Instruction*, 32> cut(dead.begin(), dead.end());
+    for (size_t i = cp.allocas; i < scope_.allocaLog.size(); ++i) {
+        llvm::AllocaInst* slot = scope_.variables[scope_.allocaLog[i]];
+        for (llvm::User* user : slot->users())
+            if (!cut.count(llvm::cast<llvm::Instruction>(user)))
+                dead.push_back(llvm::cast<llvm::Instruction>(user));
+        dead.push_back(slot);
+        scope_.variables[scope_.allocaLog[i]] = nullptr;
+    }
+    scope_.allocaLog.resize(cp.allocas);
+    std::vector<llvm::GlobalVariable*> deadGlobals;
+    for (size_t i = cp.arrays; i < scope_.arrayLog.size(); ++i) {
+        const auto [id, ptr] = scope_.arrayLog[i];
+        if (auto* alloca = llvm::dyn_cast<llvm::AllocaInst>(ptr))
+            dead.push_back(alloca);
+        else
+            deadGlobals.push_back(llvm::cast<llvm::GlobalVariable>(ptr));
+        if (id != NO_ARRAY_VAR) scope_.arrays[id] = ArrayStorage{};
+    }
+    scope_.arrayLog.resize(cp.arrays);
+
+    // The trap block outlives the checks that branched to it from dead code,
+    // unless there are no others
+    if (scope_.trap) {
+        const llvm::DenseSet<llvm::BasicBlock*> gone(deadBlocks.begin(), deadBlocks.end());
+        for (llvm::PHINode* phi : {scope_.trapKind, scope_.trapLine})
+            for (unsigned i = phi->getNumIncomingValues(); i-- > 0;)
+                if (phi->getIncomingBlock(i) == cp.block || gone.count(phi->getIncomingBlock(i)))
+                    phi->removeIncomingValue(i, /*DeletePHIIfEmpty=*/false);
+        if (scope_.trapKind->getNumIncomingValues() == 0) {
+            for (llvm::Instruction& inst : *scope_.trap)
+                dead.push_back(&inst);
+            deadBlocks.push_back(scope_.trap);
+            scope_.trap     = nullptr;
+            scope_.trapKind = scope_.trapLine = nullptr;
+        }
+    }
+
+    // Dead code only uses dead code (and live allocas), so cut every edge
+    // first and then erase in any order
+    for (llvm::Instruction* inst : dead) {
+        inst->dropDbgRecords();
+        inst->dropAllReferences();
+    }
+    for (llvm::Instruction* inst : dead)
+        inst->eraseFromParent();
+    for (llvm::BasicBlock* bb : deadBlocks)
+        bb->eraseFromParent();
+    for (llvm::GlobalVariable* gv : deadGlobals)   // unused now
+        gv->eraseFromParent();
+
+    builder_.SetInsertPoint(cp.block);
+}
+
+void Codegen::withSnapshot(llvm::function_ref<void()> emit) {
+    std::unique_ptr<llvm::Module> copy;
+    {
+        TimeReport::Scope t(timing_, "snapshot");
+        copy = llvm::CloneModule(*module_);
+    }
+    std::swap(module_, copy);   // emitters and optimize() work on module_
+    try {
+        {
+            TimeReport::Scope t(timing_, "optimize");
+            optimize();
+        }
+        {
+            TimeReport::Scope t(timing_, "verify");
+            verify();
+        }
+        emit();
+    } catch (...) {
+        std::swap(module_, copy);
+        throw;
+    }
+    std::swap(module_, copy);
+}
+
 // ── Statement dispatch ────────────────────────────────────────────────────
 
 void Codegen::genStatement(const StmtNode& stmt, llvm::Function* fn) {
+    if (options_.instrumentLines && stmt.kind != NodeKind::Function)
+        countStatement(stmt, fn);
     switch (stmt.kind) {
         case NodeKind::Assignment:
             genAssignment(static_cast<const AssignmentNode&>(stmt), fn);
@@ -203,31 +684,132 @@ void Codegen::genStatement(const StmtNode& stmt, llvm::Function* fn) {
         case NodeKind::If:
             genIf(static_cast<const IfNode&>(stmt), fn);
             break;
+        case NodeKind::While:
+            genWhile(static_cast<const WhileNode&>(stmt), fn);
+            break;
+        case NodeKind::IndexAssign:
+            genIndexAssign(static_cast<const IndexAssignNode&>(stmt));
+            break;
         case NodeKind::Out:
             genOut(static_cast<const OutNode&>(stmt));
             break;
+        case NodeKind::Return:
+            genReturn(static_cast<const ReturnNode&>(stmt));
+            break;
+        case NodeKind::Function:
+            break;   // generated by genFunctions
         default:
             throw std::runtime_error("Unknown statement kind in codegen");
     }
 }
 
+// ── Line counters (--instrument=lines) ────────────────────────────────────
+// A relaxed atomic add per statement: no fence, and no call for the
+// optimiser to work around. Counts are keyed by a folded-stack frame, so
+// the report feeds flamegraph.pl or inferno as it is.
+
+void Codegen::countStatement(const StmtNode& stmt, llvm::Function* fn) {
+    llvm::StringRef frame = fn->getName();
+    frame.consume_front("nano.");
+    lineSites_.push_back(frame.str() + ';' + sourceFile_ + ':' + std::to_string(stmt.line) +
+                         ':' + std::to_string(stmt.col));
+    setDebugLoc(stmt.line, stmt.col);
+    builder_.CreateAtomicRMW(
+        llvm::AtomicRMWInst::Add,
+        builder_.CreateConstGEP1_64(int64Ty_, lineHits_, lineSites_.size() - 1, "line.hit"),
+        llvm::ConstantInt::get(int64Ty_, 1), llvm::Align(8), llvm::AtomicOrdering::Monotonic);
+}
+
+void Codegen::emitLineTable() {
+    // Replace `old` by `now` everywhere, and take over its name
+    auto replace = [](llvm::GlobalVariable* old, llvm::GlobalVariable* now) {
+        if (!old) return;
+        old->replaceAllUsesWith(now);
+        now->takeName(old);
+        old->eraseFromParent();
+    };
+
+    auto* hitsTy = llvm::ArrayType::get(int64Ty_, lineSites_.size());
+    auto* hits   = new llvm::GlobalVariable(*module_, hitsTy, /*isConstant=*/false,
+                                            llvm::GlobalValue::InternalLinkage,
+                                            llvm::ConstantAggregateZero::get(hitsTy),
+                                            "nano.line.hits");
+    replace(lineHits_, hits);
+    lineHits_ = hits;
+
+    std::string blob;
+    for (const std::string& site : lineSites_) {
+        blob += site;
+        blob += '\0';
+    }
+    auto* labelsInit = llvm::ConstantDataArray::getString(*context_, blob, /*AddNull=*/false);
+    auto* labels     = new llvm::GlobalVariable(*module_, labelsInit->getType(),
+                                                /*isConstant=*/true,
+                                                llvm::GlobalValue::PrivateLinkage, labelsInit,
+                                                "nano.line.labels");
+
+    // struct nano_line_table { int64_t count; int64_t* hits; const char* labels; }
+    auto* tableTy   = llvm::StructType::get(*context_, {int64Ty_, ptrTy_, ptrTy_});
+    auto* tableInit = llvm::ConstantStruct::get(
+        tableTy, {llvm::ConstantInt::get(int64Ty_, lineSites_.size()), hits, labels});
+    auto* table = new llvm::GlobalVariable(*module_, tableTy, /*isConstant=*/true,
+                                           llvm::GlobalValue::InternalLinkage, tableInit,
+                                           "nano.line.table");
+    replace(lineTable_, table);
+    lineTable_ = table;
+    replace(lineLabels_, labels);   // the old table was its only user
+    lineLabels_ = labels;
+}
+
 // ── Assignment ────────────────────────────────────────────────────────────
 
 void Codegen::genAssignment(const AssignmentNode& node, llvm::Function* fn) {
     setDebugLoc(node.line, node.col);
 
-    if (variables_.find(node.varName) == variables_.end()) {
-        auto* alloca = createEntryAlloca(fn, node.varName);
-        variables_[node.varName] = alloca;
+    if (node.value->length > 0) {
+        // An array lives in memory in both lowerings; its storage, too,
+        // exists before its value is computed
+        ArrayStorage& slot = scope_.arrays[node.varName];
+        if (!slot.ptr)
+            slot = createArrayStorage(fn, node.varName, node.value->length, node.line);
+        storeArray(slot, *node.value);
+        return;
+    }
+
+    if (options_.ssa) {
+        // Like the alloca, the variable exists before its value is computed
+        scope_.declared[node.varName] = true;
+        llvm::Value* val = genExpr(*node.value);
+        writeVariable(node.varName, builder_.GetInsertBlock(), val);
+        scope_.assignLog.push_back(node.varName);
+        setDebugLoc(node.line, node.col);
+        describeVariable(node.varName, val, node.line, node.col);
+        return;
+    }
+
+    llvm::AllocaInst*& slot = scope_.variables[node.varName];
+    if (!slot) {
+        const std::string_view name = symbols_->name(node.varName);
+        auto* alloca = createEntryAlloca(fn, name);
+        slot = alloca;
+        scope_.allocaLog.push_back(node.varName);
+        {
+            // Zero until assigned, as the interpreter's slots and --ssa's
+            // reads start: a path around the assignment reads 0, not undef
+            llvm::IRBuilderBase::InsertPointGuard guard(builder_);
+            builder_.SetInsertPoint(alloca->getParent(), std::next(alloca->getIterator()));
+            builder_.SetCurrentDebugLocation(llvm::DebugLoc());
+            builder_.CreateStore(llvm::ConstantInt::get(int64Ty_, 0), alloca);
+        }
 
         if (diBuilder_) {
             auto* diVar = diBuilder_->createAutoVariable(
-                diMainFunc_, node.varName, diFile_,
+                scope_.di, name, diFile_,
                 static_cast<unsigned>(node.line), diInt64Ty_);
-            auto* loc = llvm::DILocation::get(context_,
+            auto* loc = llvm::DILocation::get(*context_,
                                               static_cast<unsigned>(node.line),
                                               static_cast<unsigned>(node.col),
-                                              diMainFunc_);
+                                              scope_.di);
             diBuilder_->insertDeclare(
                 alloca, diVar,
                 diBuilder_->createExpression(),
@@ -238,7 +820,7 @@ void Codegen::genAssignment(const AssignmentNode& node, llvm::Function* fn) {
 
     llvm::Value* val = genExpr(*node.value);
     setDebugLoc(node.line, node.col);
-    builder_.CreateStore(val, variables_[node.varName]);
+    builder_.CreateStore(val, slot);
 }
 
 // ── If statement ──────────────────────────────────────────────────────────
@@ -253,19 +835,107 @@ void Codegen::genIf(const IfNode& node, llvm::Function* fn) {
         cond = builder_.CreateICmpNE(cond, llvm::ConstantInt::get(int64Ty_, 0), "ifcond");
     }
 
-    auto* thenBB  = llvm::BasicBlock::Create(context_, "then",  fn);
-    auto* mergeBB = llvm::BasicBlock::Create(context_, "merge", fn);
+    auto* thenBB  = llvm::BasicBlock::Create(*context_, "then",  fn);
+    // Placed once the body is: watch mode's checkpoints take every block
+    // after the current one to come later in the program, nested ones too
+    auto* mergeBB = llvm::BasicBlock::Create(*context_, "merge");
 
     builder_.CreateCondBr(cond, thenBB, mergeBB);
+    if (options_.ssa) sealBlock(thenBB);   // its only predecessor is wired
 
+    const size_t logMark = scope_.assignLog.size();
     builder_.SetInsertPoint(thenBB);
-    for (const auto& s : node.body)
+    for (const StmtNode* s : node.body)
         genStatement(*s, fn);
 
     if (!builder_.GetInsertBlock()->getTerminator())
         builder_.CreateBr(mergeBB);
 
+    mergeBB->insertInto(fn);
     builder_.SetInsertPoint(mergeBB);
+    if (!options_.ssa) return;
+
+    // Both edges into the merge exist now; materialise the phis for what
+    // the body assigned so the debugger sees the merged values.
+    sealBlock(mergeBB);
+    describeMerged(logMark, mergeBB, node.line, node.col);
+}
+
+// ── Loops ─────────────────────────────────────────────────────────────────
+// Emitted in the shape LoopSimplify produces, so the loop passes start
+// from canonical form instead of rebuilding it:
+//
+//   (current block = preheader) → header ─┬→ body … → latch ─→ header
+//                                         └→ exit
+//
+// The header holds only the test, the latch the step and the single
+// back-edge, which carries the !llvm.loop metadata. LoopRotate turns this
+// into the guarded do-while that LoopVectorize and the unroller expect.
+
+void Codegen::genWhile(const WhileNode& node, llvm::Function* fn) {
+    if (node.init) genStatement(*node.init, fn);
+    setDebugLoc(node.line, node.col);
+
+    auto* headerBB = llvm::BasicBlock::Create(*context_, "loop.header", fn);
+    auto* bodyBB   = llvm::BasicBlock::Create(*context_, "loop.body",   fn);
+    auto* latchBB  = llvm::BasicBlock::Create(*context_, "loop.latch");   // after the body's
+    auto* exitBB   = llvm::BasicBlock::Create(*context_, "loop.exit");
+    builder_.CreateBr(headerBB);
+
+    // The header stays unsealed until the back-edge exists: every variable
+    // read in the loop gets its phi there
+    const size_t logMark = scope_.assignLog.size();
+    builder_.SetInsertPoint(headerBB);
+    llvm::Value* cond = genExpr(*node.condition);
+    setDebugLoc(node.line, node.col);
+    cond = builder_.CreateICmpNE(cond, llvm::ConstantInt::get(int64Ty_, 0), "loopcond");
+    builder_.CreateCondBr(cond, bodyBB, exitBB);
+    if (options_.ssa) sealBlock(bodyBB);
+
+    builder_.SetInsertPoint(bodyBB);
+    for (const StmtNode* s : node.body)
+        genStatement(*s, fn);
+    builder_.CreateBr(latchBB);
+
+    latchBB->insertInto(fn);
+    builder_.SetInsertPoint(latchBB);
+    if (options_.ssa) sealBlock(latchBB);
+    if (node.step) genStatement(*node.step, fn);
+    setDebugLoc(node.line, node.col);
+    llvm::BranchInst* backEdge = builder_.CreateBr(headerBB);
+    backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopMetadata(node));
+
+    exitBB->insertInto(fn);
+    builder_.SetInsertPoint(exitBB);
+    if (!options_.ssa) return;
+    sealBlock(headerBB);
+    sealBlock(exitBB);
+    describeMerged(logMark, exitBB, node.line, node.col);
+}
+
+// A distinct, self-referencing loop ID carrying `properties`
+static llvm::MDNode* loopID(llvm::LLVMContext& ctx, llvm::ArrayRef<llvm::Metadata*> properties) {
+    llvm::SmallVector<llvm::Metadata*, 4> ops{nullptr};
+    ops.append(properties.begin(), properties.end());
+    llvm::MDNode* id = llvm::MDNode::getDistinct(ctx, ops);
+    id->replaceOperandWith(0, id);
+    return id;
+}
+
+llvm::MDNode* Codegen::loopMetadata(const WhileNode& node) {
+    llvm::SmallVector<llvm::Metadata*, 2> ops;
+    // Where optimisation remarks and the vectoriser's diagnostics point
+    if (scope_.di)
+        ops.push_back(llvm::DILocation::get(*context_, static_cast<unsigned>(node.line),
+                                            static_cast<unsigned>(node.col), scope_.di));
+    // As in C11: a loop whose condition is not a constant may be assumed to
+    // terminate (or to produce output), so a side-effect-free loop with an
+    // unknown trip count can still be analysed, vectorised or deleted.
+    // `while (1)` keeps its meaning.
+    if (node.condition->kind != NodeKind::IntLiteral)
+        ops.push_back(llvm::MDNode::get(*context_,
+                                        llvm::MDString::get(*context_, "llvm.loop.mustprogress")));
+    return loopID(*context_, ops);
 }
 
 // ── Out statement ─────────────────────────────────────────────────────────
@@ -273,14 +943,258 @@ void Codegen::genIf(const IfNode& node, llvm::Function* fn) {
 void Codegen::genOut(const OutNode& node) {
     setDebugLoc(node.line, node.col);
 
+    if (node.expr->length > 0) {
+        ArrayStorage array;
+        if (node.expr->kind == NodeKind::Variable) {
+            const auto& v = static_cast<const VariableNode&>(*node.expr);
+            array = arrayOf(v.name, v.line);
+        } else {
+            array = createArrayStorage(builder_.GetInsertBlock()->getParent(), NO_ARRAY_VAR,
+                                       node.expr->length, 0);
+            storeArray(array, *node.expr);
+        }
+        setDebugLoc(node.line, node.col);
+        builder_.CreateCall(outArrayFn_,
+                            {array.ptr, llvm::ConstantInt::get(int64Ty_, array.length)});
+        return;
+    }
+
     llvm::Value* val = genExpr(*node.expr);
     setDebugLoc(node.line, node.col);
 
-    auto* zero   = llvm::ConstantInt::get(int32Ty_, 0);
-    auto* fmtPtr = builder_.CreateInBoundsGEP(
-        fmtStr_->getValueType(), fmtStr_, {zero, zero}, "fmtptr");
+    builder_.CreateCall(outFn_, {val});
+}
+
+// ── Functions ─────────────────────────────────────────────────────────────
+// Every function is declared before any body is generated, so calls may
+// refer forward and functions may recurse.
+
+void Codegen::genFunctions(const ProgramNode& program) {
+    std::vector<const FunctionNode*> defs;
+    for (const StmtNode* stmt : program.statements)
+        if (stmt->kind == NodeKind::Function)
+            defs.push_back(static_cast<const FunctionNode*>(stmt));
+
+    functions_.assign(defs.size(), nullptr);
+    for (const FunctionNode* def : defs) functions_[def->index] = declareFunction(*def);
+    for (const FunctionNode* def : defs) genFunction(*def);
+}
+
+llvm::Function* Codegen::declareFunction(const FunctionNode& node) {
+    const std::string name(symbols_->name(node.name));
+    llvm::SmallVector<llvm::Type*, 4> params(node.params.size, int64Ty_);
+    auto* fnTy = llvm::FunctionType::get(int64Ty_, params, false);
+
+    // Internal: the inliner may drop the body once every call is inlined.
+    // The prefix keeps `fn main` or `fn memset` clear of the C symbols.
+    auto* fn = llvm::Function::Create(fnTy, llvm::Function::InternalLinkage,
+                                      "nano." + name, module_.get());
+    addTargetAttributes(fn);
+    fn->setDoesNotThrow();
+    if (node.hint == InlineHint::Inline)   fn->addFnAttr(llvm::Attribute::InlineHint);
+    if (node.hint == InlineHint::NoInline) fn->addFnAttr(llvm::Attribute::NoInline);
+    for (size_t i = 0; i < node.params.size; ++i)
+        fn->getArg(static_cast<unsigned>(i))->setName(symbols_->name(node.params.data[i]->name));
+
+    if (diBuilder_) {
+        llvm::SmallVector<llvm::Metadata*, 5> types(node.params.size + 1, diInt64Ty_);
+        auto* subTy = diBuilder_->createSubroutineType(diBuilder_->getOrCreateTypeArray(types));
+        auto* sp = diBuilder_->createFunction(
+            diCompileUnit_, name, fn->getName(), diFile_,
+            static_cast<unsigned>(node.line), subTy,
+            static_cast<unsigned>(node.line),
+            llvm::DINode::FlagPrototyped,
+            llvm::DISubprogram::SPFlagDefinition | llvm::DISubprogram::SPFlagLocalToUnit);
+        fn->setSubprogram(sp);
+    }
+    return fn;
+}
+
+void Codegen::genFunction(const FunctionNode& node) {
+    llvm::Function* fn       = functions_[node.index];
+    auto            savedIP  = builder_.saveIP();
+    llvm::DebugLoc  savedLoc = builder_.getCurrentDebugLocation();
+
+    // Variables are local to the function: `x` here is not main's `x`
+    Scope outer = std::exchange(scope_, Scope{});
+    scope_.di   = fn->getSubprogram();
+    scope_.resize(symbols_->size());
+
+    auto* entry = llvm::BasicBlock::Create(*context_, "entry", fn);
+    builder_.SetInsertPoint(entry);
+    if (options_.ssa) sealBlock(entry);
+    setDebugLoc(node.line, node.col);
+
+    for (size_t i = 0; i < node.params.size; ++i) {
+        const VariableNode& param = *node.params.data[i];
+        llvm::Argument*     arg   = fn->getArg(static_cast<unsigned>(i));
+        llvm::DILocalVariable* diVar = nullptr;
+        if (diBuilder_)
+            diVar = diBuilder_->createParameterVariable(
+                scope_.di, symbols_->name(param.name), static_cast<unsigned>(i + 1), diFile_,
+                static_cast<unsigned>(param.line), diInt64Ty_, /*AlwaysPreserve=*/true);
+
+        if (options_.ssa) {
+            scope_.declared[param.name] = true;
+            scope_.diVars[param.name]   = diVar;
+            writeVariable(param.name, entry, arg);
+            describeVariable(param.name, arg, param.line, param.col);
+            continue;
+        }
+        auto* alloca = createEntryAlloca(fn, arg->getName());
+        scope_.variables[param.name] = alloca;
+        if (diVar)
+            diBuilder_->insertDeclare(
+                alloca, diVar, diBuilder_->createExpression(),
+                llvm::DILocation::get(*context_, static_cast<unsigned>(param.line),
+                                      static_cast<unsigned>(param.col), scope_.di),
+                entry);
+        builder_.CreateStore(arg, alloca);
+    }
+
+    for (const StmtNode* stmt : node.body)
+        genStatement(*stmt, fn);
+
+    // Falling off the end returns 0, like the interpreter
+    if (!builder_.GetInsertBlock()->getTerminator()) {
+        setDebugLoc(node.line, node.col);
+        builder_.CreateRet(llvm::ConstantInt::get(int64Ty_, 0));
+    }
+    if (diBuilder_) diBuilder_->finalizeSubprogram(scope_.di);
+
+    scope_ = std::move(outer);
+    builder_.restoreIP(savedIP);
+    builder_.SetCurrentDebugLocation(savedLoc);
+}
+
+void Codegen::genReturn(const ReturnNode& node) {
+    llvm::Value* val = genExpr(*node.value);
+    setDebugLoc(node.line, node.col);
+    builder_.CreateRet(val);
+
+    // Anything after the return is dead but still has to go somewhere
+    llvm::Function* fn    = builder_.GetInsertBlock()->getParent();
+    auto*           after = llvm::BasicBlock::Create(*context_, "after.return", fn);
+    builder_.SetInsertPoint(after);
+    if (options_.ssa) sealBlock(after);
+}
+
+// ── Arithmetic (--arith) ──────────────────────────────────────────────────
+// Wrap is two's complement, as the interpreter does it. Trap and saturate use
+// the overflow intrinsics, which the backends lower to a flag test, and every
+// failed check in a function shares one cold block that reports and exits.
 
-    builder_.CreateCall(printfFn_, {fmtPtr, val});
+// True if any lane of an i1 or <N x i1> is set
+static llvm::Value* anyLane(llvm::IRBuilder<>& b, llvm::Value* v) {
+    return v->getType()->isVectorTy() ? b.CreateOrReduce(v) : v;
+}
+
+void Codegen::trapIf(llvm::Value* failed, llvm::Value* kind, int line) {
+    llvm::BasicBlock* from = builder_.GetInsertBlock();
+    llvm::Function*   fn   = from->getParent();
+    if (!scope_.trap) {
+        // trap: kind/line phis, one call, unreachable
+        const llvm::IRBuilderBase::InsertPointGuard guard(builder_);
+        scope_.trap = llvm::BasicBlock::Create(*context_, "arith.trap", fn);
+        builder_.SetInsertPoint(scope_.trap);
+        builder_.SetCurrentDebugLocation(
+            scope_.di ? llvm::DebugLoc(llvm::DILocation::get(*context_, 0, 0, scope_.di))
+                      : llvm::DebugLoc());
+        scope_.trapKind = builder_.CreatePHI(int32Ty_, 4, "kind");
+        scope_.trapLine = builder_.CreatePHI(int32Ty_, 4, "line");
+        builder_.CreateCall(arithErrorFn_, {scope_.trapKind, scope_.trapLine});
+        builder_.CreateUnreachable();
+        if (options_.ssa) sealBlock(scope_.trap);   // never reads a variable
+    }
+    auto* ok = llvm::BasicBlock::Create(*context_, "arith.ok", fn);
+    builder_.CreateCondBr(failed, scope_.trap, ok,
+                          llvm::MDBuilder(*context_).createBranchWeights(1, (1u << 20) - 1));
+    scope_.trapKind->addIncoming(kind, from);
+    scope_.trapLine->addIncoming(llvm::ConstantInt::get(int32Ty_, line), from);
+    if (options_.ssa) sealBlock(ok);
+    builder_.SetInsertPoint(ok);
+}
+
+llvm::Value* Codegen::emitDiv(llvm::Value* lhs, llvm::Value* rhs, int line) {
+    // A constant divisor other than 0 and -1 can neither fault nor overflow
+    const llvm::APInt* divisor = nullptr;
+    if (llvm::PatternMatch::match(rhs, llvm::PatternMatch::m_APInt(divisor)) &&
+        !divisor->isZero() && !divisor->isAllOnes())
+        return builder_.CreateSDiv(lhs, rhs, "div");
+
+    llvm::Type*  ty     = lhs->getType();
+    llvm::Value* zero   = llvm::Constant::getNullValue(ty);
+    llvm::Value* byZero = builder_.CreateICmpEQ(rhs, zero, "div.byzero");
+    llvm::Value* byNeg1 = builder_.CreateICmpEQ(rhs, llvm::Constant::getAllOnesValue(ty),
+                                                "div.byneg1");
+    auto kind = [&](int k) { return llvm::ConstantInt::get(int32Ty_, k); };
+    if (options_.arith == ArithMode::Trap) {
+        llvm::Value* min = llvm::ConstantInt::get(
+            ty, llvm::APInt::getSignedMinValue(ty->getScalarSizeInBits()));
+        llvm::Value* zeroAny = anyLane(builder_, byZero);
+        llvm::Value* overAny = anyLane(builder_, builder_.CreateAnd(
+            byNeg1, builder_.CreateICmpEQ(lhs, min), "div.overflow"));
+        trapIf(builder_.CreateOr(zeroAny, overAny),
+               builder_.CreateSelect(zeroAny, kind(NANO_DIVISION_BY_ZERO), kind(NANO_OVERFLOW)),
+               line);
+        return builder_.CreateSDiv(lhs, rhs, "div");
+    }
+    trapIf(anyLane(builder_, byZero), kind(NANO_DIVISION_BY_ZERO), line);
+    // x / -1 is -x, which wraps or saturates at MIN without sdiv's fault
+    llvm::Value* q = builder_.CreateSDiv(
+        lhs, builder_.CreateSelect(byNeg1, llvm::ConstantInt::get(ty, 1), rhs), "div");
+    llvm::Value* neg = options_.arith == ArithMode::Wrap
+        ? builder_.CreateNeg(lhs, "div.neg")
+        : builder_.CreateBinaryIntrinsic(llvm::Intrinsic::ssub_sat, zero, lhs, nullptr,
+                                         "div.neg");
+    return builder_.CreateSelect(byNeg1, neg, q, "div");
+}
+
+// `lhs op rhs` on int64s or on vectors of them; a comparison yields 1 or 0
+// per lane, like the interpreter
+llvm::Value* Codegen::emitBinOp(BinOp op, llvm::Value* lhs, llvm::Value* rhs, int line) {
+    auto& b = builder_;
+    if (op == BinOp::Div) return emitDiv(lhs, rhs, line);
+    if (op == BinOp::Add || op == BinOp::Sub || op == BinOp::Mul) {
+        switch (options_.arith) {
+            case ArithMode::Wrap:
+                break;
+            case ArithMode::Saturate:
+                if (op == BinOp::Mul)
+                    return b.CreateIntrinsic(llvm::Intrinsic::smul_fix_sat, {lhs->getType()},
+                                             {lhs, rhs, b.getInt32(0)}, nullptr, "mul");
+                return b.CreateBinaryIntrinsic(
+                    op == BinOp::Add ? llvm::Intrinsic::sadd_sat : llvm::Intrinsic::ssub_sat,
+                    lhs, rhs, nullptr, op == BinOp::Add ? "add" : "sub");
+            case ArithMode::Trap: {
+                const llvm::Intrinsic::ID id =
+                    op == BinOp::Add ? llvm::Intrinsic::sadd_with_overflow :
+                    op == BinOp::Sub ? llvm::Intrinsic::ssub_with_overflow :
+                                       llvm::Intrinsic::smul_with_overflow;
+                llvm::Value* checked = b.CreateBinaryIntrinsic(id, lhs, rhs, nullptr, "checked");
+                trapIf(anyLane(b, b.CreateExtractValue(checked, 1, "overflow")),
+                       llvm::ConstantInt::get(int32Ty_, NANO_OVERFLOW), line);
+                // Checked: the plain op below cannot wrap, and says so
+                return op == BinOp::Add ? b.CreateNSWAdd(lhs, rhs, "add") :
+                       op == BinOp::Sub ? b.CreateNSWSub(lhs, rhs, "sub") :
+                                          b.CreateNSWMul(lhs, rhs, "mul");
+            }
+        }
+    }
+    llvm::Value* cmp = nullptr;
+    switch (op) {
+        case BinOp::Add: return b.CreateAdd (lhs, rhs, "add");
+        case BinOp::Sub: return b.CreateSub (lhs, rhs, "sub");
+        case BinOp::Mul: return b.CreateMul (lhs, rhs, "mul");
+        case BinOp::Div: break;   // emitDiv
+        case BinOp::Eq:  cmp = b.CreateICmpEQ (lhs, rhs, "eq"); break;
+        case BinOp::Ne:  cmp = b.CreateICmpNE (lhs, rhs, "ne"); break;
+        case BinOp::Lt:  cmp = b.CreateICmpSLT(lhs, rhs, "lt"); break;
+        case BinOp::Gt:  cmp = b.CreateICmpSGT(lhs, rhs, "gt"); break;
+        case BinOp::Le:  cmp = b.CreateICmpSLE(lhs, rhs, "le"); break;
+        case BinOp::Ge:  cmp = b.CreateICmpSGE(lhs, rhs, "ge"); break;
+    }
+    return b.CreateZExt(cmp, lhs->getType(), "cmpext");
 }
 
 // ── Expression dispatch ───────────────────────────────────────────────────
@@ -295,70 +1209,497 @@ llvm::Value* Codegen::genExpr(const ExprNode& expr) {
         case NodeKind::Variable: {
             const auto& n = static_cast<const VariableNode&>(expr);
             setDebugLoc(n.line, n.col);
-            auto it = variables_.find(n.name);
-            if (it == variables_.end())
+            const std::string_view name = symbols_->name(n.name);
+            if (options_.ssa) {
+                if (!scope_.declared[n.name])
+                    throw std::runtime_error(
+                        "Undefined variable '" + std::string(name) + "' at line " +
+                        std::to_string(n.line));
+                return readVariable(n.name, builder_.GetInsertBlock());
+            }
+            llvm::AllocaInst* slot = scope_.variables[n.name];
+            if (!slot)
                 throw std::runtime_error(
-                    "Undefined variable '" + n.name + "' at line " +
+                    "Undefined variable '" + std::string(name) + "' at line " +
                     std::to_string(n.line));
-            return builder_.CreateLoad(int64Ty_, it->second, n.name);
+            return builder_.CreateLoad(int64Ty_, slot, llvm::StringRef(name));
         }
         case NodeKind::BinaryOp: {
             const auto& n    = static_cast<const BinaryOpNode&>(expr);
             llvm::Value* lhs = genExpr(*n.left);
             llvm::Value* rhs = genExpr(*n.right);
             setDebugLoc(n.line, n.col);
-
-            if (n.opStr == "+") return builder_.CreateAdd (lhs, rhs, "add");
-            if (n.opStr == "-") return builder_.CreateSub (lhs, rhs, "sub");
-            if (n.opStr == "*") return builder_.CreateMul (lhs, rhs, "mul");
-            if (n.opStr == "/") return builder_.CreateSDiv(lhs, rhs, "div");
-
-            llvm::Value* cmp = nullptr;
-            if      (n.opStr == "==") cmp = builder_.CreateICmpEQ (lhs, rhs, "eq");
-            else if (n.opStr == "!=") cmp = builder_.CreateICmpNE (lhs, rhs, "ne");
-            else if (n.opStr == "<")  cmp = builder_.CreateICmpSLT(lhs, rhs, "lt");
-            else if (n.opStr == ">")  cmp = builder_.CreateICmpSGT(lhs, rhs, "gt");
-            else if (n.opStr == "<=") cmp = builder_.CreateICmpSLE(lhs, rhs, "le");
-            else if (n.opStr == ">=") cmp = builder_.CreateICmpSGE(lhs, rhs, "ge");
-            else throw std::runtime_error("Unknown operator: " + n.opStr);
-            return builder_.CreateSExt(cmp, int64Ty_, "cmpext");
+            return emitBinOp(n.op, lhs, rhs, n.line);
+        }
+        case NodeKind::Index: {
+            const auto&         n     = static_cast<const IndexNode&>(expr);
+            const ArrayStorage& array = arrayOf(n.array, n.line);
+            llvm::Value*        index = genExpr(*n.index);
+            setDebugLoc(n.line, n.col);
+            return builder_.CreateAlignedLoad(int64Ty_, elementPtr(array, index, n.line),
+                                              llvm::Align(8), symbols_->name(n.array));
+        }
+        case NodeKind::Call: {
+            const auto& n = static_cast<const CallNode&>(expr);
+            llvm::SmallVector<llvm::Value*, 4> args;
+            for (const ExprNode* arg : n.args) args.push_back(genExpr(*arg));
+            setDebugLoc(n.line, n.col);
+            return builder_.CreateCall(functions_[n.function], args, "call");
         }
         default:
             throw std::runtime_error("Unknown expression kind in codegen");
     }
 }
 
+// ── Arrays ────────────────────────────────────────────────────────────────
+// Element-wise expressions are lowered straight to vector IR rather than
+// left for the loop vectoriser: every operand of `a + b * 2` is already a
+// contiguous, aligned block of known length, so there is nothing to prove.
+
+Codegen::ArrayStorage Codegen::createArrayStorage(llvm::Function* fn, SymbolId id,
+                                                  uint32_t length, int line) {
+    auto*          type  = llvm::ArrayType::get(int64Ty_, length);
+    const uint64_t bytes = uint64_t(length) * 8;
+    const llvm::StringRef name = id != NO_ARRAY_VAR ? llvm::StringRef(symbols_->name(id))
+                                                    : llvm::StringRef("tmp");
+    ArrayStorage storage;
+    storage.length = length;
+    // A whole number of chunks per cache line, so no vector access splits one
+    storage.align  = llvm::Align(std::min<uint64_t>(64, llvm::PowerOf2Ceil(bytes)));
+
+    llvm::DIType* diTy = nullptr;
+    if (diBuilder_ && id != NO_ARRAY_VAR)
+        diTy = diBuilder_->createArrayType(
+            bytes * 8, static_cast<uint32_t>(storage.align.value() * 8), diInt64Ty_,
+            diBuilder_->getOrCreateArray({diBuilder_->getOrCreateSubrange(0, length)}));
+
+    // A function may be active many times over, each call with its own
+    if (bytes <= ARRAY_STACK_LIMIT || !scope_.once) {
+        llvm::AllocaInst* alloca = createEntryAlloca(fn, name, type);
+        alloca->setAlignment(storage.align);
+        storage.ptr = alloca;
+        if (diTy) {
+            auto* diVar = diBuilder_->createAutoVariable(
+                scope_.di, name, diFile_, static_cast<unsigned>(line), diTy);
+            auto* loc = llvm::DILocation::get(*context_, static_cast<unsigned>(line), 0,
+                                              scope_.di);
+            diBuilder_->insertDeclare(alloca, diVar, diBuilder_->createExpression(), loc,
+                                      builder_.GetInsertBlock());
+        }
+    } else {
+        // Zeroed like a fresh slot, and main runs once, so a global is
+        // indistinguishable from a stack array there
+        auto* global = new llvm::GlobalVariable(
+            *module_, type, /*isConstant=*/false, llvm::GlobalValue::InternalLinkage,
+            llvm::ConstantAggregateZero::get(type), name);
+        global->setAlignment(storage.align);
+        storage.ptr = global;
+        if (diTy)
+            global->addDebugInfo(diBuilder_->createGlobalVariableExpression(
+                scope_.di, name, name, diFile_, static_cast<unsigned>(line), diTy,
+                /*IsLocalToUnit=*/true));
+    }
+    scope_.arrayLog.push_back({id, storage.ptr});
+    return storage;
+}
+
+const Codegen::ArrayStorage& Codegen::arrayOf(SymbolId id, int line) const {
+    const ArrayStorage& array = scope_.arrays[id];
+    if (!array.ptr)
+        throw std::runtime_error("Undefined variable '" + std::string(symbols_->name(id)) +
+                                 "' at line " + std::to_string(line));
+    return array;
+}
+
+llvm::Value* Codegen::elementPtr(const ArrayStorage& array, llvm::Value* index, int line) {
+    auto* known = llvm::dyn_cast<llvm::ConstantInt>(index);
+    if (!known || known->getValue().uge(array.length)) {
+        // Unsigned, so a negative index is out of range too
+        llvm::Function* fn = builder_.GetInsertBlock()->getParent();
+        auto* length = llvm::ConstantInt::get(int64Ty_, array.length);
+        auto* failBB = llvm::BasicBlock::Create(*context_, "index.fail", fn);
+        auto* okBB   = llvm::BasicBlock::Create(*context_, "index.ok",   fn);
+        builder_.CreateCondBr(builder_.CreateICmpUGE(index, length, "oob"), failBB, okBB);
+        if (options_.ssa) {
+            sealBlock(failBB);
+            sealBlock(okBB);
+        }
+        builder_.SetInsertPoint(failBB);
+        builder_.CreateCall(indexErrorFn_,
+                            {index, length, llvm::ConstantInt::get(int32Ty_, line)});
+        builder_.CreateUnreachable();
+        builder_.SetInsertPoint(okBB);
+    }
+    return builder_.CreateInBoundsGEP(int64Ty_, array.ptr, index, "elem");
+}
+
+void Codegen::storeArray(const ArrayStorage& dst, const ExprNode& expr) {
+    if (expr.kind == NodeKind::ArrayLiteral) {
+        const auto& n = static_cast<const ArrayLiteralNode&>(expr);
+        llvm::SmallVector<llvm::Value*, 16> values;
+        for (const ExprNode* el : n.elements)
+            values.push_back(genExpr(*el));
+        setDebugLoc(n.line, n.col);
+        for (uint32_t i = 0; i < n.elements.size; ++i)
+            builder_.CreateAlignedStore(
+                values[i], builder_.CreateConstInBoundsGEP1_64(int64Ty_, dst.ptr, i),
+                llvm::commonAlignment(dst.align, uint64_t(i) * 8));
+        return;
+    }
+
+    llvm::SmallVector<llvm::Value*, 8> scalars;
+    hoistScalars(expr, scalars);
+    setDebugLoc(expr.line, expr.col);
+    const uint32_t full = dst.length / LANES * LANES;
+
+    if (full > LANES) {
+        // for (offset = 0; offset < full; offset += LANES), already in the
+        // rotated form LoopRotate would give it
+        llvm::BasicBlock* preheader = builder_.GetInsertBlock();
+        llvm::Function*   fn        = preheader->getParent();
+        auto* bodyBB = llvm::BasicBlock::Create(*context_, "bulk.body", fn);
+        auto* doneBB = llvm::BasicBlock::Create(*context_, "bulk.done");
+        builder_.CreateBr(bodyBB);
+
+        builder_.SetInsertPoint(bodyBB);
+        llvm::PHINode* offset = builder_.CreatePHI(int64Ty_, 2, "offset");
+        offset->addIncoming(llvm::ConstantInt::get(int64Ty_, 0), preheader);
+        storeLanes(dst, expr, offset, LANES, LANES * 8, scalars);
+        setDebugLoc(expr.line, expr.col);
+        llvm::Value* next = builder_.CreateAdd(offset, llvm::ConstantInt::get(int64Ty_, LANES),
+                                               "offset.next", /*HasNUW=*/true, /*HasNSW=*/true);
+        offset->addIncoming(next, builder_.GetInsertBlock());   // checks split the body
+        llvm::Value* more = builder_.CreateICmpULT(next, llvm::ConstantInt::get(int64Ty_, full),
+                                                   "bulk.more");
+        llvm::BranchInst* backEdge = builder_.CreateCondBr(more, bodyBB, doneBB);
+        // Vector code already: keep the vectoriser from widening it again
+        backEdge->setMetadata(
+            llvm::LLVMContext::MD_loop,
+            loopID(*context_, {llvm::MDNode::get(*context_, {
+                       llvm::MDString::get(*context_, "llvm.loop.isvectorized"),
+                       llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(int32Ty_, 1))})}));
+
+        doneBB->insertInto(fn);
+        builder_.SetInsertPoint(doneBB);
+        if (options_.ssa) {   // nothing in the body reads a variable
+            sealBlock(bodyBB);
+            sealBlock(doneBB);
+        }
+    } else if (full == LANES) {
+        storeLanes(dst, expr, llvm::ConstantInt::get(int64Ty_, 0), LANES, 0, scalars);
+    }
+    if (full < dst.length)
+        storeLanes(dst, expr, llvm::ConstantInt::get(int64Ty_, full), dst.length - full,
+                   uint64_t(full) * 8, scalars);
+}
+
+// Every int64 operand (and repeated value) in evaluation order, computed
+// once before the chunks
+void Codegen::hoistScalars(const ExprNode& expr, llvm::SmallVectorImpl<llvm::Value*>& out) {
+    if (expr.length == 0) {
+        out.push_back(genExpr(expr));
+        return;
+    }
+    switch (expr.kind) {
+        case NodeKind::Variable: {
+            const auto& n = static_cast<const VariableNode&>(expr);
+            arrayOf(n.name, n.line);
+            break;
+        }
+        case NodeKind::ArrayRepeat:
+            out.push_back(genExpr(*static_cast<const ArrayRepeatNode&>(expr).value));
+            break;
+        case NodeKind::BinaryOp: {
+            const auto& n = static_cast<const BinaryOpNode&>(expr);
+            hoistScalars(*n.left,  out);
+            hoistScalars(*n.right, out);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown array expression kind in codegen");
+    }
+}
+
+llvm::Value* Codegen::genLanes(const ExprNode& expr, llvm::Value* offset, uint32_t width,
+                               uint64_t offsetBytes, llvm::ArrayRef<llvm::Value*> scalars,
+                               size_t& next) {
+    if (expr.length == 0 || expr.kind == NodeKind::ArrayRepeat)
+        return builder_.CreateVectorSplat(width, scalars[next++], "splat");
+    if (expr.kind == NodeKind::Variable) {
+        const auto&         n   = static_cast<const VariableNode&>(expr);
+        const ArrayStorage& src = scope_.arrays[n.name];
+        setDebugLoc(n.line, n.col);
+        return builder_.CreateAlignedLoad(
+            llvm::FixedVectorType::get(int64Ty_, width),
+            builder_.CreateInBoundsGEP(int64Ty_, src.ptr, offset, "lanes.ptr"),
+            llvm::commonAlignment(src.align, offsetBytes), symbols_->name(n.name));
+    }
+    const auto&  n   = static_cast<const BinaryOpNode&>(expr);
+    llvm::Value* lhs = genLanes(*n.left,  offset, width, offsetBytes, scalars, next);
+    llvm::Value* rhs = genLanes(*n.right, offset, width, offsetBytes, scalars, next);
+    setDebugLoc(n.line, n.col);
+    return emitBinOp(n.op, lhs, rhs, n.line);
+}
+
+void Codegen::storeLanes(const ArrayStorage& dst, const ExprNode& expr, llvm::Value* offset,
+                         uint32_t width, uint64_t offsetBytes,
+                         llvm::ArrayRef<llvm::Value*> scalars) {
+    size_t       next  = 0;
+    llvm::Value* value = genLanes(expr, offset, width, offsetBytes, scalars, next);
+    setDebugLoc(expr.line, expr.col);
+    builder_.CreateAlignedStore(
+        value, builder_.CreateInBoundsGEP(int64Ty_, dst.ptr, offset, "lanes.ptr"),
+        llvm::commonAlignment(dst.align, offsetBytes));
+}
+
+void Codegen::genIndexAssign(const IndexAssignNode& node) {
+    setDebugLoc(node.line, node.col);
+    const ArrayStorage& array = arrayOf(node.array, node.line);
+    llvm::Value*        index = genExpr(*node.index);
+    llvm::Value*        value = genExpr(*node.value);
+    setDebugLoc(node.line, node.col);
+    builder_.CreateAlignedStore(value, elementPtr(array, index, node.line), llvm::Align(8));
+}
+
+// ── Per-pass timing ───────────────────────────────────────────────────────
+// Exclusive time per pass and analysis: a nested one pauses its parent, as
+// in LLVM's TimePassesHandler. Pass managers and adaptors are not counted.
+
+namespace {
+
+class PassTimer {
+public:
+    /// Where to charge passes from now on; nullptr stops recording.
+    void setReport(TimeReport* report) {
+        report_ = report;
+        stack_.clear();
+    }
+
+    void attach(llvm::PassInstrumentationCallbacks& pic) {
+        pic.registerBeforeNonSkippedPassCallback(
+            [this](llvm::StringRef p, llvm::Any) { if (!special(p)) start(p); });
+        pic.registerAfterPassCallback(
+            [this](llvm::StringRef p, llvm::Any, const llvm::PreservedAnalyses&) {
+                if (!special(p)) stop();
+            });
+        pic.registerAfterPassInvalidatedCallback(
+            [this](llvm::StringRef p, const llvm::PreservedAnalyses&) {
+                if (!special(p)) stop();
+            });
+        pic.registerBeforeAnalysisCallback(
+            [this](llvm::StringRef p, llvm::Any) { start(p); });
+        pic.registerAfterAnalysisCallback(
+            [this](llvm::StringRef, llvm::Any) { stop(); });
+    }
+
+private:
+    struct Running {
+        llvm::StringRef name;
+        double wallStart, cpuStart;
+        double wall = 0, cpu = 0;
+    };
+
+    static bool special(llvm::StringRef pass) {
+        return llvm::isSpecialPass(pass, {"PassManager", "PassAdaptor",
+                                          "AnalysisManagerProxy",
+                                          "ModuleInlinerWrapperPass",
+                                          "DevirtSCCRepeatedPass"});
+    }
+
+    void start(llvm::StringRef name) {
+        if (!report_) return;
+        const double wall = TimeReport::wallSeconds(), cpu = TimeReport::threadCPUSeconds();
+        if (!stack_.empty()) {
+            Running& parent = stack_.back();
+            parent.wall += wall - parent.wallStart;
+            parent.cpu  += cpu  - parent.cpuStart;
+        }
+        stack_.push_back({name, wall, cpu});
+    }
+
+    void stop() {
+        if (!report_ || stack_.empty()) return;
+        const double wall = TimeReport::wallSeconds(), cpu = TimeReport::threadCPUSeconds();
+        Running done = stack_.back();
+        stack_.pop_back();
+        report_->addPass(done.name, done.wall + (wall - done.wallStart),
+                        done.cpu + (cpu - done.cpuStart));
+        if (!stack_.empty()) {
+            stack_.back().wallStart = wall;
+            stack_.back().cpuStart  = cpu;
+        }
+    }
+
+    TimeReport*          report_ = nullptr;
+    std::vector<Running> stack_;
+};
+
+// ── Per-thread pipeline ───────────────────────────────────────────────────
+// The PassBuilder, its four analysis managers and every pipeline it builds
+// depend on no module or context — only on the target, whose TargetMachine
+// supplies the cost model — so each thread builds them once per target and
+// reuses them for every module it optimises. Cached analysis results are
+// dropped after each run — they point into the old module. A profile is
+// the PassBuilder's too, so it is part of the key.
+
+class OptPipeline {
+public:
+    static OptPipeline& forThisThread(const TargetSpec& target, const CodegenOptions& options) {
+        thread_local std::unordered_map<std::string, std::unique_ptr<OptPipeline>> pipelines;
+        auto& slot = pipelines[target.triple + '\n' + target.cpu + '\n' + target.features +
+                               '\n' + (options.profileGenerate ? "gen" : "") +
+                               '\n' + options.profileUse +
+                               (options.wasmStartup ? "\nOz" : "")];
+        if (!slot) slot.reset(new OptPipeline(target, options));
+        return *slot;
+    }
+
+    void run(llvm::Module& module, BuildConfig config, bool thinLTO, TimeReport* timing) {
+        llvm::ModulePassManager& mpm = pipeline(config, thinLTO);
+        timer_.setReport(timing);
+        mpm.run(module, mam_);
+        timer_.setReport(nullptr);
+        mam_.clear();
+        cgam_.clear();
+        fam_.clear();
+        lam_.clear();
+    }
+
+private:
+    OptPipeline(const TargetSpec& target, const CodegenOptions& options)
+        : tm_(createTargetMachine(target, llvm::CodeGenOptLevel::Default)),
+          pgo_(pgoOptions(options)), size_(options.wasmStartup),
+          pb_(tm_.get(), tuning(size_), pgo_, &pic_) {
+        timer_.attach(pic_);
+        // Vectoriser, unroller and inliner ask TTI what the target can do;
+        // registered first, so it wins over PassBuilder's default
+        fam_.registerPass([this] { return tm_->getTargetIRAnalysis(); });
+        pb_.registerModuleAnalyses(mam_);
+        pb_.registerCGSCCAnalyses(cgam_);
+        pb_.registerFunctionAnalyses(fam_);
+        pb_.registerLoopAnalyses(lam_);
+        pb_.crossRegisterProxies(lam_, fam_, cgam_, mam_);
+    }
+
+    // What clang enables from -O2 up: the O2 / O3 / LTO pipelines run the
+    // loop vectoriser, interleaving, unrolling and the SLP vectoriser.
+    // (Debug and Fast build their own pipelines and never see these.) At
+    // -Oz clang enables none of them: each trades bytes for speed.
+    static llvm::PipelineTuningOptions tuning(bool size) {
+        llvm::PipelineTuningOptions pto;
+        pto.LoopVectorization = !size;
+        pto.LoopInterleaving  = !size;
+        pto.LoopUnrolling     = !size;
+        pto.SLPVectorization  = !size;
+        return pto;
+    }
+
+    // IRInstr adds PGOInstrumentationGen and the counters' lowering, IRUse
+    // PGOInstrumentationUse, where clang's pipelines put them: after early
+    // simplification, before the inliner — the instrumented build and the
+    // build that reads its counts see the same CFG.
+    static std::optional<llvm::PGOOptions> pgoOptions(const CodegenOptions& options) {
+        if (!options.profiled()) return std::nullopt;
+        const bool gen = options.profileGenerate;
+        return llvm::PGOOptions(gen ? "" : options.profileUse, /*CSProfileGenFile=*/"",
+                                /*ProfileRemappingFile=*/"", /*MemoryProfile=*/"",
+                                llvm::vfs::getRealFileSystem(),
+                                gen ? llvm::PGOOptions::IRInstr : llvm::PGOOptions::IRUse);
+    }
+
+    // --wasm-startup: the PassBuilder pipelines optimise for size
+    llvm::OptimizationLevel level(llvm::OptimizationLevel speed) const {
+        return size_ ? llvm::OptimizationLevel::Oz : speed;
+    }
+
+    llvm::ModulePassManager& pipeline(BuildConfig config, bool thinLTO) {
+        auto& slot = thinLTO ? thinPreLink_ : pipelines_[static_cast<size_t>(config)];
+        if (slot) return *slot;
+        if (thinLTO) {
+            // Inlining and whole-program work wait for the link, where the
+            // summaries of every module are at hand
+            slot.emplace(
+                pb_.buildThinLTOPreLinkDefaultPipeline(level(llvm::OptimizationLevel::O3)));
+            return *slot;
+        }
+
+        switch (config) {
+            case BuildConfig::Debug:
+                slot.emplace();   // empty: Debug runs no passes
+                break;
+            case BuildConfig::Fast: {
+                // Promote slots to SSA (SROA subsumes mem2reg), then the
+                // cheap cleanups that recover most of O2 on scalar code.
+                llvm::FunctionPassManager fpm;
+                fpm.addPass(llvm::SROAPass(llvm::SROAOptions::ModifyCFG));
+                fpm.addPass(llvm::InstCombinePass());
+                fpm.addPass(llvm::SimplifyCFGPass());
+                fpm.addPass(llvm::GVNPass());
+                // Run per SCC, callees first, interleaved with the inliner:
+                // a callee is cleaned up before its cost is judged, and a
+                // caller is cleaned up after its calls are inlined. Then
+                // drop the functions nothing calls any more.
+                llvm::ModuleInlinerWrapperPass inliner(llvm::getInlineParams(1, 0));
+                inliner.getPM().addPass(llvm::createCGSCCToFunctionPassAdaptor(std::move(fpm)));
+                slot.emplace();
+                slot->addPass(std::move(inliner));
+                slot->addPass(llvm::GlobalDCEPass());
+                break;
+            }
+            case BuildConfig::Development:
+                slot.emplace(
+                    pb_.buildPerModuleDefaultPipeline(level(llvm::OptimizationLevel::O2)));
+                break;
+            case BuildConfig::Shipping: {
+                // Full LTO pipeline at O3 — whole-program optimisation
+                // ExportSummary=nullptr: single-module build, no cross-module index needed
+                const llvm::OptimizationLevel o3 = level(llvm::OptimizationLevel::O3);
+                slot.emplace();
+                // The LTO pipeline expects the profile already applied: run
+                // the pre-link pipeline first, as `clang -flto` would
+                if (pgo_)
+                    slot->addPass(pb_.buildLTOPreLinkDefaultPipeline(o3));
+                slot->addPass(pb_.buildLTODefaultPipeline(o3, nullptr));
+                break;
+            }
+        }
+        return *slot;
+    }
+
+    // Declaration order matters: the callbacks and the TargetMachine
+    // outlive the PassBuilder and analyses that point at them, and the
+    // managers are torn down innermost-first.
+    PassTimer                            timer_;
+    llvm::PassInstrumentationCallbacks   pic_;
+    std::unique_ptr<llvm::TargetMachine> tm_;
+    std::optional<llvm::PGOOptions>      pgo_;
+    bool                                 size_;
+    llvm::PassBuilder                    pb_;
+    llvm::LoopAnalysisManager          lam_;
+    llvm::FunctionAnalysisManager      fam_;
+    llvm::CGSCCAnalysisManager         cgam_;
+    llvm::ModuleAnalysisManager        mam_;
+    std::optional<llvm::ModulePassManager> pipelines_[4];   // by BuildConfig
+    std::optional<llvm::ModulePassManager> thinPreLink_;    // Shipping + ThinLTO
+};
+
+} // namespace
+
 // ── Optimisation pipeline ─────────────────────────────────────────────────
 
 void Codegen::optimize() {
-    if (config_ == BuildConfig::Debug) return;
-
-    llvm::PassBuilder            pb;
-    llvm::LoopAnalysisManager    lam;
-    llvm::FunctionAnalysisManager fam;
-    llvm::CGSCCAnalysisManager   cgam;
-    llvm::ModuleAnalysisManager  mam;
-
-    pb.registerModuleAnalyses(mam);
-    pb.registerCGSCCAnalyses(cgam);
-    pb.registerFunctionAnalyses(fam);
-    pb.registerLoopAnalyses(lam);
-    pb.crossRegisterProxies(lam, fam, cgam, mam);
-
-    llvm::ModulePassManager mpm;
-    if (config_ == BuildConfig::Development) {
-        mpm = pb.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
-    } else {
-        // Shipping: full LTO pipeline at O3 — whole-program optimisation
-        // ExportSummary=nullptr: single-module build, no cross-module index needed
-        mpm = pb.buildLTODefaultPipeline(llvm::OptimizationLevel::O3, nullptr);
-    }
-    mpm.run(*module_, mam);
+    if (config_ == BuildConfig::Debug || optimizesPieces()) return;
+    OptPipeline::forThisThread(target_, options_).run(*module_, config_, thinLTO(), timing_);
+}
+
+bool Codegen::thinLTO() const {
+    return config_ == BuildConfig::Shipping && options_.lto == LTOMode::Thin;
 }
 
 // ── IR output ─────────────────────────────────────────────────────────────
 
 void Codegen::writeIR(const std::string& outputPath) {
+    TimeReport::Scope t(timing_, "emit");
     std::error_code ec;
     llvm::raw_fd_ostream out(outputPath, ec, llvm::sys::fs::OF_Text);
     if (ec)
@@ -366,3 +1707,156 @@ void Codegen::writeIR(const std::string& outputPath) {
                                  "': " + ec.message());
     module_->print(out, nullptr);
 }
+
+void Codegen::writeBitcode(const std::string& outputPath) {
+    TimeReport::Scope t(timing_, "emit");
+    std::error_code ec;
+    llvm::raw_fd_ostream out(outputPath, ec, llvm::sys::fs::OF_None);
+    if (ec)
+        throw std::runtime_error("Cannot open output file '" + outputPath +
+                                 "': " + ec.message());
+    if (!thinLTO()) {
+        llvm::WriteBitcodeToFile(*module_, out);
+        return;
+    }
+    // No profile: the summary carries call edges and linkage, not counts
+    llvm::ProfileSummaryInfo       psi(*module_);
+    const llvm::ModuleSummaryIndex index =
+        llvm::buildModuleSummaryIndex(*module_, /*GetBFICallback=*/nullptr, &psi);
+    llvm::WriteBitcodeToFile(*module_, out, /*ShouldPreserveUseListOrder=*/false, &index);
+}
+
+// ── Module hand-off ───────────────────────────────────────────────────────
+
+void Codegen::releaseModule() {
+    takeModule();   // and drop it: the handle frees the module, then its context
+}
+
+ModuleHandle Codegen::takeModule() {
+    // Drop everything that still points into the context, so the caller
+    // may destroy it independently of this Codegen.
+    builder_.ClearInsertionPoint();
+    builder_.SetCurrentDebugLocation(llvm::DebugLoc());
+    diBuilder_.reset();
+    targetMachine_.reset();
+    scope_ = Scope{};
+    functions_.clear();
+    checkpoints_.clear();
+    mainFn_ = nullptr;
+    lineHits_ = lineLabels_ = lineTable_ = nullptr;
+    currentDef_.clear();
+    incompletePhis_.clear();
+    sealed_.clear();
+    return {std::move(context_), std::move(module_)};
+}
+
+// ── Machine-code output ───────────────────────────────────────────────────
+
+llvm::TargetMachine& Codegen::targetMachine() {
+    if (!targetMachine_)
+        targetMachine_ = createTargetMachine(target_, codeGenOptLevel(config_));
+    return *targetMachine_;
+}
+
+void Codegen::emitMachineCode(const std::string& outputPath,
+                              llvm::CodeGenFileType type) {
+    TimeReport::Scope t(timing_, "emit");
+    emitModule(*module_, targetMachine(), outputPath, type);
+}
+
+void Codegen::emitModule(llvm::Module& module, llvm::TargetMachine& tm,
+                         const std::string& outputPath, llvm::CodeGenFileType type) {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(outputPath, ec,
+                             type == llvm::CodeGenFileType::AssemblyFile
+                                 ? llvm::sys::fs::OF_Text
+                                 : llvm::sys::fs::OF_None);
+    if (ec)
+        throw std::runtime_error("Cannot open output file '" + outputPath +
+                                 "': " + ec.message());
+
+    llvm::legacy::PassManager pm;
+    if (tm.addPassesToEmitFile(pm, out, /*DwoOut=*/nullptr, type))
+        throw std::runtime_error("Target '" + module.getTargetTriple().str() +
+                                 "' cannot emit this file type");
+    pm.run(module);
+    out.flush();
+}
+
+void Codegen::writeObject(const std::string& outputPath) {
+    emitMachineCode(outputPath, llvm::CodeGenFileType::ObjectFile);
+}
+
+void Codegen::writeAssembly(const std::string& outputPath) {
+    emitMachineCode(outputPath, llvm::CodeGenFileType::AssemblyFile);
+}
+
+// ── Partitioned output ────────────────────────────────────────────────────
+// The module is cut as llvm::SplitModule cuts it: internal symbols become
+// hidden externals so the pieces can refer to each other. An LLVMContext
+// is not thread-safe, so each piece travels as bitcode to a worker that
+// reads it into a context of its own, optimises it and emits its object.
+
+std::vector<std::string> Codegen::writeObjects(const std::string& prefix,
+                                               const std::string& suffix) {
+    auto optimizePiece = [this](llvm::Module& piece) {
+        if (!optimizesPieces() || config_ == BuildConfig::Debug) return;
+        TimeReport::Scope t(timing_, "optimize");
+        OptPipeline::forThisThread(target_, options_).run(piece, config_, /*thinLTO=*/false,
+                                                          timing_);
+    };
+
+    unsigned defined = 0;
+    for (const llvm::Function& fn : *module_) defined += !fn.isDeclaration();
+    const unsigned parts = std::min(options_.partitions, defined);
+    if (parts <= 1) {
+        optimizePiece(*module_);
+        writeObject(prefix + suffix);
+        return {prefix + suffix};
+    }
+
+    std::vector<llvm::SmallString<0>> bitcode;
+    {
+        TimeReport::Scope t(timing_, "split");
+        llvm::SplitModule(*module_, parts, [&](std::unique_ptr<llvm::Module> piece) {
+            llvm::raw_svector_ostream os(bitcode.emplace_back());
+            llvm::WriteBitcodeToFile(*piece, os);
+        });
+    }
+
+    std::vector<std::string>        paths(bitcode.size());
+    std::vector<std::exception_ptr> errors(bitcode.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+        paths[i] = i == 0 ? prefix + suffix : prefix + "." + std::to_string(i) + suffix;
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < bitcode.size(); i = next++) {
+            try {
+                llvm::LLVMContext context;
+                auto piece = llvm::parseBitcodeFile(
+                    llvm::MemoryBufferRef(bitcode[i].str(), paths[i]), context);
+                if (!piece)
+                    throw std::runtime_error("Cannot re-read module piece: " +
+                                             llvm::toString(piece.takeError()));
+                optimizePiece(**piece);
+                TimeReport::Scope t(timing_, "emit");
+                const auto tm = createTargetMachine(target_, codeGenOptLevel(config_));
+                emitModule(**piece, *tm, paths[i], llvm::CodeGenFileType::ObjectFile);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(parts - 1);
+    for (unsigned w = 1; w < parts; ++w)
+        pool.emplace_back(worker);
+    worker();   // the calling thread takes a piece too
+    for (auto& t : pool)
+        t.join();
+
+    for (const std::exception_ptr& e : errors)
+        if (e) std::rethrow_exception(e);
+    return paths;
+}
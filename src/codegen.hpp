@@ -1,56 +1,293 @@
 #pragma once
+#include "arith.hpp"
 #include "ast.hpp"
+#include "timing.hpp"
 
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Value.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/Target/TargetMachine.h>
 
-#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 enum class BuildConfig {
     Debug,        // O0  + full DWARF
+    Fast,         // SROA, instcombine, simplifycfg, GVN + full DWARF
     Development,  // O2  + full DWARF
     Shipping      // O3 (LTO) + no debug info
 };
 
+/// Backend (instruction selection / scheduling) level for a config.
+llvm::CodeGenOptLevel codeGenOptLevel(BuildConfig config);
+
+/// Register every LLVM backend (native + wasm32) once per process.
+void initializeLLVMTargets();
+
+/// A finished module together with the context that owns its types —
+/// what ORC's ThreadSafeModule and other out-of-Codegen consumers need.
+struct ModuleHandle {
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module>      module;
+};
+
+/// The machine code is generated for. Empty fields take the defaults.
+struct TargetSpec {
+    std::string triple;     // default: the host, or wasm32-unknown-wasi with --wasm
+    std::string cpu;        // default: "generic"; "native" is the host CPU
+                            // together with every feature it has
+    std::string features;   // e.g. "+avx2,+fma,-avx512f", on top of the CPU's
+};
+
+/// `spec` with every default filled in and "native" replaced by the host
+/// CPU name and feature string. Throws on a triple LLVM has no backend for,
+/// or "native" for a triple other than the host's. `wasmStartup` turns on
+/// WASM_STARTUP_FEATURES ahead of spec's own features.
+TargetSpec resolveTarget(const TargetSpec& spec, bool wasm, bool wasmStartup = false);
+
+/// What --wasm-startup enables: every engine that runs wasm32-wasi today
+/// validates them, and each one shortens code the engine must compile.
+inline constexpr const char* WASM_STARTUP_FEATURES = "+simd128,+bulk-memory,+sign-ext";
+
+/// A TargetMachine for a resolved spec (PIC, as every artifact links -pie).
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(const TargetSpec& target,
+                                                         llvm::CodeGenOptLevel level);
+
+/// How a Shipping build does link-time optimisation.
+enum class LTOMode {
+    Full,   // O3 LTO pipeline on the module here; the linker gets an object
+    Thin,   // ThinLTO pre-link pipeline here; the linker gets bitcode with a
+            // summary and runs the O3 backend, importing across modules
+};
+
+/// Lowering and optimisation choices that sit beside the build config.
+struct CodegenOptions {
+    /// Build SSA values directly (phis at `if` merges, dbg.value for DWARF)
+    /// instead of an entry-block alloca per variable with loads and stores.
+    bool ssa = false;
+    /// Shipping only; every other config ignores it.
+    LTOMode lto = LTOMode::Full;
+    /// What +, -, * and / do on overflow. Trap adds `nsw` to the checked
+    /// operations: the check has ruled out wrapping.
+    ArithMode arith = ArithMode::Wrap;
+    /// Triple, CPU and features: the data layout, the target-cpu /
+    /// target-features of every function and the optimiser's cost model.
+    TargetSpec target;
+    /// Up to this many pieces for writeObjects(), each optimised and
+    /// emitted on its own thread in its own context (1: never split).
+    /// Except under Shipping, optimisation is left to the pieces: only set
+    /// it for a module emitted through writeObjects().
+    unsigned partitions = 1;
+    /// Development and Shipping: instrument the optimised module to count
+    /// its edges and calls (PGOInstrumentationGen). A run of the program
+    /// writes default_<id>.profraw, or $LLVM_PROFILE_FILE; link the result
+    /// with profileRuntime().
+    bool profileGenerate = false;
+    /// Development and Shipping: a .profdata (`llvm-profdata merge`) from
+    /// an instrumented build of the same program and flags, whose counts
+    /// give branches their weights and guide inlining and block layout.
+    std::string profileUse;
+
+    /// --instrument=lines: count every execution of every statement in a
+    /// counter of its own, bumped atomically; the runtime writes the counts
+    /// out at exit as folded stacks (nano_lines_dump).
+    bool instrumentLines = false;
+    /// --wasm only: tuned for cold start, where compiling the module is
+    /// most of the cost. WASM_STARTUP_FEATURES, and the size pipeline (Oz,
+    /// minsize) in place of O2 / O3.
+    bool wasmStartup = false;
+
+    bool profiled() const { return profileGenerate || !profileUse.empty(); }
+};
+
 class Codegen {
 public:
     /// sourceFile — basename of the .nano file (e.g. "hello.nano")
     /// sourceDir  — directory that contains it (e.g. "/home/user/examples")
     /// config     — optimisation level and debug-info presence
-    /// wasm       — true → wasm32-wasi target; false → native ARM64
+    /// wasm       — true → wasm32-wasi target; false → native (options.target)
+    /// options    — lowering choices (see CodegenOptions)
     Codegen(const std::string& sourceFile, const std::string& sourceDir,
             BuildConfig config = BuildConfig::Debug,
-            bool wasm = false);
+            bool wasm = false,
+            CodegenOptions options = {});
 
+    /// Record codegen / optimize / verify / emit phases and per-pass cost
+    /// of the pipeline into `report` (nullptr — the default — disables).
+    void setTimeReport(TimeReport* report) { timing_ = report; }
+
+    /// Lower `program`, then optimizeAndVerify().
     void generate(const ProgramNode& program);
+    /// generate() in two steps, so the caller can free the AST before the
+    /// pipeline runs: nothing after lower() reads the program.
+    void lower(const ProgramNode& program);
+    void optimizeAndVerify();
+
+    /// lower() for a program that arrives one top-level statement at a time
+    /// (--max-memory), each free to go once it is lowered. beginStream()
+    /// takes a program holding only the function definitions, all of them
+    /// (a call may precede its callee); its symbol table must outlive the
+    /// stream. Every other statement goes to lowerStatement() in source
+    /// order, then endStream() closes main. The caller times the stream.
+    void beginStream(const ProgramNode& functions);
+    void lowerStatement(const StmtNode& stmt);
+    void endStream();
+
+    /// Watch mode: (re)build main from top-level statement `first` onward,
+    /// keeping the IR of the statements before it. A checkpoint is taken
+    /// before every statement, so the next call can cut main back to any of
+    /// them. The resident module is left unoptimised — emit through
+    /// withSnapshot(). SSA lowering keeps no checkpoints: it always
+    /// rebuilds from the first statement.
+    void generateFrom(const ProgramNode& program, size_t first);
+
+    /// Run `emit` (writeObject, writeIR, …) against an optimised, verified
+    /// copy of the resident module, which stays untouched for the next
+    /// generateFrom().
+    void withSnapshot(llvm::function_ref<void()> emit);
     void writeIR(const std::string& outputPath);
+    /// Binary IR — much cheaper to write and re-read than writeIR(). Under
+    /// ThinLTO the module summary index is embedded, so an LTO link can
+    /// import across modules and split the backend over threads.
+    void writeBitcode(const std::string& outputPath);
+
+    /// What the module is compiled for, with every default resolved.
+    const TargetSpec& target() const { return target_; }
+
+    /// True when writeBitcode() output is the artifact the linker wants:
+    /// a Shipping build with LTOMode::Thin.
+    bool thinLTO() const;
+
+    /// Lower the module to machine code in-process via the TargetMachine
+    /// for the module triple — no clang, no textual IR round-trip.
+    void writeObject(const std::string& outputPath);
+    void writeAssembly(const std::string& outputPath);
+
+    /// writeObject(), split like llvm::SplitModule into one object per
+    /// piece when options.partitions allows and the module defines more
+    /// than main: `prefix` + `suffix`, then `prefix` + ".1" + `suffix`, …
+    /// Returns every path written; link them all.
+    std::vector<std::string> writeObjects(const std::string& prefix, const std::string& suffix);
+
+    /// Hand the generated module (and its context) to the caller.
+    /// The Codegen must not be used for emission afterwards.
+    ModuleHandle takeModule();
+    /// Free the module and its context once every artifact is written,
+    /// before a link that does not need them; target() stays valid.
+    void releaseModule();
 
 private:
     // ── Build configuration ───────────────────────────────────────────────
-    BuildConfig config_;
-    bool        wasm_;
+    BuildConfig    config_;
+    bool           wasm_;
+    CodegenOptions options_;
+    TargetSpec     target_;    // options_.target, resolved
+    TimeReport*    timing_ = nullptr;
 
     // ── LLVM core objects ─────────────────────────────────────────────────
-    llvm::LLVMContext                context_;
+    std::unique_ptr<llvm::LLVMContext> context_;
     std::unique_ptr<llvm::Module>    module_;
     llvm::IRBuilder<>                builder_;
+    std::unique_ptr<llvm::TargetMachine> targetMachine_; // from target_; sets the data layout
 
     // ── Cached LLVM types ─────────────────────────────────────────────────
     llvm::Type* int64Ty_ = nullptr;
     llvm::Type* int32Ty_ = nullptr;
     llvm::Type* ptrTy_   = nullptr; // opaque pointer (LLVM 17+)
 
-    // ── Variable table: name → alloca ─────────────────────────────────────
-    std::map<std::string, llvm::AllocaInst*> variables_;
+    const SymbolTable* symbols_ = nullptr;
+
+    // ── Arrays: contiguous int64 storage, in both lowerings ───────────────
+    // Bulk operations work in <8 x i64> chunks: one zmm, two ymm or four
+    // xmm registers. Wider vectors only make legalisation split them again.
+    static constexpr uint32_t LANES = 8;
+    // Past this many bytes an array is a global, not a stack slot: wasm's
+    // default stack is 64 KiB
+    static constexpr uint64_t ARRAY_STACK_LIMIT = 4096;
+    struct ArrayStorage {
+        llvm::Value* ptr    = nullptr;   // entry alloca or internal global
+        uint32_t     length = 0;
+        llvm::Align  align;
+    };
+    static constexpr SymbolId NO_ARRAY_VAR = UINT32_MAX;
+
+    // ── Variables of the function being generated ─────────────────────────
+    // Each function has its own: main's scope is set aside while a user
+    // function's body is generated.
+    struct Scope {
+        llvm::DISubprogram*            di   = nullptr;
+        bool                           once = false;   // main: runs exactly once
+        std::vector<llvm::AllocaInst*> variables;      // SymbolId → slot (nullptr until assigned)
+        std::vector<SymbolId>          allocaLog;      // slot creation order
+        std::vector<ArrayStorage>      arrays;         // SymbolId → storage (ptr null until assigned)
+        // Creation order, temporaries (NO_ARRAY_VAR) included
+        std::vector<std::pair<SymbolId, llvm::Value*>> arrayLog;
+        // SSA lowering
+        std::vector<bool>                   declared;    // SymbolId → assigned yet
+        std::vector<llvm::DILocalVariable*> diVars;      // SymbolId → DWARF variable
+        std::vector<SymbolId>               assignLog;   // every write, in order
+        // --arith: the one cold block every failed check branches to,
+        // created on first use; phis carry the fault's kind and line
+        llvm::BasicBlock* trap     = nullptr;
+        llvm::PHINode*    trapKind = nullptr;
+        llvm::PHINode*    trapLine = nullptr;
+
+        /// Tables sized for `symbols`, preserving what main has already
+        /// created (watch mode resumes it).
+        void resize(size_t symbols) {
+            variables.resize(symbols, nullptr);
+            arrays.resize(symbols);
+            declared.resize(symbols, false);
+            diVars.resize(symbols, nullptr);
+        }
+    };
+    Scope scope_;
+
+    // ── User functions: internal, by FunctionNode::index ──────────────────
+    std::vector<llvm::Function*> functions_;
 
-    // ── printf machinery ──────────────────────────────────────────────────
-    llvm::Function*       printfFn_ = nullptr;
-    llvm::GlobalVariable* fmtStr_   = nullptr;
+    // ── Watch-mode checkpoints: main as it was before each statement ──────
+    struct Checkpoint {
+        llvm::BasicBlock*  block;     // insertion block
+        llvm::Instruction* last;      // its last instruction (nullptr: empty)
+        size_t             allocas;   // main's scope_.allocaLog size
+        size_t             arrays;    // and its scope_.arrayLog size
+        size_t             sites;     // lineSites_ size
+    };
+    llvm::Function*         mainFn_ = nullptr;
+    std::vector<Checkpoint> checkpoints_;
+
+    // ── On-the-fly SSA construction (options_.ssa) ────────────────────────
+    // Braun et al., "Simple and Efficient Construction of SSA Form" (CC'13).
+    // currentDef_ follows RAUW, so removing a trivial phi updates it too.
+    llvm::DenseMap<std::pair<llvm::BasicBlock*, SymbolId>, llvm::WeakTrackingVH> currentDef_;
+    llvm::DenseMap<llvm::BasicBlock*,
+                   std::vector<std::pair<SymbolId, llvm::PHINode*>>> incompletePhis_;
+    llvm::SmallPtrSet<llvm::BasicBlock*, 16> sealed_;
+
+    // ── Runtime entry points (runtime/nano_rt.h) ──────────────────────────
+    llvm::Function* outFn_        = nullptr;   // void nano_out_i64(i64)
+    llvm::Function* outArrayFn_   = nullptr;   // void nano_out_i64s(ptr, i64)
+    llvm::Function* indexErrorFn_ = nullptr;   // void nano_index_error(i64, i64, i32)
+    llvm::Function* arithErrorFn_ = nullptr;   // void nano_arith_error(i32, i32)
+    llvm::Function* linesFn_      = nullptr;   // void nano_lines_register(ptr)
+
+    // ── --instrument=lines ────────────────────────────────────────────────
+    // One counter per statement generated, in lineSites_ order. The globals
+    // are sized once the module is complete: until then (and in watch mode,
+    // until the next finishMain) they are stand-ins that are replaced.
+    std::string                 sourceFile_;
+    std::vector<std::string>    lineSites_;            // "function;file:line:col"
+    llvm::GlobalVariable*       lineHits_   = nullptr; // [N x i64] counters
+    llvm::GlobalVariable*       lineLabels_ = nullptr; // lineSites_, NUL-separated
+    llvm::GlobalVariable*       lineTable_  = nullptr; // nano_line_table
 
     // ── DWARF debug-info objects ──────────────────────────────────────────
     std::unique_ptr<llvm::DIBuilder> diBuilder_;
@@ -63,22 +300,114 @@ private:
     void setupModule();
     void setupDebugInfo(const std::string& sourceFile, const std::string& sourceDir);
 
-    /// Run the LLVM pass pipeline appropriate for config_.
-    /// Debug → no-op; Development → O2; Shipping → O3 full-LTO.
+    /// Run the LLVM pass pipeline appropriate for config_ on this thread's
+    /// shared PassBuilder. Debug → no-op; Fast → lean scalar cleanup;
+    /// Development → O2; Shipping → O3 full-LTO, or the ThinLTO pre-link
+    /// pipeline (the rest runs in the link).
     void optimize();
-    void declarePrintf();
+    /// The pipeline runs on each piece in writeObjects() rather than on
+    /// the whole module. Shipping's LTO pipeline needs the whole program,
+    /// and a profile names functions as the whole module does.
+    bool optimizesPieces() const {
+        return options_.partitions > 1 && config_ != BuildConfig::Shipping &&
+               !options_.profiled();
+    }
+    void declareRuntime();
+
+    /// The TargetMachine for target_, created on first use.
+    llvm::TargetMachine& targetMachine();
+    void emitMachineCode(const std::string& outputPath, llvm::CodeGenFileType type);
+    /// Writes `module` as `type` with `tm`.
+    static void emitModule(llvm::Module& module, llvm::TargetMachine& tm,
+                           const std::string& outputPath, llvm::CodeGenFileType type);
     llvm::Function* createMainFunction();
 
-    /// Insert a new alloca in the entry block (before the first non-alloca).
-    llvm::AllocaInst* createEntryAlloca(llvm::Function* fn, const std::string& name);
+    /// Insert a new alloca in the entry block (before the first non-alloca);
+    /// an int64 unless `type` says otherwise.
+    llvm::AllocaInst* createEntryAlloca(llvm::Function* fn, llvm::StringRef name,
+                                        llvm::Type* type = nullptr);
+
+    /// Cut main back to checkpoint `index`, erasing every instruction and
+    /// block (and stack slot) generated after it.
+    void truncateMain(size_t index);
+    /// Emitted after the last statement: `ret 0` and DIBuilder finalisation.
+    void finishMain();
+    /// Count one execution of `stmt`, in `fn`.
+    void countStatement(const StmtNode& stmt, llvm::Function* fn);
+    /// (Re)build the counters and the table nano_lines_register() reads,
+    /// sized for lineSites_.
+    void emitLineTable();
+    /// Verify module_, throwing with the verifier's report on failure.
+    void verify();
 
     /// Attach a debug location to every instruction that follows.
     void setDebugLoc(int line, int col);
 
+    // ── SSA construction helpers ──────────────────────────────────────────
+    void         writeVariable(SymbolId id, llvm::BasicBlock* block, llvm::Value* value);
+    llvm::Value* readVariable (SymbolId id, llvm::BasicBlock* block);
+    llvm::Value* readVariableRecursive(SymbolId id, llvm::BasicBlock* block);
+    llvm::Value* addPhiOperands(SymbolId id, llvm::PHINode* phi);
+    llvm::Value* tryRemoveTrivialPhi(llvm::PHINode* phi);
+    /// All predecessors of `block` are wired: complete its pending phis.
+    void         sealBlock(llvm::BasicBlock* block);
+    /// Emit a dbg.value saying variable `id` now holds `value`.
+    void         describeVariable(SymbolId id, llvm::Value* value, int line, int col);
+    /// After a merge into `block`: one dbg.value per variable written since
+    /// assignLog_[logMark], which is compacted to one entry per variable.
+    void         describeMerged(size_t logMark, llvm::BasicBlock* block, int line, int col);
+
+    // ── Arrays ────────────────────────────────────────────────────────────
+    /// Storage for an int64[length]: an aligned entry-block alloca, or an
+    /// internal zeroed global past the stack limit. Variable `id` is
+    /// described to DWARF; temporaries pass NO_ARRAY_VAR and line 0.
+    ArrayStorage createArrayStorage(llvm::Function* fn, SymbolId id,
+                                    uint32_t length, int line);
+    /// The storage of array variable `id`, which must have been assigned.
+    const ArrayStorage& arrayOf(SymbolId id, int line) const;
+    /// Address of element `index`, bounds-checked unless the index is a
+    /// constant in range.
+    llvm::Value* elementPtr(const ArrayStorage& array, llvm::Value* index, int line);
+    /// Evaluate array expression `expr` into `dst`, its int64 operands
+    /// computed once up front: <LANES x i64> chunks in a loop, then one
+    /// narrower vector for the remainder.
+    void         storeArray(const ArrayStorage& dst, const ExprNode& expr);
+    void         hoistScalars(const ExprNode& expr, llvm::SmallVectorImpl<llvm::Value*>& out);
+    /// Elements [offset, offset + width) of `expr` as one vector; `offsetBytes`
+    /// is a multiple of offset * 8 that loads and stores may assume aligned.
+    llvm::Value* genLanes(const ExprNode& expr, llvm::Value* offset, uint32_t width,
+                          uint64_t offsetBytes, llvm::ArrayRef<llvm::Value*> scalars,
+                          size_t& next);
+    void         storeLanes(const ArrayStorage& dst, const ExprNode& expr, llvm::Value* offset,
+                            uint32_t width, uint64_t offsetBytes,
+                            llvm::ArrayRef<llvm::Value*> scalars);
+
+    // ── Arithmetic (--arith) ──────────────────────────────────────────────
+    /// `lhs op rhs` on int64s or <N x i64> vectors alike.
+    llvm::Value* emitBinOp(BinOp op, llvm::Value* lhs, llvm::Value* rhs, int line);
+    llvm::Value* emitDiv(llvm::Value* lhs, llvm::Value* rhs, int line);
+    /// Continue where `failed` (i1) is false; otherwise report fault `kind`
+    /// (i32, a nano_arith_error kind) at `line` from the function's trap block.
+    void         trapIf(llvm::Value* failed, llvm::Value* kind, int line);
+
     // ── Code generation ───────────────────────────────────────────────────
     void         genStatement (const StmtNode&      stmt, llvm::Function* fn);
     void         genAssignment(const AssignmentNode& node, llvm::Function* fn);
     void         genIf        (const IfNode&         node, llvm::Function* fn);
+    void         genWhile     (const WhileNode&      node, llvm::Function* fn);
+    void         genIndexAssign(const IndexAssignNode& node);
+    void         genReturn    (const ReturnNode&     node);
+
+    // ── User functions ────────────────────────────────────────────────────
+    /// Declare every function (a call may precede its callee), then
+    /// generate their bodies.
+    void            genFunctions(const ProgramNode& program);
+    llvm::Function* declareFunction(const FunctionNode& node);
+    void            genFunction(const FunctionNode& node);
+    /// What the optimiser's cost model and the backend's selection key on.
+    void            addTargetAttributes(llvm::Function* fn);
+    /// The !llvm.loop node for the back-edge of `node`.
+    llvm::MDNode* loopMetadata(const WhileNode& node);
     void         genOut       (const OutNode&        node);
     llvm::Value* genExpr      (const ExprNode& expr);
 };
@@ -0,0 +1,39 @@
+#include "diagnostics.hpp"
+
+#include <algorithm>
+
+std::string Diagnostic::render() const {
+    return file + ":" + std::to_string(line) + ":" + std::to_string(col) + ": " + message;
+}
+
+void DiagnosticEngine::error(int line, int col, std::string message) {
+    if (full()) return;
+    diagnostics_.push_back({file_, line, col, std::move(message)});
+}
+
+void DiagnosticEngine::throwIfErrors() {
+    if (hasErrors()) {
+        // Pre-lexed input reports every lexer error before the parser's
+        std::stable_sort(diagnostics_.begin(), diagnostics_.end(),
+                         [](const Diagnostic& a, const Diagnostic& b) {
+                             return a.line != b.line ? a.line < b.line : a.col < b.col;
+                         });
+        const bool truncated = full();
+        throw SyntaxError(std::move(diagnostics_), truncated);
+    }
+}
+
+static std::string renderAll(const std::vector<Diagnostic>& diags, bool truncated) {
+    std::string out;
+    for (const Diagnostic& d : diags) {
+        if (!out.empty()) out += '\n';
+        out += d.render();
+    }
+    if (diags.size() > 1)
+        out += "\n" + std::to_string(diags.size()) + " errors" +
+               (truncated ? " (limit reached, stopped)" : "");
+    return out;
+}
+
+SyntaxError::SyntaxError(std::vector<Diagnostic> diags, bool truncated)
+    : std::runtime_error(renderAll(diags, truncated)), diagnostics(std::move(diags)) {}
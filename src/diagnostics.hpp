@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// One lexical or syntax error, located at a token (1-based line, byte
+/// column). `message` carries no location: render() adds it.
+struct Diagnostic {
+    std::string file;
+    int         line;
+    int         col;
+    std::string message;
+
+    /// "file:line:col: message", the form editors and terminals link.
+    std::string render() const;
+};
+
+/// Collects the diagnostics of one source file, so the lexer and parser can
+/// recover and carry on instead of stopping at the first error. Nothing is
+/// formatted or allocated until something is reported.
+class DiagnosticEngine {
+public:
+    /// Past `limit` errors the rest of the file is not worth reading: the
+    /// parser stops once full().
+    explicit DiagnosticEngine(std::string file, size_t limit = 50)
+        : file_(std::move(file)), limit_(limit) {}
+
+    void error(int line, int col, std::string message);
+
+    bool   hasErrors() const { return !diagnostics_.empty(); }
+    bool   full()      const { return diagnostics_.size() >= limit_; }
+    size_t count()     const { return diagnostics_.size(); }
+    const std::vector<Diagnostic>& diagnostics() const { return diagnostics_; }
+    const std::string&             file()        const { return file_; }
+
+    /// Throws SyntaxError carrying every diagnostic, if there are any.
+    void throwIfErrors();
+
+private:
+    std::string             file_;
+    size_t                  limit_;
+    std::vector<Diagnostic> diagnostics_;
+};
+
+/// Every error found in one pass over a file. what() lists them one per
+/// line, as the CLI prints them; editors use the structured list.
+struct SyntaxError : std::runtime_error {
+    std::vector<Diagnostic> diagnostics;
+    /// `truncated`: the engine hit its limit and stopped reading.
+    explicit SyntaxError(std::vector<Diagnostic> diags, bool truncated = false);
+};
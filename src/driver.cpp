@@ -0,0 +1,357 @@
+#include "driver.hpp"
+
+#include "fold.hpp"
+#include "jit.hpp"
+#include "linker.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+#include "types.hpp"
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#ifndef NANOSCRIPT_VERSION
+#define NANOSCRIPT_VERSION "dev"
+#endif
+
+// ── Helpers ───────────────────────────────────────────────────────────────
+
+bool targetsHost(const CompileOptions& opts) {
+    const std::string& triple = opts.codegen.target.triple;
+    return triple.empty() ||
+           llvm::Triple::normalize(triple) ==
+               llvm::Triple::normalize(llvm::sys::getDefaultTargetTriple());
+}
+
+CodegenOptions codegenOptions(const CompileOptions& opts) {
+    CodegenOptions codegen = opts.codegen;
+    const bool thin = opts.config == BuildConfig::Shipping && codegen.lto == LTOMode::Thin;
+    const bool linked = opts.emit == EmitKind::Executable || opts.emit == EmitKind::Precompiled;
+    if (!linked || thin ||
+        linkNeedsObjectsForDebugInfo(opts.config, opts.wasm))
+        codegen.partitions = 1;
+    return codegen;
+}
+
+std::string defaultOutput(const std::string& inputFile, const CompileOptions& opts,
+                          const std::string& outDir) {
+    std::filesystem::path p(inputFile);
+    std::string stem = p.stem().string();
+    std::string name;
+    switch (opts.emit) {
+        case EmitKind::Object:     name = stem + ".o";  break;
+        case EmitKind::Assembly:   name = stem + ".s";  break;
+        case EmitKind::IR:         name = stem + ".ll"; break;
+        case EmitKind::Bitcode:    name = stem + ".bc"; break;
+        case EmitKind::Executable: name = opts.wasm ? (stem + ".wasm") : stem; break;
+        case EmitKind::Precompiled: name = stem + ".cwasm"; break;
+    }
+    return outDir.empty() ? name : (std::filesystem::path(outDir) / name).string();
+}
+
+// ── Front end → module ────────────────────────────────────────────────────
+// Each stage is released once the next has consumed it: the parser pulls
+// tokens as it goes, the source goes once parsed (the AST copies the names
+// it keeps), the AST once lowered, before the pipeline runs, and the module
+// once written, before the link.
+
+// --max-memory: what a whole-program build holds per source byte, roughly.
+// The AST measures about 8; the unoptimised module is most of the rest.
+static constexpr uint64_t AST_BYTES_PER_SOURCE_BYTE    = 8;
+static constexpr uint64_t MODULE_BYTES_PER_SOURCE_BYTE = 24;
+
+static bool overBudget(size_t sourceBytes, uint64_t maxMemory) {
+    const uint64_t whole = static_cast<uint64_t>(sourceBytes) *
+                           (1 + AST_BYTES_PER_SOURCE_BYTE + MODULE_BYTES_PER_SOURCE_BYTE);
+    return maxMemory != 0 && whole > maxMemory;
+}
+
+/// Lower `source` into `cg` one top-level statement at a time. A first pass
+/// parses it all, so every syntax error is still reported, but keeps only
+/// the function definitions: those are checked, folded and lowered up
+/// front, as a call may precede its callee. The second pass lexes again,
+/// resuming past each definition, and checks, folds and lowers every other
+/// statement as it is parsed, rewinding the arena behind it — one
+/// statement's nodes are live at a time, besides the definitions.
+static void streamModule(Codegen& cg, std::string_view source, const std::string& inputFile,
+                         ArithMode arith, TimeReport* timing) {
+    ProgramNode program;
+    StmtSpan    span;
+    {
+        TimeReport::Scope t(timing, "parse");
+        DiagnosticEngine diag(inputFile);
+        Lexer            lexer(source, diag);
+        Parser           parser(lexer);
+        for (;;) {
+            const Arena::Mark mark = program.arena.mark();
+            StmtNode* stmt = parser.parseTopLevel(program, span);
+            if (!stmt) break;
+            if (stmt->kind == NodeKind::Function) {
+                program.statements.push_back(stmt);
+                program.spans.push_back(span);
+            } else {
+                program.arena.rewind(mark);
+            }
+        }
+        diag.throwIfErrors();
+    }
+
+    TimeReport::Scope t(timing, "stream");
+    StatementChecker checker(program);
+    StatementFolder  folder(program, arith);
+    cg.beginStream(program);
+
+    DiagnosticEngine      diag(inputFile);   // stays empty: the input parsed
+    std::optional<Lexer>  lexer(std::in_place, source, diag);
+    std::optional<Parser> parser(std::in_place, *lexer);
+    std::vector<StmtNode*> folded;
+    size_t nextDef = 0;
+    while (parser->lookahead().type != TokenType::EOF_TOKEN) {
+        if (nextDef < program.spans.size() &&
+            parser->offsetOf(parser->lookahead()) == program.spans[nextDef].begin) {
+            const StmtSpan& def = program.spans[nextDef++];
+            parser.reset();
+            lexer.emplace(source, diag, def.end, def.endLine, def.endCol);
+            parser.emplace(*lexer);
+            continue;
+        }
+        const Arena::Mark mark = program.arena.mark();
+        StmtNode* stmt = parser->parseTopLevel(program, span);
+        if (!stmt) break;
+        checker.check(*stmt);
+        folded.clear();
+        folder.fold(stmt, folded);
+        for (const StmtNode* s : folded)
+            cg.lowerStatement(*s);
+        program.arena.rewind(mark);
+    }
+    cg.endStream();
+}
+
+/// Parse, check, fold and lower `file`, releasing it as soon as it has been
+/// read, and run the pipeline. Streams when a whole-program build of the
+/// file would not fit in `maxMemory` bytes (0: no budget).
+static std::unique_ptr<Codegen> generateModule(const std::string& inputFile,
+                                               std::optional<SourceFile>& file,
+                                               BuildConfig config, bool wasm,
+                                               CodegenOptions codegen,
+                                               uint64_t maxMemory,
+                                               TimeReport* timing) {
+    // Absolute paths so LLDB/Wasmtime can locate the source file
+    std::filesystem::path p = std::filesystem::absolute(inputFile);
+    const std::string srcFile = p.filename().string();
+    const std::string srcDir  = p.parent_path().string();
+
+    auto cg = std::make_unique<Codegen>(srcFile, srcDir, config, wasm, codegen);
+    cg->setTimeReport(timing);
+    if (overBudget(file->text().size(), maxMemory)) {
+        streamModule(*cg, file->text(), inputFile, codegen.arith, timing);
+        file.reset();
+    } else {
+        auto ast = parseSource(file->text(), inputFile, timing);
+        file.reset();
+        {
+            TimeReport::Scope t(timing, "types");
+            checkTypes(*ast);
+        }
+        {
+            TimeReport::Scope t(timing, "fold");
+            optimizeAST(*ast, codegen.arith);
+        }
+        cg->lower(*ast);
+    }
+    cg->optimizeAndVerify();
+    return cg;
+}
+
+static int linkArtifact(Codegen& cg,
+                        const std::string& outputFile,
+                        BuildConfig config,
+                        bool wasm,
+                        const CodegenOptions& codegen,
+                        bool resident,
+                        TimeReport* timing) {
+    // Mach-O debug builds keep <out>.o beside the binary for LLDB's debug map
+    const bool keepObj = linkNeedsObjectsForDebugInfo(config, wasm);
+    // ThinLTO hands the linker bitcode: no machine code is generated here
+    const bool thin = cg.thinLTO();
+    std::vector<std::string> objects;
+    if (thin) {
+        objects = {outputFile + ".tmp.bc"};
+        cg.writeBitcode(objects.front());
+    } else {
+        objects = cg.writeObjects(outputFile, keepObj ? ".o" : ".tmp.o");
+    }
+    if (!resident) cg.releaseModule();   // the linker may be in-process
+
+    LinkJob job;
+    job.objects = objects;
+    job.objects.push_back(runtimeLibrary(wasm, thin));
+    job.output  = outputFile;
+    job.config  = config;
+    job.wasm    = wasm;
+    job.thinLTO = thin;
+    job.profile = codegen.profileGenerate;
+    job.startup = codegen.wasmStartup;
+    job.triple  = cg.target().triple;
+    int rc;
+    {
+        TimeReport::Scope t(timing, "link");
+        rc = linkExecutable(job);
+    }
+
+    if (!keepObj)
+        for (const std::string& obj : objects)
+            std::filesystem::remove(obj);
+    return rc;
+}
+
+void emitArtifact(Codegen& cg, const std::string& outputFile, const CompileOptions& opts,
+                  bool resident) {
+    switch (opts.emit) {
+        case EmitKind::Object:   cg.writeObject(outputFile);   break;
+        case EmitKind::Assembly: cg.writeAssembly(outputFile); break;
+        case EmitKind::IR:       cg.writeIR(outputFile);       break;
+        case EmitKind::Bitcode:  cg.writeBitcode(outputFile);  break;
+        case EmitKind::Executable: {
+            const int rc = linkArtifact(cg, outputFile, opts.config, opts.wasm,
+                                        opts.codegen, resident, opts.timing);
+            if (rc != 0)
+                throw std::runtime_error("link step failed (exit " + std::to_string(rc) + ")");
+            break;
+        }
+        case EmitKind::Precompiled: {
+            // Linked to a scratch .wasm for wasmtime to compile
+            const std::string wasmFile = outputFile + ".tmp.wasm";
+            const int rc  = linkArtifact(cg, wasmFile, opts.config, /*wasm=*/true,
+                                         opts.codegen, resident, opts.timing);
+            int       aot = 0;
+            if (rc == 0) {
+                TimeReport::Scope t(opts.timing, "precompile");
+                aot = precompileWasm(wasmFile, outputFile);
+            }
+            std::filesystem::remove(wasmFile);
+            if (rc != 0)
+                throw std::runtime_error("link step failed (exit " + std::to_string(rc) + ")");
+            if (aot != 0)
+                throw std::runtime_error("wasmtime compile failed (exit " +
+                                         std::to_string(aot) + ")");
+            break;
+        }
+    }
+}
+
+// Everything that can change the bytes of the artifact goes into the key.
+static std::string cacheKey(const CompileJob& job, const CompileOptions& opts,
+                            std::string_view source, bool keepObj) {
+    std::string m;
+    m += "nanoscript " NANOSCRIPT_VERSION " llvm " LLVM_VERSION_STRING "\n";
+    m += "config "  + std::to_string(static_cast<int>(opts.config)) + "\n";
+    m += "wasm "    + std::to_string(opts.wasm) + "\n";
+    m += "emit "    + std::to_string(static_cast<int>(opts.emit)) + "\n";
+    m += "ssa "     + std::to_string(opts.codegen.ssa) + "\n";
+    m += "lto "     + std::to_string(static_cast<int>(opts.codegen.lto)) + "\n";
+    m += "arith "   + std::to_string(static_cast<int>(opts.codegen.arith)) + "\n";
+    m += "partitions " + std::to_string(codegenOptions(opts).partitions) + "\n";
+    m += "profile-generate " + std::to_string(opts.codegen.profileGenerate) + "\n";
+    m += "instrument-lines " + std::to_string(opts.codegen.instrumentLines) + "\n";
+    m += "wasm-startup " + std::to_string(opts.codegen.wasmStartup) + "\n";
+    // A .cwasm loads only into the wasmtime that compiled it
+    if (opts.emit == EmitKind::Precompiled)
+        m += "wasmtime " + wasmtimeVersion() + "\n";
+    // The counts, not the path: a re-merged profile is a new build
+    if (!opts.codegen.profileUse.empty())
+        m += "profile-use " +
+             ArtifactCache::hashKey("", SourceFile(opts.codegen.profileUse).text()) + "\n";
+    // Resolved: --cpu=native keys on this machine's CPU and features
+    const TargetSpec target =
+        resolveTarget(opts.codegen.target, opts.wasm, opts.codegen.wasmStartup);
+    m += "triple "   + target.triple   + "\n";
+    m += "cpu "      + target.cpu      + "\n";
+    m += "features " + target.features + "\n";
+    // DWARF embeds the absolute source path, and a Mach-O debug map the
+    // absolute object path — identical bytes elsewhere are not a hit.
+    if (opts.config != BuildConfig::Shipping)
+        m += "source " + std::filesystem::absolute(job.input).string() + "\n";
+    if (keepObj)
+        m += "object " + std::filesystem::absolute(job.output).string() + "\n";
+    return ArtifactCache::hashKey(m, source);
+}
+
+// ── Single file ───────────────────────────────────────────────────────────
+
+CompileResult compileFile(const CompileJob& job, const CompileOptions& opts) {
+    CompileResult result;
+    try {
+        std::optional<SourceFile> file(std::in_place, job.input);
+        const std::string_view    source = file->text();   // until generateModule()
+
+        const bool keepObj = opts.emit == EmitKind::Executable &&
+                             linkNeedsObjectsForDebugInfo(opts.config, opts.wasm);
+        std::string key;
+        if (opts.cache) {
+            TimeReport::Scope t(opts.timing, "cache lookup");
+            key = cacheKey(job, opts, source, keepObj);
+            if (opts.cache->fetch(key, job.output)) {
+                result.ok = result.cached = true;
+                return result;
+            }
+        }
+
+        auto cg = generateModule(job.input, file, opts.config, opts.wasm,
+                                 codegenOptions(opts), opts.maxMemory, opts.timing);
+        emitArtifact(*cg, job.output, opts);
+
+        if (opts.cache) {
+            TimeReport::Scope t(opts.timing, "cache store");
+            opts.cache->store(key, job.output, keepObj ? job.output + ".o" : "");
+        }
+        result.ok = true;
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+int runFile(const std::string& inputFile, BuildConfig config,
+            CodegenOptions codegen, TimeReport* timing, uint64_t maxMemory) {
+    std::optional<SourceFile> file(std::in_place, inputFile);
+    codegen.partitions = 1;   // the JIT takes one module
+    auto cg = generateModule(inputFile, file, config, /*wasm=*/false,
+                             codegen, maxMemory, timing);
+    TimeReport::Scope t(timing, "jit + run");
+    return runJIT(cg->takeModule(), config);
+}
+
+// ── Batch ─────────────────────────────────────────────────────────────────
+
+std::vector<CompileResult> compileBatch(const std::vector<CompileJob>& jobs,
+                                        const CompileOptions& opts,
+                                        unsigned workers) {
+    std::vector<CompileResult> results(jobs.size());
+    std::atomic<size_t>        next{0};
+
+    auto worker = [&] {
+        for (size_t i = next++; i < jobs.size(); i = next++)
+            results[i] = compileFile(jobs[i], opts);
+    };
+
+    workers = std::max(1u, std::min<unsigned>(workers, static_cast<unsigned>(jobs.size())));
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned w = 1; w < workers; ++w)
+        pool.emplace_back(worker);
+    worker();   // the calling thread is worker 0
+    for (auto& t : pool)
+        t.join();
+
+    return results;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "cache.hpp"
+#include "codegen.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How far down the pipeline to go before writing the artifact. Precompiled
+// goes one step further: the linked .wasm, compiled ahead of time by
+// `wasmtime compile` into a .cwasm that instantiates without compiling.
+enum class EmitKind { Executable, Object, Assembly, IR, Bitcode, Precompiled };
+
+/// Settings shared by every file in an invocation.
+struct CompileOptions {
+    BuildConfig config = BuildConfig::Debug;
+    bool        wasm   = false;
+    EmitKind    emit   = EmitKind::Executable;
+
+    /// Lowering choices forwarded to every Codegen.
+    CodegenOptions codegen;
+
+    /// When set, compileFile() serves artifacts from / records them into it.
+    ArtifactCache* cache = nullptr;
+
+    /// When set, every phase (and LLVM pass) of every file is timed into it.
+    TimeReport* timing = nullptr;
+
+    /// --max-memory, in bytes (0: none): a file whose whole-program build
+    /// would need more is parsed and lowered one statement at a time.
+    uint64_t maxMemory = 0;
+};
+
+/// One source file and where its artifact goes.
+struct CompileJob {
+    std::string input;
+    std::string output;
+};
+
+struct CompileResult {
+    bool        ok     = false;
+    bool        cached = false;  // served from the artifact cache
+    std::string error;           // human-readable reason when !ok
+};
+
+/// False when --target names a machine other than this one: the bundled
+/// native runtime cannot be linked into its executables.
+bool targetsHost(const CompileOptions& opts);
+
+/// `opts.codegen`, with the partitions it cannot use dropped: only a
+/// linked executable is split, and neither ThinLTO bitcode nor a Mach-O
+/// debug build (its debug map wants the one object kept beside it).
+CodegenOptions codegenOptions(const CompileOptions& opts);
+
+/// <stem> / <stem>.wasm / <stem>.o … for `inputFile`, placed in `outDir`
+/// (current directory when empty).
+std::string defaultOutput(const std::string& inputFile, const CompileOptions& opts,
+                          const std::string& outDir = "");
+
+/// Lex → parse → codegen → emit (→ link) one file — or, on a cache hit,
+/// none of those: the stored artifact is copied out. Never throws: every
+/// failure, including LLVM and link errors, comes back in the result.
+/// Safe to call concurrently — each call builds its own Codegen and with
+/// it its own LLVMContext.
+CompileResult compileFile(const CompileJob& job, const CompileOptions& opts);
+
+/// Write `cg`'s module as `opts.emit` to `outputFile`, linking it for
+/// EmitKind::Executable and Precompiled. Unless `resident` (watch mode
+/// builds on it again), a linked module is freed before the link. Throws
+/// on I/O, LLVM and link failures.
+void emitArtifact(Codegen& cg, const std::string& outputFile, const CompileOptions& opts,
+                  bool resident = false);
+
+/// Build the front end + module for `inputFile` and execute it in the JIT.
+/// Returns the script's exit code; throws on compile errors.
+int runFile(const std::string& inputFile, BuildConfig config,
+            CodegenOptions codegen = {}, TimeReport* timing = nullptr,
+            uint64_t maxMemory = 0);
+
+/// Compile every job on a pool of `workers` threads. A worker handles its
+/// files one after another, so at most one LLVMContext is live per worker.
+/// Failures are collected per file; the batch always runs to completion.
+std::vector<CompileResult> compileBatch(const std::vector<CompileJob>& jobs,
+                                        const CompileOptions& opts,
+                                        unsigned workers);
@@ -0,0 +1,489 @@
+#include "fold.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+bool evalBinOp(BinOp op, int64_t a, int64_t b, int64_t& result, ArithMode mode) {
+    bool overflow = false;
+    bool negative = false;   // the sign of the exact result
+    switch (op) {
+        case BinOp::Add:
+            overflow = addOverflow(a, b, result);
+            negative = a < 0;   // overflow needs both signs alike
+            break;
+        case BinOp::Sub:
+            overflow = subOverflow(a, b, result);
+            negative = a < 0;   // overflow needs the signs to differ
+            break;
+        case BinOp::Mul:
+            overflow = mulOverflow(a, b, result);
+            negative = (a < 0) != (b < 0);
+            break;
+        case BinOp::Div:
+            if (b == 0) return false;
+            overflow = divOverflow(a, b, result);
+            break;   // INT64_MIN / -1 is positive
+        case BinOp::Eq: result = a == b; return true;
+        case BinOp::Ne: result = a != b; return true;
+        case BinOp::Lt: result = a <  b; return true;
+        case BinOp::Gt: result = a >  b; return true;
+        case BinOp::Le: result = a <= b; return true;
+        case BinOp::Ge: result = a >= b; return true;
+    }
+    if (!overflow) return true;
+    switch (mode) {
+        case ArithMode::Wrap:     return true;
+        case ArithMode::Trap:     return false;   // the program traps at run time
+        case ArithMode::Saturate: result = saturated(negative); return true;
+    }
+    return false;
+}
+
+namespace {
+
+class Folder {
+public:
+    Folder(ProgramNode& program, ArithMode mode)
+        : prog_(program),
+          mode_(mode),
+          known_(program.symbols.size()),
+          defined_(program.symbols.size(), false) {}
+
+    void run() {
+        std::vector<StmtNode*> out;
+        out.reserve(prog_.statements.size());
+        block(prog_.statements.data(), prog_.statements.size(), out);
+        prog_.statements = std::move(out);
+    }
+
+    // One more top-level statement, whose identifiers may be new
+    void topLevel(StmtNode* s, std::vector<StmtNode*>& out) {
+        known_.resize(prog_.symbols.size());
+        defined_.resize(prog_.symbols.size(), false);
+        block(&s, 1, out);
+    }
+
+private:
+    using Value = std::optional<int64_t>;
+
+    ProgramNode&       prog_;
+    ArithMode          mode_;
+    std::vector<Value> known_;    // SymbolId → constant value, if known here
+    std::vector<bool>  defined_;  // SymbolId → assigned somewhere already
+    // (id, previous value) for every assignment under a runtime condition,
+    // so the state before the branch can be restored and merged
+    std::vector<std::pair<SymbolId, Value>> trail_;
+    int                depth_ = 0;
+
+    static bool isLiteral(const ExprNode* e) { return e->kind == NodeKind::IntLiteral; }
+    static int64_t literal(const ExprNode* e) {
+        return static_cast<const IntLiteralNode*>(e)->value;
+    }
+
+    ExprNode* makeLiteral(int64_t v, const ASTNode& at) {
+        return prog_.arena.make<IntLiteralNode>(v, at.line, at.col);
+    }
+
+    // ── Expressions ───────────────────────────────────────────────────────
+
+    ExprNode* expr(ExprNode* e) {
+        switch (e->kind) {
+            case NodeKind::Variable: {
+                const auto* n = static_cast<const VariableNode*>(e);
+                if (const Value& v = known_[n->name])
+                    return makeLiteral(*v, *n);
+                return e;
+            }
+            case NodeKind::BinaryOp: {
+                auto* n  = static_cast<BinaryOpNode*>(e);
+                n->left  = expr(n->left);
+                n->right = expr(n->right);
+                int64_t v;
+                if (isLiteral(n->left) && isLiteral(n->right) &&
+                    evalBinOp(n->op, literal(n->left), literal(n->right), v, mode_))
+                    return makeLiteral(v, *n);
+                return e;
+            }
+            case NodeKind::Index: {
+                auto* n  = static_cast<IndexNode*>(e);
+                n->index = expr(n->index);
+                return e;
+            }
+            case NodeKind::ArrayRepeat: {
+                auto* n  = static_cast<ArrayRepeatNode*>(e);
+                n->value = expr(n->value);
+                return e;
+            }
+            case NodeKind::ArrayLiteral: {
+                auto* n = static_cast<ArrayLiteralNode*>(e);
+                n->elements = exprs(n->elements);
+                return e;
+            }
+            case NodeKind::Call: {
+                auto* n = static_cast<CallNode*>(e);
+                n->args = exprs(n->args);
+                return e;   // a call is never folded: it may have output
+            }
+            default:
+                return e;   // the value of an array variable is never known
+        }
+    }
+
+    NodeList<ExprNode> exprs(const NodeList<ExprNode>& list) {
+        std::vector<ExprNode*> folded(list.begin(), list.end());
+        for (ExprNode*& e : folded) e = expr(e);
+        return NodeList<ExprNode>(prog_.arena, folded.data(), folded.size());
+    }
+
+    // True if evaluating `e` can neither fail at run time nor have an
+    // effect: no call, no division (by zero), no bounds-checked index, no
+    // arithmetic that --arith=trap checks, and no read of a variable never
+    // assigned (codegen and the interpreter report those)
+    bool cannotFault(const ExprNode* e) const {
+        switch (e->kind) {
+            case NodeKind::IntLiteral:
+                return true;
+            case NodeKind::Variable:
+                return defined_[static_cast<const VariableNode*>(e)->name];
+            case NodeKind::BinaryOp: {
+                const auto* n = static_cast<const BinaryOpNode*>(e);
+                if (n->op == BinOp::Div) return false;
+                if (!isComparison(n->op) && mode_ == ArithMode::Trap) return false;
+                return cannotFault(n->left) && cannotFault(n->right);
+            }
+            default:
+                return false;   // calls, indexing
+        }
+    }
+
+    // ── Statements ────────────────────────────────────────────────────────
+
+    void assign(SymbolId id, Value v) {
+        if (depth_ > 0) trail_.emplace_back(id, known_[id]);
+        known_[id]   = v;
+        defined_[id] = true;
+    }
+
+    // Every assignment in `stmts`, however deeply nested
+    template <typename F>
+    static void forEachAssignment(const StmtNode* const* stmts, size_t count, F&& f) {
+        for (size_t i = 0; i < count; ++i) {
+            const StmtNode* s = stmts[i];
+            switch (s->kind) {
+                case NodeKind::Assignment:
+                    f(*static_cast<const AssignmentNode*>(s));
+                    break;
+                case NodeKind::If: {
+                    const auto* n = static_cast<const IfNode*>(s);
+                    forEachAssignment(n->body.data, n->body.size, f);
+                    break;
+                }
+                case NodeKind::While: {
+                    const auto* n = static_cast<const WhileNode*>(s);
+                    if (n->init) forEachAssignment(&n->init, 1, f);
+                    forEachAssignment(n->body.data, n->body.size, f);
+                    if (n->step) forEachAssignment(&n->step, 1, f);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Would dropping these statements leave a later use of a variable undefined?
+    bool introducesVariables(const StmtNode* const* stmts, size_t count) const {
+        bool any = false;
+        forEachAssignment(stmts, count, [&](const AssignmentNode& a) {
+            any = any || !defined_[a.varName];
+        });
+        return any;
+    }
+
+    void markDefined(const StmtNode* const* stmts, size_t count) {
+        forEachAssignment(stmts, count, [&](const AssignmentNode& a) {
+            defined_[a.varName] = true;
+        });
+    }
+
+    void block(StmtNode* const* stmts, size_t count, std::vector<StmtNode*>& out) {
+        for (size_t i = 0; i < count; ++i) {
+            StmtNode* s = stmts[i];
+            switch (s->kind) {
+                case NodeKind::Assignment: {
+                    auto* n  = static_cast<AssignmentNode*>(s);
+                    n->value = expr(n->value);
+                    assign(n->varName, isLiteral(n->value) ? Value(literal(n->value))
+                                                           : Value());
+                    out.push_back(s);
+                    break;
+                }
+                case NodeKind::IndexAssign: {
+                    auto* n  = static_cast<IndexAssignNode*>(s);
+                    n->index = expr(n->index);
+                    n->value = expr(n->value);
+                    out.push_back(s);
+                    break;
+                }
+                case NodeKind::Out: {
+                    auto* n = static_cast<OutNode*>(s);
+                    n->expr = expr(n->expr);
+                    out.push_back(s);
+                    break;
+                }
+                case NodeKind::If:
+                    ifStmt(static_cast<IfNode*>(s), out);
+                    break;
+                case NodeKind::While:
+                    whileStmt(static_cast<WhileNode*>(s), out);
+                    break;
+                case NodeKind::Return: {
+                    auto* n  = static_cast<ReturnNode*>(s);
+                    n->value = expr(n->value);
+                    out.push_back(s);
+                    break;
+                }
+                case NodeKind::Function:
+                    function(static_cast<FunctionNode*>(s));
+                    out.push_back(s);
+                    break;
+                default:
+                    out.push_back(s);
+                    break;
+            }
+        }
+    }
+
+    // Folded on its own: nothing is known about the parameters, and the
+    // caller's facts are set aside until the body is done
+    void function(FunctionNode* n) {
+        std::vector<Value> known(prog_.symbols.size());
+        std::vector<bool>  defined(prog_.symbols.size(), false);
+        std::swap(known_,   known);
+        std::swap(defined_, defined);
+        for (const VariableNode* p : n->params)
+            defined_[p->name] = true;
+        std::vector<StmtNode*> body;
+        body.reserve(n->body.size);
+        block(n->body.data, n->body.size, body);
+        n->body = NodeList<StmtNode>(prog_.arena, body.data(), body.size());
+        std::swap(known_,   known);
+        std::swap(defined_, defined);
+    }
+
+    void ifStmt(IfNode* n, std::vector<StmtNode*>& out) {
+        n->condition = expr(n->condition);
+
+        if (isLiteral(n->condition)) {
+            if (literal(n->condition) != 0) {
+                // Always taken: the body simply runs in sequence
+                block(n->body.data, n->body.size, out);
+            } else if (introducesVariables(n->body.data, n->body.size)) {
+                // Never taken, but codegen still needs the body's variables
+                // declared for any later read; keep it behind `if (0)`.
+                markDefined(n->body.data, n->body.size);
+                out.push_back(n);
+            }
+            return;
+        }
+
+        // Runtime condition: fold the body against the current state, then
+        // keep only the facts that hold whether or not it ran.
+        const size_t mark = trail_.size();
+        ++depth_;
+        std::vector<StmtNode*> body;
+        body.reserve(n->body.size);
+        block(n->body.data, n->body.size, body);
+        --depth_;
+
+        std::vector<std::pair<SymbolId, Value>> after;
+        after.reserve(trail_.size() - mark);
+        for (size_t i = mark; i < trail_.size(); ++i)
+            after.emplace_back(trail_[i].first, known_[trail_[i].first]);
+        for (size_t i = trail_.size(); i-- > mark;)
+            known_[trail_[i].first] = trail_[i].second;
+        for (const auto& [id, v] : after)
+            if (known_[id] != v) {
+                if (depth_ > 0) trail_.emplace_back(id, known_[id]);
+                known_[id] = std::nullopt;
+            }
+        if (depth_ == 0) trail_.resize(mark);
+
+        if (body.empty() && cannotFault(n->condition)) return;
+        n->body = NodeList<StmtNode>(prog_.arena, body.data(), body.size());
+        out.push_back(n);
+    }
+
+    void whileStmt(WhileNode* n, std::vector<StmtNode*>& out) {
+        std::vector<StmtNode*> scratch;
+        if (n->init) block(&n->init, 1, scratch);   // runs once, in sequence
+
+        // What one iteration assigns is unknown at the top of the next, so
+        // it is unknown for the condition and the whole body, and after
+        auto forget = [&](const AssignmentNode& a) {
+            if (depth_ > 0) trail_.emplace_back(a.varName, known_[a.varName]);
+            known_[a.varName] = std::nullopt;
+        };
+        forEachAssignment(n->body.data, n->body.size, forget);
+        if (n->step) forEachAssignment(&n->step, 1, forget);
+        n->condition = expr(n->condition);
+
+        if (isLiteral(n->condition) && literal(n->condition) == 0) {
+            // Never entered: only the init is left, unless the body or step
+            // declare variables a later read needs
+            if (n->init) out.push_back(n->init);
+            n->init = nullptr;
+            if (introducesVariables(n->body.data, n->body.size) ||
+                (n->step && introducesVariables(&n->step, 1))) {
+                markDefined(n->body.data, n->body.size);
+                if (n->step) markDefined(&n->step, 1);
+                out.push_back(n);
+            }
+            return;
+        }
+
+        // Facts found inside an iteration hold only within it
+        const size_t mark = trail_.size();
+        ++depth_;
+        std::vector<StmtNode*> body;
+        body.reserve(n->body.size);
+        block(n->body.data, n->body.size, body);
+        if (n->step) block(&n->step, 1, scratch);
+        --depth_;
+        for (size_t i = trail_.size(); i-- > mark;)
+            known_[trail_[i].first] = trail_[i].second;
+        trail_.resize(mark);
+
+        // Kept even when empty: the loop may never end
+        n->body = NodeList<StmtNode>(prog_.arena, body.data(), body.size());
+        out.push_back(n);
+    }
+};
+
+} // namespace
+
+void optimizeAST(ProgramNode& program, ArithMode mode) {
+    Folder(program, mode).run();
+}
+
+struct StatementFolder::Impl {
+    Folder folder;
+};
+
+StatementFolder::StatementFolder(ProgramNode& functions, ArithMode mode)
+    : impl_(new Impl{Folder(functions, mode)}) {
+    impl_->folder.run();
+}
+
+StatementFolder::~StatementFolder() = default;
+
+void StatementFolder::fold(StmtNode* stmt, std::vector<StmtNode*>& out) {
+    impl_->folder.topLevel(stmt, out);
+}
+
+// ── Deep copy ─────────────────────────────────────────────────────────────
+
+template <typename T>
+static T* copyNode(const ASTNode& node, Arena& arena) {
+    return arena.make<T>(static_cast<const T&>(node));
+}
+
+static ExprNode* cloneExpr(const ExprNode& e, Arena& arena);
+
+static NodeList<ExprNode> cloneExprs(const NodeList<ExprNode>& list, Arena& arena) {
+    std::vector<ExprNode*> copies;
+    copies.reserve(list.size);
+    for (const ExprNode* e : list) copies.push_back(cloneExpr(*e, arena));
+    return NodeList<ExprNode>(arena, copies.data(), copies.size());
+}
+
+static NodeList<StmtNode> cloneStmts(const NodeList<StmtNode>& list, Arena& arena) {
+    std::vector<StmtNode*> copies;
+    copies.reserve(list.size);
+    for (const StmtNode* s : list) copies.push_back(cloneStatement(*s, arena));
+    return NodeList<StmtNode>(arena, copies.data(), copies.size());
+}
+
+static ExprNode* cloneExpr(const ExprNode& e, Arena& arena) {
+    switch (e.kind) {
+        case NodeKind::IntLiteral: return copyNode<IntLiteralNode>(e, arena);
+        case NodeKind::Variable:   return copyNode<VariableNode>(e, arena);
+        case NodeKind::BinaryOp: {
+            auto* n  = copyNode<BinaryOpNode>(e, arena);
+            n->left  = cloneExpr(*n->left, arena);
+            n->right = cloneExpr(*n->right, arena);
+            return n;
+        }
+        case NodeKind::Index: {
+            auto* n  = copyNode<IndexNode>(e, arena);
+            n->index = cloneExpr(*n->index, arena);
+            return n;
+        }
+        case NodeKind::ArrayLiteral: {
+            auto* n     = copyNode<ArrayLiteralNode>(e, arena);
+            n->elements = cloneExprs(n->elements, arena);
+            return n;
+        }
+        case NodeKind::ArrayRepeat: {
+            auto* n  = copyNode<ArrayRepeatNode>(e, arena);
+            n->value = cloneExpr(*n->value, arena);
+            return n;
+        }
+        case NodeKind::Call: {
+            auto* n = copyNode<CallNode>(e, arena);
+            n->args = cloneExprs(n->args, arena);
+            return n;
+        }
+        default:
+            throw std::logic_error("cloneExpr: not an expression");
+    }
+}
+
+StmtNode* cloneStatement(const StmtNode& stmt, Arena& arena) {
+    switch (stmt.kind) {
+        case NodeKind::Assignment: {
+            auto* n  = copyNode<AssignmentNode>(stmt, arena);
+            n->value = cloneExpr(*n->value, arena);
+            return n;
+        }
+        case NodeKind::IndexAssign: {
+            auto* n  = copyNode<IndexAssignNode>(stmt, arena);
+            n->index = cloneExpr(*n->index, arena);
+            n->value = cloneExpr(*n->value, arena);
+            return n;
+        }
+        case NodeKind::If: {
+            auto* n      = copyNode<IfNode>(stmt, arena);
+            n->condition = cloneExpr(*n->condition, arena);
+            n->body      = cloneStmts(n->body, arena);
+            return n;
+        }
+        case NodeKind::While: {
+            auto* n      = copyNode<WhileNode>(stmt, arena);
+            if (n->init) n->init = cloneStatement(*n->init, arena);
+            n->condition = cloneExpr(*n->condition, arena);
+            if (n->step) n->step = cloneStatement(*n->step, arena);
+            n->body      = cloneStmts(n->body, arena);
+            return n;
+        }
+        case NodeKind::Out: {
+            auto* n = copyNode<OutNode>(stmt, arena);
+            n->expr = cloneExpr(*n->expr, arena);
+            return n;
+        }
+        case NodeKind::Return: {
+            auto* n  = copyNode<ReturnNode>(stmt, arena);
+            n->value = cloneExpr(*n->value, arena);
+            return n;
+        }
+        case NodeKind::Function: {
+            auto* n = copyNode<FunctionNode>(stmt, arena);
+            n->body = cloneStmts(n->body, arena);
+            return n;
+        }
+        default:
+            throw std::logic_error("cloneStatement: not a statement");
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "arith.hpp"
+#include "ast.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// Evaluate `a op b` with the exact semantics of the generated code under
+/// `mode`; comparisons yield 0 / 1. Returns false when the result is not a
+/// compile-time value (x / 0, and overflow under ArithMode::Trap) — those
+/// are left to fail at run time.
+bool evalBinOp(BinOp op, int64_t a, int64_t b, int64_t& result,
+               ArithMode mode = ArithMode::Wrap);
+
+/// Front-end optimisation over the whole program, run before codegen in
+/// every build config:
+///   - propagates constants through assignments to int64 variables,
+///   - folds binary operators whose operands are known,
+///   - removes `if` statements whose condition is known (a true body is
+///     spliced into the enclosing block), and empty ones whose condition
+///     cannot fault at run time,
+///   - folds loop bodies with every variable the loop assigns unknown, and
+///     removes loops whose condition is false on entry,
+///   - folds each function body on its own, knowing nothing of its
+///     parameters; calls are never folded away.
+/// Rewritten nodes inherit the line/col of the node they replace, and
+/// assignments are never removed, so DWARF still sees every variable.
+/// Constants fold as `mode` computes them at run time.
+void optimizeAST(ProgramNode& program, ArithMode mode = ArithMode::Wrap);
+
+/// optimizeAST() for a program lowered as it is parsed (--max-memory), one
+/// top-level statement at a time: what is known after one statement carries
+/// into the next, so the result is the same.
+class StatementFolder {
+public:
+    /// Folds `functions`, a program whose statements are all of its
+    /// function definitions and nothing else.
+    StatementFolder(ProgramNode& functions, ArithMode mode = ArithMode::Wrap);
+    ~StatementFolder();
+
+    /// Append what is left of the next top-level statement to `out`: the
+    /// statement, nothing, or the body of an `if` it reduced to.
+    void fold(StmtNode* stmt, std::vector<StmtNode*>& out);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/// Deep copy of `stmt` into `arena`, for folding a tree that has to stay as
+/// parsed (--watch keeps its AST across edits, and the folder rewrites the
+/// nodes it is given). Function parameters are shared: nothing rewrites them.
+StmtNode* cloneStatement(const StmtNode& stmt, Arena& arena);
@@ -0,0 +1,171 @@
+#include "incremental.hpp"
+
+#include "parser.hpp"
+
+#include <algorithm>
+
+// ── Line shifting for reused statements ───────────────────────────────────
+
+static void shiftLines(ExprNode& expr, int delta) {
+    expr.line += delta;
+    switch (expr.kind) {
+        case NodeKind::BinaryOp: {
+            auto& n = static_cast<BinaryOpNode&>(expr);
+            shiftLines(*n.left,  delta);
+            shiftLines(*n.right, delta);
+            break;
+        }
+        case NodeKind::Index:
+            shiftLines(*static_cast<IndexNode&>(expr).index, delta);
+            break;
+        case NodeKind::ArrayLiteral:
+            for (ExprNode* e : static_cast<ArrayLiteralNode&>(expr).elements)
+                shiftLines(*e, delta);
+            break;
+        case NodeKind::ArrayRepeat:
+            shiftLines(*static_cast<ArrayRepeatNode&>(expr).value, delta);
+            break;
+        case NodeKind::Call:
+            for (ExprNode* e : static_cast<CallNode&>(expr).args)
+                shiftLines(*e, delta);
+            break;
+        default:
+            break;
+    }
+}
+
+static void shiftLines(StmtNode& stmt, int delta) {
+    stmt.line += delta;
+    switch (stmt.kind) {
+        case NodeKind::Assignment:
+            shiftLines(*static_cast<AssignmentNode&>(stmt).value, delta);
+            break;
+        case NodeKind::IndexAssign: {
+            auto& n = static_cast<IndexAssignNode&>(stmt);
+            shiftLines(*n.index, delta);
+            shiftLines(*n.value, delta);
+            break;
+        }
+        case NodeKind::If: {
+            auto& n = static_cast<IfNode&>(stmt);
+            shiftLines(*n.condition, delta);
+            for (StmtNode* s : n.body)
+                shiftLines(*s, delta);
+            break;
+        }
+        case NodeKind::While: {
+            auto& n = static_cast<WhileNode&>(stmt);
+            if (n.init) shiftLines(*n.init, delta);
+            shiftLines(*n.condition, delta);
+            if (n.step) shiftLines(*n.step, delta);
+            for (StmtNode* s : n.body)
+                shiftLines(*s, delta);
+            break;
+        }
+        case NodeKind::Out:
+            shiftLines(*static_cast<OutNode&>(stmt).expr, delta);
+            break;
+        case NodeKind::Return:
+            shiftLines(*static_cast<ReturnNode&>(stmt).value, delta);
+            break;
+        case NodeKind::Function: {
+            auto& n = static_cast<FunctionNode&>(stmt);
+            n.nameLine += delta;
+            for (VariableNode* p : n.params)
+                shiftLines(*p, delta);
+            for (StmtNode* s : n.body)
+                shiftLines(*s, delta);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// ── Update ────────────────────────────────────────────────────────────────
+
+IncrementalParse::IncrementalParse(std::string filename)
+    : filename_(std::move(filename)) {}
+
+IncrementalParse::Splice IncrementalParse::update(std::string text) {
+    if (!program_) {
+        program_ = parseSource(text, filename_);
+        text_    = std::move(text);
+        return {0, 0, program_->statements.size(), 0};
+    }
+
+    // The edit, as the shortest middle section that differs: old and new
+    // share [0, prefix) and their last `suffix` bytes.
+    const std::string& old = text_;
+    const size_t prefix = static_cast<size_t>(
+        std::mismatch(old.begin(), old.end(), text.begin(), text.end()).first - old.begin());
+    size_t suffix = 0;
+    const size_t maxSuffix = std::min(old.size(), text.size()) - prefix;
+    while (suffix < maxSuffix && old[old.size() - 1 - suffix] == text[text.size() - 1 - suffix])
+        ++suffix;
+    const size_t tailStart = text.size() - suffix;   // new offset of the common tail
+    const auto   delta     = static_cast<int64_t>(text.size()) - static_cast<int64_t>(old.size());
+
+    std::vector<StmtNode*>& statements = program_->statements;
+    std::vector<StmtSpan>&  spans      = program_->spans;
+
+    // Statements that end before the edit are unchanged
+    const size_t keep = static_cast<size_t>(
+        std::partition_point(spans.begin(), spans.end(),
+                             [&](const StmtSpan& s) { return s.end <= prefix; }) -
+        spans.begin());
+
+    DiagnosticEngine diag(filename_);
+    Lexer  lexer = keep == 0 ? Lexer(text, diag)
+                             : Lexer(text, diag, spans[keep - 1].end,
+                                     spans[keep - 1].endLine, spans[keep - 1].endCol);
+    Parser parser(lexer);
+
+    // Parse until the next statement starts in the common tail on a line
+    // of its own text, and an old statement started at the same place: from
+    // there on, old and new are the same statements.
+    std::vector<StmtNode*> fresh;
+    std::vector<StmtSpan>  freshSpans;
+    size_t reuse     = statements.size();
+    int    lineDelta = 0;
+    StmtSpan span;
+    while (parser.lookahead().type != TokenType::EOF_TOKEN) {
+        const Token&   next  = parser.lookahead();
+        const uint32_t begin = parser.offsetOf(next);
+        if (begin >= tailStart &&
+            std::find(text.begin() + static_cast<std::ptrdiff_t>(tailStart),
+                      text.begin() + begin, '\n') != text.begin() + begin) {
+            const auto oldBegin = static_cast<uint32_t>(begin - delta);
+            auto it = std::partition_point(spans.begin() + static_cast<std::ptrdiff_t>(keep),
+                                           spans.end(),
+                                           [&](const StmtSpan& s) { return s.begin < oldBegin; });
+            if (it != spans.end() && it->begin == oldBegin) {
+                reuse     = static_cast<size_t>(it - spans.begin());
+                lineDelta = next.line - statements[reuse]->line;
+                break;
+            }
+        }
+        StmtNode* stmt = parser.parseTopLevel(*program_, span);
+        if (!stmt) break;   // only broken statements were left
+        fresh.push_back(stmt);
+        freshSpans.push_back(span);
+    }
+    diag.throwIfErrors();
+
+    // Parsed cleanly: splice [0, keep) + fresh + [reuse, end) shifted
+    for (size_t i = reuse; i < statements.size(); ++i) {
+        if (lineDelta) shiftLines(*statements[i], lineDelta);
+        spans[i].begin   = static_cast<uint32_t>(spans[i].begin + delta);
+        spans[i].end     = static_cast<uint32_t>(spans[i].end   + delta);
+        spans[i].endLine += lineDelta;
+    }
+    const auto first = static_cast<std::ptrdiff_t>(keep);
+    const auto last  = static_cast<std::ptrdiff_t>(reuse);
+    statements.erase(statements.begin() + first, statements.begin() + last);
+    statements.insert(statements.begin() + first, fresh.begin(), fresh.end());
+    spans.erase(spans.begin() + first, spans.begin() + last);
+    spans.insert(spans.begin() + first, freshSpans.begin(), freshSpans.end());
+    text_ = std::move(text);
+
+    return {keep, reuse - keep, fresh.size(), lineDelta};
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ast.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/// A program's source text and AST kept resident between edits, so that
+/// re-parsing after an edit only touches the statements it can change.
+///
+/// Top-level statements are the unit of reuse. Those ending before the
+/// first changed byte keep their nodes. Lexing restarts after the last of
+/// them, and parsing stops at the first statement of the unchanged tail
+/// that begins on an unchanged line; the old nodes from there on are kept
+/// with their line numbers shifted (columns cannot have moved). Nodes
+/// replaced by an edit stay in the arena until the IncrementalParse dies.
+class IncrementalParse {
+public:
+    explicit IncrementalParse(std::string filename);
+
+    /// What update() did to ProgramNode::statements (and spans): the
+    /// `removed` statements at `first` were replaced by `inserted` new ones.
+    /// Everything after them is the old tail, moved by `lineDelta` lines.
+    struct Splice {
+        size_t first     = 0;
+        size_t removed   = 0;
+        size_t inserted  = 0;
+        int    lineDelta = 0;
+    };
+
+    /// Bring the AST up to date with `text`. The first call parses it all.
+    /// Throws SyntaxError with every error in the re-parsed region, keeping
+    /// the previous AST and text, so the next update diffs against the last
+    /// text that parsed.
+    Splice update(std::string text);
+
+    /// nullptr until the first successful update().
+    ProgramNode*       program()       { return program_.get(); }
+    const ProgramNode* program() const { return program_.get(); }
+    const std::string& text()    const { return text_; }
+
+private:
+    std::string                  filename_;
+    std::string                  text_;      // what program_ was parsed from
+    std::unique_ptr<ProgramNode> program_;
+};
@@ -0,0 +1,597 @@
+#include "interp.hpp"
+
+#include "fold.hpp"
+#include "nano_rt.h"
+#include "parser.hpp"
+#include "source.hpp"
+#include "types.hpp"
+
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+
+// GCC and Clang support labels-as-values; elsewhere fall back to a switch
+#ifndef NANO_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define NANO_COMPUTED_GOTO 1
+#else
+#define NANO_COMPUTED_GOTO 0
+#endif
+#endif
+
+using Op    = Interpreter::Op;
+using Instr = Interpreter::Instr;
+
+// Constants and temporaries are numbered from here while compiling and
+// relocated behind the variables once a function's counts are known.
+static constexpr uint32_t CONST_BASE = 0x40000000u;
+static constexpr uint32_t TEMP_BASE  = 0x80000000u;
+static constexpr uint32_t ANY_REG    = 0xffffffffu;
+static constexpr uint32_t NO_SLOT    = 0xffffffffu;
+static constexpr uint32_t NO_ARRAY   = 0xffffffffu;
+
+// Frames are on the heap, so this only bounds runaway recursion: about
+// what an 8 MiB native stack holds of small frames
+static constexpr size_t MAX_CALL_DEPTH = 100000;
+
+// ── Compilation ───────────────────────────────────────────────────────────
+
+Interpreter::Interpreter(const ProgramNode& program, ArithMode arith)
+    : symbols_(program.symbols), arith_(arith) {
+    size_t count = 0;
+    for (const StmtNode* s : program.statements)
+        count += s->kind == NodeKind::Function;
+    functions_.resize(count);
+
+    compileFunction(main_, program.statements.data(), program.statements.size(), nullptr);
+    for (const StmtNode* s : program.statements)
+        if (s->kind == NodeKind::Function) {
+            const auto& f = static_cast<const FunctionNode&>(*s);
+            compileFunction(functions_[f.index], f.body.data, f.body.size, &f);
+        }
+}
+
+void Interpreter::compileFunction(Function& fn, const StmtNode* const* body, size_t count,
+                                  const FunctionNode* def) {
+    current_ = &fn;
+    constants_.clear();
+    constantIndex_.clear();
+    slots_.assign(symbols_.size(), NO_SLOT);
+    arrayIds_.assign(symbols_.size(), NO_ARRAY);
+    numVars_ = tempTop_ = maxTemps_ = 0;
+
+    fn.entry = static_cast<uint32_t>(code_.size());
+    if (def) {
+        for (const VariableNode* p : def->params) slot(p->name);
+        fn.params = def->params.size;
+    }
+    compileBlock(body, count);
+    if (def)
+        emit(Op::Ret, constant(0), 0, 0, def->line);   // fell off the end
+    else
+        emit(Op::Halt, 0, 0, 0, 0);
+
+    // Final layout: [variables | constants | temporaries]
+    const uint32_t tempStart = numVars_ + static_cast<uint32_t>(constants_.size());
+    auto reloc = [&](uint32_t& r) {
+        if (r >= TEMP_BASE)       r = tempStart + (r - TEMP_BASE);
+        else if (r >= CONST_BASE) r = numVars_ + (r - CONST_BASE);
+    };
+    for (size_t i = fn.entry; i < code_.size(); ++i) {
+        Instr& in = code_[i];
+        switch (in.op) {
+            case Op::JumpIfZero:
+            case Op::JumpIfNonZero:
+            case Op::Out:
+            case Op::Ret:  reloc(in.a); break;
+            case Op::Move: reloc(in.a); reloc(in.b); break;
+            case Op::LoadElem:  reloc(in.a); reloc(in.c); break;
+            case Op::StoreElem: reloc(in.b); reloc(in.c); break;
+            case Op::Call:      reloc(in.a); reloc(in.c); break;
+            case Op::OutArray:
+            case Op::Halt: break;
+            default:       reloc(in.a); reloc(in.b); reloc(in.c); break;
+        }
+    }
+    fn.frame.assign(tempStart + maxTemps_, 0);
+    std::copy(constants_.begin(), constants_.end(), fn.frame.begin() + numVars_);
+}
+
+uint32_t Interpreter::slot(SymbolId id) {
+    if (slots_[id] == NO_SLOT) slots_[id] = numVars_++;
+    return slots_[id];
+}
+
+void Interpreter::emit(Op op, uint32_t a, uint32_t b, uint32_t c, int line) {
+    code_.push_back({op, a, b, c});
+    lines_.push_back(line);
+}
+
+uint32_t Interpreter::constant(int64_t value) {
+    auto [it, inserted] = constantIndex_.emplace(value, static_cast<uint32_t>(constants_.size()));
+    if (inserted) constants_.push_back(value);
+    return CONST_BASE + it->second;
+}
+
+uint32_t Interpreter::temp() {
+    const uint32_t r = TEMP_BASE + tempTop_++;
+    if (tempTop_ > maxTemps_) maxTemps_ = tempTop_;
+    return r;
+}
+
+static Op opFor(BinOp op, ArithMode arith) {
+    // Wrap, Trap, Saturate
+    static constexpr Op ARITH[4][3] = {
+        {Op::Add, Op::AddTrap, Op::AddSat},
+        {Op::Sub, Op::SubTrap, Op::SubSat},
+        {Op::Mul, Op::MulTrap, Op::MulSat},
+        {Op::Div, Op::DivTrap, Op::DivSat},
+    };
+    switch (op) {
+        case BinOp::Add:
+        case BinOp::Sub:
+        case BinOp::Mul:
+        case BinOp::Div:
+            return ARITH[static_cast<size_t>(op)][static_cast<size_t>(arith)];
+        case BinOp::Eq:  return Op::Eq;
+        case BinOp::Ne:  return Op::Ne;
+        case BinOp::Lt:  return Op::Lt;
+        case BinOp::Gt:  return Op::Gt;
+        case BinOp::Le:  return Op::Le;
+        case BinOp::Ge:  return Op::Ge;
+    }
+    return Op::Halt;
+}
+
+// Returns the register holding the value. With dst == ANY_REG, literals and
+// variables are used in place and cost no instruction; otherwise the final
+// operation writes dst directly (operands are always read first).
+uint32_t Interpreter::compileExpr(const ExprNode& expr, uint32_t dst) {
+    switch (expr.kind) {
+        case NodeKind::IntLiteral:
+            return constant(static_cast<const IntLiteralNode&>(expr).value);
+        case NodeKind::Variable: {
+            const auto& n = static_cast<const VariableNode&>(expr);
+            if (slots_[n.name] == NO_SLOT)
+                throw std::runtime_error(
+                    "Undefined variable '" + std::string(symbols_.name(n.name)) +
+                    "' at line " + std::to_string(n.line));
+            return slots_[n.name];
+        }
+        case NodeKind::BinaryOp: {
+            const auto&    n     = static_cast<const BinaryOpNode&>(expr);
+            const uint32_t saved = tempTop_;
+            const uint32_t lhs   = compileExpr(*n.left,  ANY_REG);
+            const uint32_t rhs   = compileExpr(*n.right, ANY_REG);
+            tempTop_ = saved;   // operand temporaries are dead once read
+            const uint32_t out = dst != ANY_REG ? dst : temp();
+            emit(opFor(n.op, arith_), out, lhs, rhs, n.line);
+            return out;
+        }
+        case NodeKind::Index: {
+            const auto&    n     = static_cast<const IndexNode&>(expr);
+            const uint32_t array = arrayOf(n.array, n.line);
+            const uint32_t saved = tempTop_;
+            const uint32_t index = compileExpr(*n.index, ANY_REG);
+            tempTop_ = saved;
+            const uint32_t out = dst != ANY_REG ? dst : temp();
+            emit(Op::LoadElem, out, array, index, n.line);
+            return out;
+        }
+        case NodeKind::Call: {
+            // Arguments go to consecutive temporaries, copied into the
+            // callee's parameters by the call
+            const auto&    n     = static_cast<const CallNode&>(expr);
+            const uint32_t saved = tempTop_;
+            const uint32_t first = TEMP_BASE + tempTop_;
+            for (uint32_t i = 0; i < n.args.size; ++i) temp();
+            for (uint32_t i = 0; i < n.args.size; ++i) {
+                const uint32_t r = compileExpr(*n.args.data[i], first + i);
+                if (r != first + i) emit(Op::Move, first + i, r, 0, n.line);
+            }
+            tempTop_ = saved;
+            const uint32_t out = dst != ANY_REG ? dst : temp();
+            emit(Op::Call, out, n.function, first, n.line);
+            return out;
+        }
+        default:
+            throw std::runtime_error("Unknown expression kind in interpreter");
+    }
+}
+
+// ── Arrays ────────────────────────────────────────────────────────────────
+
+uint32_t Interpreter::arrayOf(SymbolId id, int line) const {
+    if (slots_[id] == NO_SLOT)
+        throw std::runtime_error("Undefined variable '" + std::string(symbols_.name(id)) +
+                                 "' at line " + std::to_string(line));
+    return arrayIds_[id];
+}
+
+uint32_t Interpreter::newArray(uint32_t length) {
+    Function& fn = *current_;
+    if (fn.memorySize + length > UINT32_MAX)
+        throw std::runtime_error("Arrays exceed the interpreter's 32 GiB of memory");
+    fn.arrays.push_back({static_cast<uint32_t>(fn.memorySize), length});
+    fn.memorySize += length;
+    return static_cast<uint32_t>(fn.arrays.size() - 1);
+}
+
+// Every int64 operand (and repeated value) in evaluation order, computed
+// once before the loop
+void Interpreter::hoistScalars(const ExprNode& expr, std::vector<uint32_t>& regs) {
+    if (expr.length == 0) {
+        regs.push_back(compileExpr(expr, ANY_REG));
+        return;
+    }
+    switch (expr.kind) {
+        case NodeKind::Variable: {
+            const auto& n = static_cast<const VariableNode&>(expr);
+            arrayOf(n.name, n.line);
+            break;
+        }
+        case NodeKind::ArrayRepeat:
+            regs.push_back(compileExpr(*static_cast<const ArrayRepeatNode&>(expr).value, ANY_REG));
+            break;
+        case NodeKind::BinaryOp: {
+            const auto& n = static_cast<const BinaryOpNode&>(expr);
+            hoistScalars(*n.left,  regs);
+            hoistScalars(*n.right, regs);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown array expression kind in interpreter");
+    }
+}
+
+// The register holding element `k` (a register) of `expr`
+uint32_t Interpreter::compileElement(const ExprNode& expr, uint32_t k,
+                                     const std::vector<uint32_t>& hoisted, size_t& next) {
+    if (expr.length == 0 || expr.kind == NodeKind::ArrayRepeat)
+        return hoisted[next++];
+    if (expr.kind == NodeKind::Variable) {
+        const uint32_t out = temp();
+        emit(Op::LoadElem, out, arrayIds_[static_cast<const VariableNode&>(expr).name], k,
+             expr.line);
+        return out;
+    }
+    const auto&    n     = static_cast<const BinaryOpNode&>(expr);
+    const uint32_t saved = tempTop_;
+    const uint32_t lhs   = compileElement(*n.left,  k, hoisted, next);
+    const uint32_t rhs   = compileElement(*n.right, k, hoisted, next);
+    tempTop_ = saved;
+    const uint32_t out = temp();
+    emit(opFor(n.op, arith_), out, lhs, rhs, n.line);
+    return out;
+}
+
+void Interpreter::storeArray(uint32_t dst, const ExprNode& expr, int line) {
+    if (expr.kind == NodeKind::ArrayLiteral) {
+        const auto& n = static_cast<const ArrayLiteralNode&>(expr);
+        std::vector<uint32_t> values;
+        values.reserve(n.elements.size);
+        for (const ExprNode* el : n.elements)
+            values.push_back(compileExpr(*el, ANY_REG));
+        for (uint32_t i = 0; i < n.elements.size; ++i)
+            emit(Op::StoreElem, dst, constant(i), values[i], line);
+        return;
+    }
+
+    // for (k = 0; k < length; k = k + 1) dst[k] = expr[k]
+    std::vector<uint32_t> hoisted;
+    hoistScalars(expr, hoisted);
+    const uint32_t k = temp();
+    emit(Op::Move, k, constant(0), 0, line);
+    const auto top   = static_cast<uint32_t>(code_.size());
+    const uint32_t saved = tempTop_;
+    size_t next = 0;
+    emit(Op::StoreElem, dst, k, compileElement(expr, k, hoisted, next), line);
+    tempTop_ = saved;
+    const uint32_t more = temp();
+    emit(Op::Add, k, k, constant(1), line);
+    emit(Op::Lt, more, k, constant(expr.length), line);
+    emit(Op::JumpIfNonZero, more, top, 0, line);
+}
+
+void Interpreter::compileBlock(const StmtNode* const* stmts, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const StmtNode& stmt = *stmts[i];
+        tempTop_ = 0;
+        switch (stmt.kind) {
+            case NodeKind::Assignment: {
+                const auto& n = static_cast<const AssignmentNode&>(stmt);
+                // Like codegen's alloca, the slot exists before its value
+                const uint32_t var = slot(n.varName);
+                if (n.value->length > 0) {
+                    uint32_t& array = arrayIds_[n.varName];
+                    if (array == NO_ARRAY) array = newArray(n.value->length);
+                    storeArray(array, *n.value, n.line);
+                    break;
+                }
+                const uint32_t r = compileExpr(*n.value, var);
+                if (r != var)
+                    emit(Op::Move, var, r, 0, n.line);
+                break;
+            }
+            case NodeKind::If: {
+                const auto&    n    = static_cast<const IfNode&>(stmt);
+                const uint32_t cond = compileExpr(*n.condition, ANY_REG);
+                const size_t   jump = code_.size();
+                emit(Op::JumpIfZero, cond, 0, 0, n.line);
+                compileBlock(n.body.data, n.body.size);
+                code_[jump].b = static_cast<uint32_t>(code_.size());
+                break;
+            }
+            case NodeKind::While: {
+                // Rotated: tested once on entry and then at the bottom, so
+                // an iteration dispatches a single jump
+                const auto& n = static_cast<const WhileNode&>(stmt);
+                if (n.init) compileBlock(&n.init, 1);
+                tempTop_ = 0;
+                const uint32_t entry = compileExpr(*n.condition, ANY_REG);
+                const size_t   exit  = code_.size();
+                emit(Op::JumpIfZero, entry, 0, 0, n.line);
+                const auto top = static_cast<uint32_t>(code_.size());
+                compileBlock(n.body.data, n.body.size);
+                if (n.step) compileBlock(&n.step, 1);
+                tempTop_ = 0;
+                const uint32_t again = compileExpr(*n.condition, ANY_REG);
+                emit(Op::JumpIfNonZero, again, top, 0, n.line);
+                code_[exit].b = static_cast<uint32_t>(code_.size());
+                break;
+            }
+            case NodeKind::IndexAssign: {
+                const auto&    n     = static_cast<const IndexAssignNode&>(stmt);
+                const uint32_t array = arrayOf(n.array, n.line);
+                const uint32_t index = compileExpr(*n.index, ANY_REG);
+                emit(Op::StoreElem, array, index, compileExpr(*n.value, ANY_REG), n.line);
+                break;
+            }
+            case NodeKind::Out: {
+                const auto& n = static_cast<const OutNode&>(stmt);
+                if (n.expr->length == 0) {
+                    emit(Op::Out, compileExpr(*n.expr, ANY_REG), 0, 0, n.line);
+                } else if (n.expr->kind == NodeKind::Variable) {
+                    const auto& v = static_cast<const VariableNode&>(*n.expr);
+                    emit(Op::OutArray, arrayOf(v.name, v.line), 0, 0, n.line);
+                } else {
+                    const uint32_t array = newArray(n.expr->length);   // a temporary
+                    storeArray(array, *n.expr, n.line);
+                    emit(Op::OutArray, array, 0, 0, n.line);
+                }
+                break;
+            }
+            case NodeKind::Return: {
+                const auto& n = static_cast<const ReturnNode&>(stmt);
+                emit(Op::Ret, compileExpr(*n.value, ANY_REG), 0, 0, n.line);
+                break;
+            }
+            case NodeKind::Function:
+                break;   // compiled on its own
+            default:
+                throw std::runtime_error("Unknown statement kind in interpreter");
+        }
+    }
+}
+
+// ── Execution ─────────────────────────────────────────────────────────────
+
+namespace {
+
+// The runtime buffers output; hand it over even when a fault unwinds run()
+struct FlushOnExit {
+    ~FlushOnExit() { nano_flush(); std::fflush(stdout); }
+};
+
+} // namespace
+
+int Interpreter::run() {
+    // Every active frame's registers and arrays, innermost last
+    struct Frame {
+        const Instr*    ret;
+        size_t          regs, memory;   // where the caller's frame starts
+        const Function* fn;
+        uint32_t        dst;            // caller's register for the result
+    };
+    std::vector<int64_t> stack  = main_.frame;
+    std::vector<int64_t> memory(main_.memorySize, 0);
+    std::vector<Frame>   frames;
+    size_t               base = 0, memBase = 0;
+    const Function*      fn   = &main_;
+
+    FlushOnExit  flush;
+    int64_t*     r    = stack.data();
+    const Instr* code = code_.data();
+    const Instr* ip   = code + main_.entry;
+    int64_t*     mem  = memory.data();
+    const Array* arr  = main_.arrays.data();
+
+    auto fault = [&](const char* what) {
+        throw std::runtime_error(std::string(what) + " at line " +
+                                 std::to_string(lines_[ip - code]));
+    };
+
+    // Unsigned, so a negative index is out of range too
+    auto checkIndex = [&](const Array& a, int64_t i) {
+        if (static_cast<uint64_t>(i) >= a.length)
+            throw std::runtime_error("Index " + std::to_string(i) + " out of range for int64[" +
+                                     std::to_string(a.length) + "] at line " +
+                                     std::to_string(lines_[ip - code]));
+    };
+
+    // Wrapping arithmetic, as in the IR (no nsw)
+#define NANO_WRAP(expr) static_cast<int64_t>(expr)
+#define U(x) static_cast<uint64_t>(r[ip->x])
+
+#if NANO_COMPUTED_GOTO
+    static const void* const labels[] = {
+        &&op_Move, &&op_Add, &&op_Sub, &&op_Mul, &&op_Div,
+        &&op_Eq, &&op_Ne, &&op_Lt, &&op_Gt, &&op_Le, &&op_Ge,
+        &&op_AddTrap, &&op_SubTrap, &&op_MulTrap, &&op_DivTrap,
+        &&op_AddSat, &&op_SubSat, &&op_MulSat, &&op_DivSat,
+        &&op_JumpIfZero, &&op_JumpIfNonZero, &&op_LoadElem, &&op_StoreElem,
+        &&op_Out, &&op_OutArray, &&op_Call, &&op_Ret, &&op_Halt,
+    };
+#define DISPATCH() goto *labels[static_cast<uint8_t>(ip->op)]
+#define CASE(name) op_##name
+#else
+#define DISPATCH() goto dispatch
+#define CASE(name) case Op::name
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (0)
+
+#if NANO_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch (ip->op) {
+#endif
+    CASE(Move): r[ip->a] = r[ip->b];                              NEXT();
+    CASE(Add):  r[ip->a] = NANO_WRAP(U(b) + U(c));                NEXT();
+    CASE(Sub):  r[ip->a] = NANO_WRAP(U(b) - U(c));                NEXT();
+    CASE(Mul):  r[ip->a] = NANO_WRAP(U(b) * U(c));                NEXT();
+    CASE(Div):
+        if (r[ip->c] == 0) fault("Division by zero");
+        // INT64_MIN / -1 wraps rather than trapping
+        r[ip->a] = r[ip->c] == -1 ? NANO_WRAP(0 - U(b)) : r[ip->b] / r[ip->c];
+        NEXT();
+    CASE(AddTrap):
+        if (addOverflow(r[ip->b], r[ip->c], r[ip->a])) fault("Integer overflow");
+        NEXT();
+    CASE(SubTrap):
+        if (subOverflow(r[ip->b], r[ip->c], r[ip->a])) fault("Integer overflow");
+        NEXT();
+    CASE(MulTrap):
+        if (mulOverflow(r[ip->b], r[ip->c], r[ip->a])) fault("Integer overflow");
+        NEXT();
+    CASE(DivTrap):
+        if (r[ip->c] == 0) fault("Division by zero");
+        if (divOverflow(r[ip->b], r[ip->c], r[ip->a])) fault("Integer overflow");
+        NEXT();
+    // The exact result's sign decides the bound: see evalBinOp
+    CASE(AddSat): {
+        int64_t v;
+        r[ip->a] = addOverflow(r[ip->b], r[ip->c], v) ? saturated(r[ip->b] < 0) : v;
+        NEXT();
+    }
+    CASE(SubSat): {
+        int64_t v;
+        r[ip->a] = subOverflow(r[ip->b], r[ip->c], v) ? saturated(r[ip->b] < 0) : v;
+        NEXT();
+    }
+    CASE(MulSat): {
+        int64_t v;
+        r[ip->a] = mulOverflow(r[ip->b], r[ip->c], v)
+                       ? saturated((r[ip->b] < 0) != (r[ip->c] < 0)) : v;
+        NEXT();
+    }
+    CASE(DivSat): {
+        if (r[ip->c] == 0) fault("Division by zero");
+        int64_t v;
+        r[ip->a] = divOverflow(r[ip->b], r[ip->c], v) ? saturated(false) : v;
+        NEXT();
+    }
+    CASE(Eq):   r[ip->a] = r[ip->b] == r[ip->c];                  NEXT();
+    CASE(Ne):   r[ip->a] = r[ip->b] != r[ip->c];                  NEXT();
+    CASE(Lt):   r[ip->a] = r[ip->b] <  r[ip->c];                  NEXT();
+    CASE(Gt):   r[ip->a] = r[ip->b] >  r[ip->c];                  NEXT();
+    CASE(Le):   r[ip->a] = r[ip->b] <= r[ip->c];                  NEXT();
+    CASE(Ge):   r[ip->a] = r[ip->b] >= r[ip->c];                  NEXT();
+    CASE(JumpIfZero):
+        if (r[ip->a] == 0) {
+            ip = code + ip->b;
+            DISPATCH();
+        }
+        NEXT();
+    CASE(JumpIfNonZero):
+        if (r[ip->a] != 0) {
+            ip = code + ip->b;
+            DISPATCH();
+        }
+        NEXT();
+    CASE(LoadElem): {
+        const Array& a = arr[ip->b];
+        checkIndex(a, r[ip->c]);
+        r[ip->a] = mem[a.base + r[ip->c]];
+        NEXT();
+    }
+    CASE(StoreElem): {
+        const Array& a = arr[ip->a];
+        checkIndex(a, r[ip->b]);
+        mem[a.base + r[ip->b]] = r[ip->c];
+        NEXT();
+    }
+    CASE(Out):  nano_out_i64(r[ip->a]);                           NEXT();
+    CASE(OutArray):
+        nano_out_i64s(mem + arr[ip->a].base, arr[ip->a].length);
+        NEXT();
+    CASE(Call): {
+        const Function& callee = functions_[ip->b];
+        if (frames.size() == MAX_CALL_DEPTH)
+            throw std::runtime_error("Calls nested more than " + std::to_string(MAX_CALL_DEPTH) +
+                                     " deep at line " + std::to_string(lines_[ip - code]));
+        frames.push_back({ip + 1, base, memBase, fn, ip->a});
+        const size_t args = base + ip->c;
+        base    = stack.size();
+        memBase = memory.size();
+        stack.insert(stack.end(), callee.frame.begin(), callee.frame.end());
+        std::copy_n(stack.begin() + static_cast<std::ptrdiff_t>(args), callee.params,
+                    stack.begin() + static_cast<std::ptrdiff_t>(base));
+        memory.resize(memBase + callee.memorySize);   // zeroed, like a fresh frame
+        fn  = &callee;
+        r   = stack.data() + base;
+        mem = memory.data() + memBase;
+        arr = callee.arrays.data();
+        ip  = code + callee.entry;
+        DISPATCH();
+    }
+    CASE(Ret): {
+        const int64_t value  = r[ip->a];
+        const Frame   caller = frames.back();
+        frames.pop_back();
+        stack.resize(base);
+        memory.resize(memBase);
+        base    = caller.regs;
+        memBase = caller.memory;
+        fn      = caller.fn;
+        r   = stack.data() + base;
+        mem = memory.data() + memBase;
+        arr = fn->arrays.data();
+        r[caller.dst] = value;
+        ip = caller.ret;
+        DISPATCH();
+    }
+    CASE(Halt): return 0;
+#if !NANO_COMPUTED_GOTO
+    }
+#endif
+    return 0;
+
+#undef NEXT
+#undef CASE
+#undef DISPATCH
+#undef U
+#undef NANO_WRAP
+}
+
+// ── Driver entry point ────────────────────────────────────────────────────
+
+int interpretFile(const std::string& inputFile, TimeReport* timing, ArithMode arith) {
+    const SourceFile file(inputFile);
+    auto ast = parseSource(file.text(), inputFile, timing);
+    {
+        TimeReport::Scope t(timing, "types");
+        checkTypes(*ast);
+    }
+    {
+        TimeReport::Scope t(timing, "fold");
+        optimizeAST(*ast, arith);
+    }
+    std::optional<Interpreter> interp;
+    {
+        TimeReport::Scope t(timing, "bytecode");
+        interp.emplace(*ast, arith);
+    }
+    TimeReport::Scope t(timing, "execute");
+    return interp->run();
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "arith.hpp"
+#include "ast.hpp"
+#include "timing.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Register-bytecode interpreter — executes a program with no LLVM at all.
+///
+/// The AST is compiled once into a flat instruction array. Each function
+/// (the top level is one too) runs over a register frame of its own laid
+/// out as [parameters and variables | constants | temporaries]. Literals
+/// are preloaded into constant registers, so operands never need decoding:
+/// every instruction names its registers directly. Output goes through the
+/// same runtime (nano_out_i64) as compiled programs.
+/// A frame's arrays live in a separate block of memory, each at a fixed
+/// offset; element-wise assignments compile to a loop over the elements.
+class Interpreter {
+public:
+    /// Compiles `program`, which checkTypes() has annotated; throws
+    /// std::runtime_error on the same errors codegen reports (e.g. a
+    /// variable read before any assignment). `arith` picks the arithmetic
+    /// instructions, as --arith does the IR.
+    explicit Interpreter(const ProgramNode& program, ArithMode arith = ArithMode::Wrap);
+
+    /// Execute from the top. Returns the script's exit code (always 0);
+    /// throws std::runtime_error on a runtime fault such as division by zero,
+    /// overflow under ArithMode::Trap, an index out of range or calls nested
+    /// too deeply.
+    int run();
+
+    size_t instructionCount() const { return code_.size(); }
+
+    enum class Op : uint8_t {
+        Move,                                    // a ← b
+        Add, Sub, Mul, Div, Eq, Ne, Lt, Gt, Le, Ge, // a ← b op c
+        AddTrap, SubTrap, MulTrap, DivTrap,      // …, overflow is an error
+        AddSat, SubSat, MulSat, DivSat,          // …, overflow saturates
+        JumpIfZero,                              // if a == 0: pc ← b
+        JumpIfNonZero,                           // if a != 0: pc ← b
+        LoadElem,                                // a ← array b [c]
+        StoreElem,                               // array a [b] ← c
+        Out,                                     // print a
+        OutArray,                                // print every element of array a
+        Call,                                    // a ← function b (arguments from c on)
+        Ret,                                     // return a to the caller
+        Halt,
+    };
+
+    struct Instr {
+        Op       op;
+        uint32_t a = 0, b = 0, c = 0;
+    };
+
+private:
+    struct Array {
+        uint32_t base;     // offset into the frame's array memory
+        uint32_t length;
+    };
+
+    /// A function's code and the frame a call of it starts with.
+    struct Function {
+        uint32_t             entry  = 0;   // first instruction
+        uint32_t             params = 0;   // passed in its first registers
+        std::vector<int64_t> frame;        // initial registers: zeros and constants
+        std::vector<Array>   arrays;
+        size_t               memorySize = 0;
+    };
+
+    /// Compile a body into `fn`; `def` is null for the top level.
+    void     compileFunction(Function& fn, const StmtNode* const* body, size_t count,
+                             const FunctionNode* def);
+    /// Register of variable `id`, allocated on its first assignment.
+    uint32_t slot(SymbolId id);
+
+    uint32_t compileExpr(const ExprNode& expr, uint32_t dst);
+    /// Array index of variable `id`, which must have been assigned.
+    uint32_t arrayOf(SymbolId id, int line) const;
+    uint32_t newArray(uint32_t length);
+    /// Store array expression `expr` into array `dst`: every operand is
+    /// read before the first element is written.
+    void     storeArray(uint32_t dst, const ExprNode& expr, int line);
+    void     hoistScalars(const ExprNode& expr, std::vector<uint32_t>& regs);
+    uint32_t compileElement(const ExprNode& expr, uint32_t k,
+                            const std::vector<uint32_t>& hoisted, size_t& next);
+    uint32_t constant(int64_t value);
+    uint32_t temp();
+    void     compileBlock(const StmtNode* const* stmts, size_t count);
+    void     emit(Op op, uint32_t a, uint32_t b, uint32_t c, int line);
+
+    const SymbolTable&    symbols_;
+    ArithMode             arith_;
+    std::vector<Instr>    code_;
+    std::vector<int>      lines_;       // source line per instruction
+    Function              main_;        // the top level, at instruction 0
+    std::vector<Function> functions_;   // by FunctionNode::index
+
+    // The function being compiled
+    Function*            current_ = nullptr;
+    std::vector<int64_t> constants_;   // initial values of constant registers
+    std::unordered_map<int64_t, uint32_t> constantIndex_;
+    std::vector<uint32_t> slots_;      // SymbolId → register, once assigned
+    std::vector<uint32_t> arrayIds_;   // SymbolId → index in current_->arrays
+    uint32_t             numVars_  = 0;
+    uint32_t             tempTop_  = 0; // next free temporary (relative)
+    uint32_t             maxTemps_ = 0;
+};
+
+/// Lex → parse → fold → interpret `inputFile`. Returns the exit code;
+/// throws on compile or runtime errors.
+int interpretFile(const std::string& inputFile, TimeReport* timing = nullptr,
+                  ArithMode arith = ArithMode::Wrap);
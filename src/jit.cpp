@@ -0,0 +1,80 @@
+#include "jit.hpp"
+
+#include "nano_rt.h"
+
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+
+#include <cstdio>
+#include <stdexcept>
+
+// Turn an llvm::Error into the std::runtime_error the driver reports
+static void check(llvm::Error err, const char* what) {
+    if (err)
+        throw std::runtime_error(std::string(what) + ": " +
+                                 llvm::toString(std::move(err)));
+}
+
+template <typename T>
+static T check(llvm::Expected<T> val, const char* what) {
+    if (!val)
+        throw std::runtime_error(std::string(what) + ": " +
+                                 llvm::toString(val.takeError()));
+    return std::move(*val);
+}
+
+int runJIT(ModuleHandle mod, BuildConfig config) {
+    initializeLLVMTargets();
+
+    auto jtmb = check(llvm::orc::JITTargetMachineBuilder::detectHost(),
+                      "Cannot detect JIT host");
+    jtmb.setCodeGenOptLevel(codeGenOptLevel(config));
+
+    auto jit = check(llvm::orc::LLJITBuilder()
+                         .setJITTargetMachineBuilder(std::move(jtmb))
+                         .create(),
+                     "Cannot create JIT");
+
+    // Runtime entry points bind to the compiler's own copy directly — the
+    // executable need not export them — and anything else resolves from
+    // the host process.
+    llvm::orc::JITDylib& jd = jit->getMainJITDylib();
+    llvm::orc::SymbolMap runtime;
+    auto bind = [&](const char* name, auto* fn) {
+        runtime[jit->mangleAndIntern(name)] = {
+            llvm::orc::ExecutorAddr::fromPtr(fn),
+            llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+    };
+    bind("nano_out_i64",     &nano_out_i64);
+    bind("nano_out_i64s",    &nano_out_i64s);
+    bind("nano_index_error", &nano_index_error);
+    bind("nano_arith_error", &nano_arith_error);
+    bind("nano_lines_register", &nano_lines_register);
+    check(jd.define(llvm::orc::absoluteSymbols(std::move(runtime))),
+          "Cannot define runtime symbols");
+    jd.addGenerator(check(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            jit->getDataLayout().getGlobalPrefix()),
+        "Cannot expose host symbols"));
+
+    // Codegen stamps the static native layout; the JIT owns the real one.
+    mod.module->setDataLayout(jit->getDataLayout());
+    mod.module->setTargetTriple(jit->getTargetTriple());
+
+    check(jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(mod.module),
+                                                       std::move(mod.context))),
+          "Cannot add module to JIT");
+
+    auto mainAddr = check(jit->lookup("main"), "Cannot resolve 'main'");
+    auto* mainFn  = mainAddr.toPtr<int (*)()>();
+
+    const int rc = mainFn();
+    nano_flush();   // don't leave the script's output to the compiler's exit
+    nano_lines_dump();   // the counters are freed with the JIT
+    std::fflush(stdout);
+    return rc;
+}
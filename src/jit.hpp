@@ -0,0 +1,11 @@
+#pragma once
+#include "codegen.hpp"
+
+/// Execute a generated module in-process with ORC LLJIT — no object file,
+/// no link step, nothing written to disk. The NanoScript runtime is the
+/// copy built into the compiler; libc resolves against the host process.
+///
+/// config picks the JIT backend opt level (Debug → None, Development →
+/// Default, Shipping → Aggressive); IR-level passes already ran in
+/// Codegen::generate. Returns the exit code produced by the script's main.
+int runJIT(ModuleHandle mod, BuildConfig config);
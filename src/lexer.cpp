@@ -1,114 +1,280 @@
 #include "lexer.hpp"
-#include <cctype>
-#include <stdexcept>
 
-Lexer::Lexer(const std::string& source, const std::string& filename)
-    : source_(source), filename_(filename) {}
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NANO_LEX_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NANO_LEX_NEON 1
+#endif
+
+namespace {
+
+// ── Character classes ─────────────────────────────────────────────────────
+// One table load per byte instead of the locale-aware <cctype> calls: only
+// ASCII letters and digits form identifiers, whatever the locale says.
+
+enum : uint8_t {
+    BLANK       = 1 << 0,   // ' ' and \t \n \v \f \r, isspace() in the "C" locale
+    DIGIT       = 1 << 1,   // [0-9]
+    IDENT_START = 1 << 2,   // [A-Za-z_]
+    IDENT       = 1 << 3,   // [A-Za-z0-9_]
+};
+
+constexpr std::array<uint8_t, 256> makeClasses() {
+    std::array<uint8_t, 256> t{};
+    for (int c = 0; c < 256; ++c) {
+        const bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        const bool digit = c >= '0' && c <= '9';
+        const bool blank = c == ' ' || (c >= '\t' && c <= '\r');
+        t[c] = static_cast<uint8_t>((blank ? BLANK : 0) | (digit ? DIGIT | IDENT : 0) |
+                                    (alpha ? IDENT_START | IDENT : 0));
+    }
+    return t;
+}
+constexpr std::array<uint8_t, 256> CLASSES = makeClasses();
+
+inline bool is(char c, uint8_t cls) { return CLASSES[static_cast<unsigned char>(c)] & cls; }
+
+// ── Keywords ──────────────────────────────────────────────────────────────
+// (2 * (first + last) + length) mod 16 is a perfect hash of the keywords:
+// one slot, one comparison. makeKeywords() refuses to compile a collision.
+
+struct Keyword {
+    std::string_view text;
+    TokenType        type = TokenType::IDENTIFIER;
+};
+
+constexpr size_t keywordSlot(std::string_view s) {
+    return (2 * (static_cast<unsigned char>(s.front()) + static_cast<unsigned char>(s.back())) +
+            s.size()) & 15;
+}
+
+constexpr std::array<Keyword, 16> makeKeywords() {
+    const Keyword all[] = {
+        {"if", TokenType::IF},         {"while", TokenType::WHILE},
+        {"for", TokenType::FOR},       {"out", TokenType::OUT},
+        {"fn", TokenType::FN},         {"return", TokenType::RETURN},
+        {"inline", TokenType::INLINE}, {"noinline", TokenType::NOINLINE},
+    };
+    std::array<Keyword, 16> table{};
+    for (const Keyword& k : all) {
+        if (!table[keywordSlot(k.text)].text.empty()) throw "keyword hash collision";
+        table[keywordSlot(k.text)] = k;
+    }
+    return table;
+}
+constexpr std::array<Keyword, 16> KEYWORDS = makeKeywords();
+
+// ── 16 bytes at a time ────────────────────────────────────────────────────
+// Masks of the blank and the newline bytes of a 16-byte chunk, BITS bits
+// per byte in source order: SSE2's movemask gives one; NEON has none, and
+// narrowing each 16-bit lane by 4 is the cheapest way to four.
+
+#if NANO_LEX_SSE2 || NANO_LEX_NEON
+#define NANO_LEX_SIMD 1
+
+struct Chunk {
+    uint64_t blank;
+    uint64_t newline;
+};
+
+#if NANO_LEX_SSE2
+constexpr unsigned BITS = 1;
+
+inline Chunk scan16(const char* p) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // \t..\r is c - 9 <= 4 unsigned, i.e. min(c - 9, 4) == c - 9
+    const __m128i t     = _mm_sub_epi8(v, _mm_set1_epi8(9));
+    const __m128i ctl   = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+    const __m128i blank = _mm_or_si128(ctl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    return {static_cast<uint64_t>(_mm_movemask_epi8(blank)),
+            static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))))};
+}
+#else
+constexpr unsigned BITS = 4;
+
+inline uint64_t movemask(uint8x16_t m) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+inline Chunk scan16(const char* p) {
+    const uint8x16_t v     = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    const uint8x16_t ctl   = vcleq_u8(vsubq_u8(v, vdupq_n_u8(9)), vdupq_n_u8(4));
+    const uint8x16_t blank = vorrq_u8(ctl, vceqq_u8(v, vdupq_n_u8(' ')));
+    return {movemask(blank), movemask(vceqq_u8(v, vdupq_n_u8('\n')))};
+}
+#endif
+
+constexpr uint64_t ALL = BITS == 1 ? 0xFFFF : ~uint64_t(0);
+
+// Byte index of the first / last set byte, and the number of set bytes
+#if defined(__GNUC__) || defined(__clang__)
+inline unsigned firstByte(uint64_t m) { return static_cast<unsigned>(__builtin_ctzll(m)) / BITS; }
+inline unsigned lastByte (uint64_t m) { return (63 - static_cast<unsigned>(__builtin_clzll(m))) / BITS; }
+inline unsigned countBytes(uint64_t m) { return static_cast<unsigned>(__builtin_popcountll(m)) / BITS; }
+#else
+inline unsigned firstByte(uint64_t m) { unsigned i = 0; while (!(m & 1)) { m >>= 1; ++i; } return i / BITS; }
+inline unsigned lastByte (uint64_t m) { unsigned i = 0; while (m >>= 1) ++i; return i / BITS; }
+inline unsigned countBytes(uint64_t m) { unsigned n = 0; for (; m; m &= m - 1) ++n; return n / BITS; }
+#endif
+
+#endif // NANO_LEX_SSE2 || NANO_LEX_NEON
+
+} // namespace
+
+Lexer::Lexer(std::string_view source, DiagnosticEngine& diag)
+    : source_(source), diag_(diag) {}
+
+Lexer::Lexer(std::string_view source, DiagnosticEngine& diag,
+             size_t offset, int line, int col)
+    : source_(source), diag_(diag), pos_(offset), line_(line),
+      lineStart_(offset - static_cast<size_t>(col - 1)) {}
 
 char Lexer::peek(int offset) const {
     size_t idx = pos_ + static_cast<size_t>(offset);
     return idx < source_.size() ? source_[idx] : '\0';
 }
 
-char Lexer::advance() {
-    char c = source_[pos_++];
-    if (c == '\n') { ++line_; col_ = 1; }
-    else           { ++col_;            }
-    return c;
-}
-
 void Lexer::skipWhitespaceAndComments() {
-    while (pos_ < source_.size()) {
-        char c = peek();
-        if (std::isspace(static_cast<unsigned char>(c))) {
-            advance();
-        } else if (c == '/' && peek(1) == '/') {
-            // Single-line comment — consume until newline
-            while (pos_ < source_.size() && peek() != '\n') advance();
-        } else {
-            break;
+    const char* const begin = source_.data();
+    const char* const end   = begin + source_.size();
+    const char*       p     = begin + pos_;
+    for (;;) {
+        // A run of blanks: whole chunks while they last, then byte by byte
+#if NANO_LEX_SIMD
+        while (end - p >= 16) {
+            const Chunk    c    = scan16(p);
+            const unsigned run  = c.blank == ALL ? 16 : firstByte(~c.blank & ALL);
+            const uint64_t seen = run == 16 ? c.newline
+                                            : c.newline & ((uint64_t(1) << (run * BITS)) - 1);
+            if (seen) {
+                line_      += static_cast<int>(countBytes(seen));
+                lineStart_  = static_cast<size_t>(p - begin) + lastByte(seen) + 1;
+            }
+            p += run;
+            if (run < 16) break;
         }
+#endif
+        for (; p < end && is(*p, BLANK); ++p)
+            if (*p == '\n') {
+                ++line_;
+                lineStart_ = static_cast<size_t>(p - begin) + 1;
+            }
+
+        if (end - p < 2 || p[0] != '/' || p[1] != '/') break;
+        // Single-line comment: up to the newline, which the blanks take
+#if NANO_LEX_SIMD
+        for (; end - p >= 16; p += 16)
+            if (const uint64_t nl = scan16(p).newline) {
+                p += firstByte(nl);
+                break;
+            }
+#endif
+        while (p < end && *p != '\n') ++p;
     }
+    pos_ = static_cast<size_t>(p - begin);
 }
 
 Token Lexer::lexNumber() {
-    int startLine = line_, startCol = col_;
-    std::string num;
-    while (pos_ < source_.size() && std::isdigit(static_cast<unsigned char>(peek())))
-        num += advance();
-    return {TokenType::INT_LITERAL, num, startLine, startCol};
+    const int startLine = line_, startCol = col(pos_);
+    size_t    start     = pos_;
+    // Checked before each step, so no literal can wrap back into range
+    constexpr uint64_t MAX      = static_cast<uint64_t>(INT64_MAX);
+    uint64_t           value    = 0;
+    bool               overflow = false;
+    for (; pos_ < source_.size() && is(source_[pos_], DIGIT); ++pos_) {
+        const auto d = static_cast<uint64_t>(source_[pos_] - '0');
+        overflow = overflow || value > (MAX - d) / 10;
+        if (!overflow) value = value * 10 + d;
+    }
+    // Still a literal, so the parser sees a well-formed expression
+    if (overflow)
+        diag_.error(startLine, startCol,
+                    "Integer literal '" + std::string(source_.substr(start, pos_ - start)) +
+                    "' out of range");
+    return {TokenType::INT_LITERAL, source_.substr(start, pos_ - start),
+            startLine, startCol, static_cast<int64_t>(value)};
 }
 
 Token Lexer::lexIdentifierOrKeyword() {
-    int startLine = line_, startCol = col_;
-    std::string ident;
-    while (pos_ < source_.size() &&
-           (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_'))
-        ident += advance();
-
-    TokenType type = TokenType::IDENTIFIER;
-    if (ident == "if")  type = TokenType::IF;
-    if (ident == "out") type = TokenType::OUT;
-    return {type, ident, startLine, startCol};
-}
+    const size_t start = pos_;
+    while (pos_ < source_.size() && is(source_[pos_], IDENT)) ++pos_;
 
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
+    std::string_view ident = source_.substr(start, pos_ - start);
+    const Keyword&   kw    = KEYWORDS[keywordSlot(ident)];
+    return {kw.text == ident ? kw.type : TokenType::IDENTIFIER, ident, line_, col(start)};
+}
 
-    while (true) {
+Token Lexer::next() {
+    // A character that starts no token is reported and skipped
+    for (;;) {
         skipWhitespaceAndComments();
 
-        if (pos_ >= source_.size()) {
-            tokens.push_back({TokenType::EOF_TOKEN, "", line_, col_});
-            break;
-        }
+        if (pos_ >= source_.size())
+            return {TokenType::EOF_TOKEN, source_.substr(pos_, 0), line_, col(pos_)};
 
-        int  startLine = line_;
-        int  startCol  = col_;
-        char c         = peek();
+        const int startLine = line_;
+        const int startCol  = col(pos_);
+        char      c         = source_[pos_];
 
-        if (std::isdigit(static_cast<unsigned char>(c))) {
-            tokens.push_back(lexNumber());
-            continue;
-        }
-        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
-            tokens.push_back(lexIdentifierOrKeyword());
-            continue;
-        }
+        if (is(c, DIGIT))
+            return lexNumber();
+        if (is(c, IDENT_START))
+            return lexIdentifierOrKeyword();
 
-        advance(); // consume the single character
+        size_t start = pos_++;   // consume the single character
+        // Operator text is a slice of the source, never a fresh string
+        auto tok = [&](TokenType type) {
+            return Token{type, source_.substr(start, pos_ - start), startLine, startCol};
+        };
         switch (c) {
             case '=':
-                if (peek() == '=') { advance(); tokens.push_back({TokenType::EQ,   "==", startLine, startCol}); }
-                else               {             tokens.push_back({TokenType::ASSIGN,"=", startLine, startCol}); }
-                break;
+                if (peek() == '=') { ++pos_; return tok(TokenType::EQ); }
+                return tok(TokenType::ASSIGN);
             case '!':
-                if (peek() == '=') { advance(); tokens.push_back({TokenType::NEQ,  "!=", startLine, startCol}); }
-                else throw std::runtime_error("Unexpected '!' at line " + std::to_string(startLine));
-                break;
+                if (peek() == '=') { ++pos_; return tok(TokenType::NEQ); }
+                diag_.error(startLine, startCol, "Unexpected '!' (did you mean '!='?)");
+                continue;
             case '<':
-                if (peek() == '=') { advance(); tokens.push_back({TokenType::LEQ,  "<=", startLine, startCol}); }
-                else               {             tokens.push_back({TokenType::LT,   "<",  startLine, startCol}); }
-                break;
+                if (peek() == '=') { ++pos_; return tok(TokenType::LEQ); }
+                return tok(TokenType::LT);
             case '>':
-                if (peek() == '=') { advance(); tokens.push_back({TokenType::GEQ,  ">=", startLine, startCol}); }
-                else               {             tokens.push_back({TokenType::GT,   ">",  startLine, startCol}); }
-                break;
-            case '+': tokens.push_back({TokenType::PLUS,      "+", startLine, startCol}); break;
-            case '-': tokens.push_back({TokenType::MINUS,     "-", startLine, startCol}); break;
-            case '*': tokens.push_back({TokenType::STAR,      "*", startLine, startCol}); break;
-            case '/': tokens.push_back({TokenType::SLASH,     "/", startLine, startCol}); break;
-            case ';': tokens.push_back({TokenType::SEMICOLON, ";", startLine, startCol}); break;
-            case '(': tokens.push_back({TokenType::LPAREN,    "(", startLine, startCol}); break;
-            case ')': tokens.push_back({TokenType::RPAREN,    ")", startLine, startCol}); break;
-            case '{': tokens.push_back({TokenType::LBRACE,    "{", startLine, startCol}); break;
-            case '}': tokens.push_back({TokenType::RBRACE,    "}", startLine, startCol}); break;
+                if (peek() == '=') { ++pos_; return tok(TokenType::GEQ); }
+                return tok(TokenType::GT);
+            case '+': return tok(TokenType::PLUS);
+            case '-': return tok(TokenType::MINUS);
+            case '*': return tok(TokenType::STAR);
+            case '/': return tok(TokenType::SLASH);
+            case ';': return tok(TokenType::SEMICOLON);
+            case '(': return tok(TokenType::LPAREN);
+            case ')': return tok(TokenType::RPAREN);
+            case '{': return tok(TokenType::LBRACE);
+            case '}': return tok(TokenType::RBRACE);
+            case '[': return tok(TokenType::LBRACKET);
+            case ']': return tok(TokenType::RBRACKET);
+            case ',': return tok(TokenType::COMMA);
             default:
-                throw std::runtime_error(
-                    std::string("Unexpected character '") + c +
-                    "' at line " + std::to_string(startLine));
+                // One report per UTF-8 sequence, not one per byte
+                while (pos_ < source_.size() && (static_cast<unsigned char>(peek()) & 0xC0) == 0x80)
+                    ++pos_;
+                diag_.error(startLine, startCol,
+                            "Unexpected character '" +
+                            std::string(source_.substr(start, pos_ - start)) + "'");
+                continue;
         }
     }
+}
+
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    tokens.reserve(source_.size() / 4);   // ~1 token per 4 bytes of typical source
+
+    do {
+        tokens.push_back(next());
+    } while (tokens.back().type != TokenType::EOF_TOKEN);
 
     return tokens;
 }
@@ -1,5 +1,9 @@
 #pragma once
+#include "diagnostics.hpp"
+
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 enum class TokenType {
@@ -8,7 +12,13 @@ enum class TokenType {
     // Identifiers / keywords
     IDENTIFIER,
     IF,
+    WHILE,
+    FOR,
     OUT,
+    FN,
+    RETURN,
+    INLINE,
+    NOINLINE,
     // Operators
     ASSIGN,   // =
     PLUS,     // +
@@ -27,31 +37,54 @@ enum class TokenType {
     RPAREN,
     LBRACE,
     RBRACE,
+    LBRACKET,
+    RBRACKET,
+    COMMA,
     // End of input
     EOF_TOKEN,
 };
 
 struct Token {
-    TokenType   type;
-    std::string value;
-    int         line;
-    int         col;
+    TokenType        type;
+    std::string_view text;         // slice of the lexer's source buffer
+    int              line;
+    int              col;
+    int64_t          intValue = 0; // INT_LITERAL only — parsed once while lexing
 };
 
 class Lexer {
 public:
-    Lexer(const std::string& source, const std::string& filename);
+    /// `source` is not copied: it must outlive the lexer and every Token
+    /// (and anything holding a Token's text) produced from it. Malformed
+    /// input is reported to `diag` and skipped, so lexing always finishes.
+    Lexer(std::string_view source, DiagnosticEngine& diag);
+
+    /// Resume lexing at byte `offset` of `source`, which is at `line`/`col`
+    /// (must be outside a token and a comment, e.g. a StmtSpan's end).
+    Lexer(std::string_view source, DiagnosticEngine& diag,
+          size_t offset, int line, int col);
+
+    /// Lex and return the next token; repeats EOF_TOKEN once input is exhausted.
+    Token next();
+
+    DiagnosticEngine& diagnostics() const { return diag_; }
+
+    /// Lex the whole input up front (EOF_TOKEN last).
     std::vector<Token> tokenize();
 
+    std::string_view source() const { return source_; }
+
 private:
-    const std::string& source_;
-    std::string        filename_;
-    size_t             pos_  = 0;
-    int                line_ = 1;
-    int                col_  = 1;
+    std::string_view   source_;
+    DiagnosticEngine&  diag_;
+    size_t             pos_       = 0;
+    // Only newlines are counted, and only between tokens (no token spans
+    // one): a column is its offset from the start of the line
+    int                line_      = 1;
+    size_t             lineStart_ = 0;   // offset of line_'s first byte
 
     char        peek(int offset = 0) const;
-    char        advance();
+    int         col(size_t offset) const { return static_cast<int>(offset - lineStart_) + 1; }
     void        skipWhitespaceAndComments();
     Token       lexNumber();
     Token       lexIdentifierOrKeyword();
@@ -0,0 +1,299 @@
+#include "linker.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#endif
+
+#if NANOSCRIPT_HAVE_LLD
+#include <lld/Common/Driver.h>
+
+LLD_HAS_DRIVER(elf)
+LLD_HAS_DRIVER(macho)
+LLD_HAS_DRIVER(wasm)
+#endif
+
+// ── Toolchain locations ───────────────────────────────────────────────────
+// CMake passes in the clang, WASI sysroot and compiler-rt builtins it found;
+// the fallbacks are Homebrew's locations on Apple Silicon.
+#ifndef NANOSCRIPT_CLANG
+#define NANOSCRIPT_CLANG "/opt/homebrew/opt/llvm/bin/clang"
+#endif
+#ifndef NANOSCRIPT_WASI_SYSROOT
+#define NANOSCRIPT_WASI_SYSROOT "/opt/homebrew/opt/wasi-libc/share/wasi-sysroot"
+#endif
+// libclang_rt.builtins for wasm32-wasi, from clang's resource directory
+#ifndef NANOSCRIPT_WASM_BUILTINS
+#define NANOSCRIPT_WASM_BUILTINS ""
+#endif
+static constexpr const char* LLVM_CLANG   = NANOSCRIPT_CLANG;
+static constexpr const char* WASI_SYSROOT = NANOSCRIPT_WASI_SYSROOT;
+static constexpr const char* MACOS_SDK    =
+    "/Library/Developer/CommandLineTools/SDKs/MacOSX.sdk";
+static constexpr const char* MACOS_MIN_VERSION = "13.0";
+
+// wasmtime for --emit=cwasm, as found by CMake (else whatever is on PATH)
+#ifndef NANOSCRIPT_WASMTIME
+#define NANOSCRIPT_WASMTIME "wasmtime"
+#endif
+
+// Paths of the runtime built by CMake next to the compiler
+#ifndef NANOSCRIPT_RUNTIME_NATIVE
+#define NANOSCRIPT_RUNTIME_NATIVE ""
+#endif
+#ifndef NANOSCRIPT_RUNTIME_WASM
+#define NANOSCRIPT_RUNTIME_WASM ""
+#endif
+// ... and as ThinLTO bitcode, when LLVM's clang was found to build it
+#ifndef NANOSCRIPT_RUNTIME_NATIVE_BC
+#define NANOSCRIPT_RUNTIME_NATIVE_BC ""
+#endif
+#ifndef NANOSCRIPT_RUNTIME_WASM_BC
+#define NANOSCRIPT_RUNTIME_WASM_BC ""
+#endif
+// compiler-rt's libclang_rt.profile for --profile-generate, from clang's
+// resource directory
+#ifndef NANOSCRIPT_PROFILE_RUNTIME_NATIVE
+#define NANOSCRIPT_PROFILE_RUNTIME_NATIVE ""
+#endif
+#ifndef NANOSCRIPT_PROFILE_RUNTIME_WASM
+#define NANOSCRIPT_PROFILE_RUNTIME_WASM ""
+#endif
+// GCC's install directory (crtbeginS.o, crtendS.o, libgcc) for ELF links
+#ifndef NANOSCRIPT_GCC_LIB_DIR
+#define NANOSCRIPT_GCC_LIB_DIR ""
+#endif
+// ... and libc's (Scrt1.o, crti.o, crtn.o, libc.so)
+#ifndef NANOSCRIPT_CRT_DIR
+#define NANOSCRIPT_CRT_DIR ""
+#endif
+
+std::string runtimeLibrary(bool wasm, bool thinLTO) {
+    if (thinLTO) {
+        const std::string bc = wasm ? NANOSCRIPT_RUNTIME_WASM_BC : NANOSCRIPT_RUNTIME_NATIVE_BC;
+        if (!bc.empty()) return bc;
+    }
+    const std::string path = wasm ? NANOSCRIPT_RUNTIME_WASM : NANOSCRIPT_RUNTIME_NATIVE;
+    if (path.empty())
+        throw std::runtime_error(wasm
+            ? "wasm32-wasi runtime was not built; reconfigure with a valid "
+              "NANOSCRIPT_WASI_SYSROOT"
+            : "native runtime path unknown; build the compiler through CMake");
+    return path;
+}
+
+std::string profileRuntime(bool wasm) {
+    const std::string path = wasm ? NANOSCRIPT_PROFILE_RUNTIME_WASM
+                                  : NANOSCRIPT_PROFILE_RUNTIME_NATIVE;
+    if (path.empty())
+        throw std::runtime_error(std::string("compiler-rt profile runtime for ") +
+                                 (wasm ? "wasm32-wasi" : "this machine") +
+                                 " was not found; --profile-generate executables "
+                                 "cannot be linked");
+    return path;
+}
+
+int precompileWasm(const std::string& wasm, const std::string& cwasm) {
+    const std::string cmd = std::string("\"") + NANOSCRIPT_WASMTIME + "\" compile -o \"" +
+                            cwasm + "\" \"" + wasm + "\"";
+    return std::system(cmd.c_str());
+}
+
+const std::string& wasmtimeVersion() {
+    static const std::string version = [] {
+        std::string out;
+        const std::string cmd = std::string("\"") + NANOSCRIPT_WASMTIME + "\" --version";
+        if (FILE* p = popen(cmd.c_str(), "r")) {
+            char buf[256];
+            while (std::fgets(buf, sizeof buf, p)) out += buf;
+            pclose(p);
+        }
+        while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+        return out;
+    }();
+    return version;
+}
+
+bool linkNeedsObjectsForDebugInfo(BuildConfig config, bool wasm) {
+    // Mach-O executables reference DWARF through the debug map rather than
+    // embedding it, so LLDB needs the object file to stay on disk.
+    return !wasm && config != BuildConfig::Shipping &&
+           llvm::Triple(llvm::sys::getDefaultTargetTriple()).isOSBinFormatMachO();
+}
+
+#if NANOSCRIPT_HAVE_LLD
+
+// ── Per-flavour argument vectors ──────────────────────────────────────────
+// These mirror what the clang driver passes to each linker for a plain C
+// program, so the in-process link produces the same artifact as before.
+
+// All three flavours spell the LTO options the same way
+static void appendLTOArgs(const LinkJob& job, std::vector<std::string>& args) {
+    if (!job.thinLTO) return;
+    args.insert(args.end(), {"--lto-O3", "--thinlto-jobs=all"});
+}
+
+// The profile runtime registers its exit hook from an object nothing else
+// references: pull it in, as clang does for -fprofile-generate
+static void appendProfileArgs(const LinkJob& job, const std::string& symbol,
+                              std::vector<std::string>& args) {
+    if (!job.profile) return;
+    args.insert(args.end(), {"-u", symbol, profileRuntime(job.wasm)});
+}
+
+static std::string wasmBuiltins() {
+    const std::string path = NANOSCRIPT_WASM_BUILTINS;
+    if (path.empty())
+        throw std::runtime_error("compiler-rt builtins for wasm32-wasi were not found; "
+                                 "--wasm executables cannot be linked");
+    return path;
+}
+
+static std::vector<std::string> wasmArgs(const LinkJob& job) {
+    const std::string libDir = std::string(WASI_SYSROOT) + "/lib/wasm32-wasi";
+    std::vector<std::string> args = {
+        "wasm-ld", "-m", "wasm32",
+        "-L" + libDir,
+        libDir + "/crt1-command.o",
+    };
+    args.insert(args.end(), job.objects.begin(), job.objects.end());
+    appendProfileArgs(job, "__llvm_profile_runtime", args);
+    args.insert(args.end(), {"-lc", wasmBuiltins(), "-o", job.output});
+    appendLTOArgs(job, args);
+    if (job.startup)
+        // An import only survives if a function that is kept calls it
+        args.insert(args.end(), {"--gc-sections", "--strip-all", "-O2"});
+    else if (job.config == BuildConfig::Shipping)
+        args.push_back("--strip-all");
+    return args;
+}
+
+static std::vector<std::string> machoArgs(const LinkJob& job,
+                                          const llvm::Triple& triple) {
+    const std::string arch = triple.getArch() == llvm::Triple::aarch64
+        ? "arm64" : triple.getArchName().str();
+    std::vector<std::string> args = {
+        "ld64.lld",
+        "-arch", arch,
+        "-platform_version", "macos", MACOS_MIN_VERSION, MACOS_MIN_VERSION,
+        "-syslibroot", MACOS_SDK,
+        "-lSystem",
+    };
+    args.insert(args.end(), job.objects.begin(), job.objects.end());
+    appendProfileArgs(job, "___llvm_profile_runtime", args);
+    args.insert(args.end(), {"-o", job.output});
+    appendLTOArgs(job, args);
+    if (job.config == BuildConfig::Shipping)
+        args.push_back("-dead_strip");
+    return args;
+}
+
+static std::string gccLibDir() {
+    const std::string dir = NANOSCRIPT_GCC_LIB_DIR;
+    if (dir.empty())
+        throw std::runtime_error("GCC install directory unknown; build the compiler "
+                                 "through CMake with a GCC toolchain on this machine");
+    return dir;
+}
+
+static std::string libcCrtDir() {
+    const std::string dir = NANOSCRIPT_CRT_DIR;
+    if (dir.empty())
+        throw std::runtime_error("libc start files (Scrt1.o) not found; build the "
+                                 "compiler through CMake with a C toolchain on this machine");
+    return dir;
+}
+
+static std::vector<std::string> elfArgs(const LinkJob& job,
+                                        const llvm::Triple& triple) {
+    const bool arm64 = triple.getArch() == llvm::Triple::aarch64;
+    const std::string crtDir  = libcCrtDir();
+    const std::string gccDir  = gccLibDir();
+    std::vector<std::string> args = {
+        "ld.lld",
+        "-m", arm64 ? "aarch64linux" : "elf_x86_64",
+        "-pie", "--eh-frame-hdr",
+        "-dynamic-linker", arm64 ? "/lib/ld-linux-aarch64.so.1"
+                                 : "/lib64/ld-linux-x86-64.so.2",
+        crtDir + "/Scrt1.o",
+        crtDir + "/crti.o",
+        gccDir + "/crtbeginS.o",
+        "-L" + gccDir,
+        "-L" + crtDir,
+    };
+    args.insert(args.end(), job.objects.begin(), job.objects.end());
+    appendProfileArgs(job, "__llvm_profile_runtime", args);
+    // libgcc around libc, in the order gcc's driver uses
+    args.insert(args.end(), {
+        "-lgcc", "--as-needed", "-lgcc_s", "--no-as-needed",
+        "-lc",
+        "-lgcc", "--as-needed", "-lgcc_s", "--no-as-needed",
+        gccDir + "/crtendS.o",
+        crtDir + "/crtn.o",
+        "-o", job.output,
+    });
+    appendLTOArgs(job, args);
+    if (job.config == BuildConfig::Shipping)
+        args.insert(args.end(), {"--gc-sections", "--strip-all"});
+    return args;
+}
+
+int linkExecutable(const LinkJob& job) {
+    const llvm::Triple triple(job.wasm            ? std::string("wasm32-unknown-wasi")
+                              : !job.triple.empty() ? job.triple
+                                                    : llvm::sys::getDefaultTargetTriple());
+
+    std::vector<std::string> args =
+        job.wasm                    ? wasmArgs(job)
+      : triple.isOSBinFormatMachO() ? machoArgs(job, triple)
+                                    : elfArgs(job, triple);
+
+    std::vector<const char*> argv;
+    argv.reserve(args.size());
+    for (const auto& a : args) argv.push_back(a.c_str());
+
+    // The LTO backend inside LLD looks targets up in the registry
+    if (job.thinLTO) initializeLLVMTargets();
+
+    // LLD keeps global state per link; it may be re-entered sequentially
+    // but never concurrently, so serialise links within the process.
+    static std::mutex lldMutex;
+    std::lock_guard<std::mutex> lock(lldMutex);
+
+    lld::Result r = lld::lldMain(argv, llvm::outs(), llvm::errs(),
+                                 {{lld::Gnu,    &lld::elf::link},
+                                  {lld::Darwin, &lld::macho::link},
+                                  {lld::Wasm,   &lld::wasm::link}});
+    return r.retCode;
+}
+
+#else // !NANOSCRIPT_HAVE_LLD
+
+// ── Fallback: hand the objects to the clang driver ────────────────────────
+
+int linkExecutable(const LinkJob& job) {
+    std::string cmd = LLVM_CLANG;
+    if (job.wasm)
+        cmd += std::string(" --target=wasm32-wasi --sysroot=") + WASI_SYSROOT;
+    if (job.thinLTO)
+        cmd += " -flto=thin -fuse-ld=lld -O3";   // only lld reads the bitcode here
+    if (job.profile)
+        cmd += " -fprofile-generate";            // links the profile runtime
+    if (job.wasm && job.startup)
+        cmd += " -Wl,--gc-sections,--strip-all,-O2";
+    for (const auto& obj : job.objects)
+        cmd += " " + obj;
+    cmd += " -o " + job.output;
+    return std::system(cmd.c_str());
+}
+
+#endif
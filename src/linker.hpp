@@ -0,0 +1,53 @@
+#pragma once
+#include "codegen.hpp"
+
+#include <string>
+#include <vector>
+
+/// Everything the final link step needs — objects in, one executable out.
+struct LinkJob {
+    std::vector<std::string> objects;   // relocatable inputs (.o)
+    std::string              output;    // executable / .wasm path
+    BuildConfig              config = BuildConfig::Debug;
+    bool                     wasm   = false;
+    std::string              triple;            // default: the host's
+    /// Some objects are ThinLTO bitcode: the linker runs the O3 backend on
+    /// them, one module per thread, importing across module boundaries.
+    bool                     thinLTO = false;
+    /// The objects are instrumented (--profile-generate): link the profile
+    /// runtime, which writes the counters out at exit.
+    bool                     profile = false;
+    /// --wasm-startup: keep only what is reachable from _start, so the
+    /// module imports no WASI function it never calls, and drop its names.
+    bool                     startup = false;
+};
+
+/// Link `job.objects` into `job.output`.
+/// Uses the in-process LLD drivers (ld64.lld / ld.lld / wasm-ld) when the
+/// compiler was built against LLD; otherwise falls back to the clang driver.
+/// Returns 0 on success, the linker's exit code otherwise.
+int linkExecutable(const LinkJob& job);
+
+/// The NanoScript runtime archive/object to link into every executable for
+/// the given target (built alongside the compiler). Throws when the wasm
+/// runtime was not built because no WASI sysroot was found at configure time.
+/// With `thinLTO` it is the runtime's ThinLTO bitcode, so nano_out_i64 can
+/// be imported into the program — when clang was found to build it; the
+/// native runtime is returned otherwise.
+std::string runtimeLibrary(bool wasm, bool thinLTO = false);
+
+/// `wasmtime compile` `wasm` into the precompiled module `cwasm`, for
+/// `wasmtime run --allow-precompiled`. Returns wasmtime's exit code.
+int precompileWasm(const std::string& wasm, const std::string& cwasm);
+
+/// `wasmtime --version`, read once: a .cwasm only loads into the wasmtime
+/// that compiled it. Empty when wasmtime cannot be run.
+const std::string& wasmtimeVersion();
+
+/// compiler-rt's profile runtime for the target, found next to LLVM's clang
+/// at configure time. Throws when there is none.
+std::string profileRuntime(bool wasm);
+
+/// True when the linked executable only references its DWARF (Mach-O debug
+/// map), so the object files must be kept next to it for the debugger.
+bool linkNeedsObjectsForDebugInfo(BuildConfig config, bool wasm);
@@ -1,63 +1,199 @@
-#include <cstdlib>
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
-#include "codegen.hpp"
-#include "lexer.hpp"
-#include "parser.hpp"
+#include "interp.hpp"
+#include "timing.hpp"
 
-static constexpr const char* LLVM_CLANG  =
-    "/opt/homebrew/opt/llvm/bin/clang";
-static constexpr const char* WASI_SYSROOT =
-    "/opt/homebrew/opt/wasi-libc/share/wasi-sysroot";
+// ── --time-report ─────────────────────────────────────────────────────────
+// Printed on stderr when main returns, on success and failure alike.
+struct TimeReportOutput {
+    TimeReport report;
+    bool       enabled = false;
+    bool       json    = false;
+
+    TimeReport* get() { return enabled ? &report : nullptr; }
+
+    /// Consumes --time-report[=json]; false if `arg` is something else.
+    bool parse(const std::string& arg) {
+        if (arg == "--time-report")      { enabled = true;        return true; }
+        if (arg == "--time-report=json") { enabled = json = true; return true; }
+        return false;
+    }
+
+    ~TimeReportOutput() {
+        if (!enabled) return;
+        if (json) report.printJSON(std::cerr);
+        else      report.print(std::cerr);
+    }
+};
+
+#ifdef NANOSCRIPT_NO_LLVM
+
+// ── Interpreter-only build (NANOSCRIPT_ENABLE_LLVM=OFF) ───────────────────
+int main(int argc, char* argv[]) {
+    TimeReportOutput         timing;
+    std::vector<std::string> args;
+    ArithMode                arith = ArithMode::Wrap;
+    bool                     valid = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        // --interpret is implied — there is no other backend
+        if (arg.rfind("--arith=", 0) == 0)
+            valid = valid && parseArithMode(arg.substr(8), arith);
+        else if (arg != "--interpret" && !timing.parse(arg))
+            args.push_back(arg);
+    }
+    if (!valid || args.size() != 2 || args[0] != "run") {
+        std::cerr << "Usage: nanoscript run [--interpret] [--arith=wrap|trap|saturate]\n"
+                     "                      [--time-report[=json]] <source.nano>\n"
+                     "\n"
+                     "This nanoscript was built without LLVM: programs can be run\n"
+                     "by the bytecode interpreter, but not compiled.\n";
+        return 1;
+    }
+    try {
+        return interpretFile(args[1], timing.get(), arith);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+#else
+
+#include "driver.hpp"
+#include "watch.hpp"
 
 static void printUsage() {
     std::cerr <<
         "Usage: nanoscript <source.nano> [options] [output]\n"
+        "       nanoscript run <source.nano> [--config=...] [--interpret]\n"
+        "       nanoscript build <a.nano> <b.nano> ... | @filelist [options]\n"
+        "\n"
+        "  run                   JIT-compile and execute in-process (ORC LLJIT);\n"
+        "                        nothing is written to disk\n"
+        "  run --interpret       Execute on the bytecode interpreter instead —\n"
+        "                        no LLVM context, module or JIT is created\n"
+        "  build                 Compile many files on a worker pool; failures\n"
+        "                        are reported per file without stopping the batch.\n"
+        "                        @filelist reads one path per line ('#' comments)\n"
         "\n"
         "  --config=debug        O0  + DWARF debug info  [default]\n"
+        "  --config=fast         SROA, instcombine, simplifycfg, GVN + DWARF\n"
         "  --config=development  O2  + DWARF debug info\n"
         "  --config=shipping     O3 (full LTO) + no debug info\n"
+        "  --lto=thin            shipping: ThinLTO instead — pre-link pipeline\n"
+        "                        here, the O3 backend in the link on every core,\n"
+        "                        importing from the runtime's bitcode\n"
+        "                        (--emit=exe or bc; --lto=full is the default)\n"
         "\n"
         "  --wasm                Emit a .wasm binary (default: native binary)\n"
+        "  --wasm-startup        --wasm tuned for cold start: SIMD, bulk memory\n"
+        "                        and sign-ext enabled, optimised for size (Oz),\n"
+        "                        unreachable code and its WASI imports dropped\n"
+        "  --target=TRIPLE       Native code for TRIPLE, e.g. aarch64-linux-gnu\n"
+        "                        (default: this machine; other targets stop at\n"
+        "                        --emit=obj|asm|ll|bc — the runtime is host-built)\n"
+        "  --cpu=NAME            Schedule and select for CPU NAME (e.g. neoverse-v1,\n"
+        "                        x86-64-v3); 'native' is this machine's CPU with\n"
+        "                        all of its features (default: generic)\n"
+        "  --features=LIST       Extra target features, e.g. +avx2,+fma,-avx512f\n"
+        "  --ssa                 Build variables as SSA values with phis rather\n"
+        "                        than stack slots (DWARF via dbg.value)\n"
+        "  --profile-generate    development/shipping: instrument the program;\n"
+        "                        each run writes default_<id>.profraw (or\n"
+        "                        $LLVM_PROFILE_FILE) for llvm-profdata merge\n"
+        "  --profile-use=FILE    development/shipping: optimise with the merged\n"
+        "                        .profdata of an instrumented build, same flags\n"
+        "  --instrument=lines    Count every execution of every statement; at\n"
+        "                        exit the program writes the counts, hottest\n"
+        "                        first, as flamegraph folded stacks to\n"
+        "                        $NANO_LINES_FILE (default nano-lines.folded)\n"
+        "  --arith=MODE          On int64 overflow: wrap (two's complement)\n"
+        "                        [default], trap (report the line and exit 1)\n"
+        "                        or saturate (clamp to the int64 range).\n"
+        "                        Division by zero is an error in every mode\n"
+        "  --codegen-threads=N   --emit=exe: split a program with functions into\n"
+        "                        up to N modules, optimised and emitted on N\n"
+        "                        threads and linked together (shipping: after\n"
+        "                        its whole-program pipeline; default 1)\n"
+        "\n"
+        "  --emit=exe            Linked executable  [default]\n"
+        "  --emit=obj            Relocatable object file, no link\n"
+        "  --emit=asm            Target assembly\n"
+        "  --emit=ll             Textual LLVM IR\n"
+        "  --emit=bc             LLVM bitcode\n"
+        "  --emit=cwasm          --wasm: ahead-of-time compiled by wasmtime, for\n"
+        "                        'wasmtime run --allow-precompiled'\n"
+        "\n"
+        "  --no-cache            Always compile; don't read or write the cache\n"
+        "  --cache-dir=DIR       Artifact cache location\n"
+        "                        (default: $NANOSCRIPT_CACHE_DIR or ~/.cache/nanoscript)\n"
+        "  --cache-size=MIB      LRU-evict the cache beyond this size (default: 1024)\n"
+        "  --cache-stats         Print cache hit rate and size (inputs optional)\n"
+        "\n"
+        "  --time-report         Print wall/CPU time and peak RSS per phase and\n"
+        "                        per LLVM pass on stderr (lexing is then done\n"
+        "                        up front rather than streamed into the parser)\n"
+        "  --time-report=json    The same, as one JSON object\n"
+        "\n"
+        "  --max-memory=MIB      Memory budget per file: when a whole-program\n"
+        "                        build is estimated to need more, parse and\n"
+        "                        lower it one top-level statement at a time,\n"
+        "                        freeing each as soon as it has been lowered\n"
+        "\n"
+        "  --watch               Stay resident and rebuild after every save of the\n"
+        "                        source, re-parsing only the edited statements and\n"
+        "                        regenerating code from the first of them on\n"
+        "                        (no cache, no AST folding)\n"
+        "\n"
+        "  -j N, --jobs=N        build: worker threads (default: all cores)\n"
+        "  --out-dir=DIR         build: directory for artifacts (default: cwd)\n"
         "\n"
         "  output  Path for the produced artifact.\n"
-        "          Defaults to <stem>.wasm (--wasm) or <stem> (native).\n";
+        "          Defaults to <stem>.wasm (--wasm) or <stem> (native),\n"
+        "          <stem>.cwasm (--emit=cwasm), or <stem>.o/.s/.ll/.bc for the\n"
+        "          intermediate --emit kinds.\n";
 }
 
-static std::string defaultOutput(const std::string& inputFile, bool wasm) {
-    std::filesystem::path p(inputFile);
-    std::string stem = p.stem().string();
-    return wasm ? (stem + ".wasm") : stem;
+static const char* describe(const CompileOptions& opts) {
+    switch (opts.config) {
+        case BuildConfig::Debug:       return "debug / O0 / DWARF";
+        case BuildConfig::Fast:        return "fast / lean pipeline / DWARF";
+        case BuildConfig::Development: return "development / O2 / DWARF";
+        case BuildConfig::Shipping:
+            return opts.codegen.lto == LTOMode::Thin ? "shipping / O3+ThinLTO"
+                                                     : "shipping / O3+LTO";
+    }
+    return "";
 }
 
-static int linkArtifact(const std::string& tmpLL,
-                        const std::string& outputFile,
-                        BuildConfig config,
-                        bool wasm) {
-    std::string cmd;
-    if (wasm) {
-        const std::string dbg = (config != BuildConfig::Shipping) ? " -g" : "";
-        cmd = std::string(LLVM_CLANG)
-            + " --target=wasm32-wasi"
-            + " --sysroot=" + WASI_SYSROOT
-            + dbg
-            + " " + tmpLL + " -o " + outputFile;
-    } else {
-        // -Wno-override-module suppresses the cosmetic "overriding module triple"
-        // warning that clang emits when it normalises darwin→macosx in the triple.
-        const std::string dbg = (config != BuildConfig::Shipping) ? " -g" : " -O3";
-        cmd = std::string(LLVM_CLANG) + dbg
-            + " -Wno-override-module"
-            + " " + tmpLL + " -o " + outputFile;
-    }
-
-    const int rc = std::system(cmd.c_str());
-    std::filesystem::remove(tmpLL);
-    return rc;
+// Expand @filelist arguments into the paths they contain
+static bool appendInputs(const std::string& arg, std::vector<std::string>& inputs) {
+    if (arg.empty() || arg[0] != '@') {
+        inputs.push_back(arg);
+        return true;
+    }
+    std::ifstream list(arg.substr(1));
+    if (!list) {
+        std::cerr << "Error: cannot open file list '" << arg.substr(1) << "'\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        const auto b = line.find_first_not_of(" \t\r");
+        if (b == std::string::npos || line[b] == '#') continue;
+        const auto e = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(b, e - b + 1));
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
@@ -67,90 +203,298 @@ int main(int argc, char* argv[]) {
     }
 
     // ── Argument parsing ───────────────────────────────────────────────────
-    std::string inputFile;
-    std::string outputArg;
-    BuildConfig config = BuildConfig::Debug;
-    bool        wasm   = false;
+    const std::string mode  = argv[1];
+    const bool        run   = mode == "run";
+    const bool        batch = mode == "build";
 
-    for (int i = 1; i < argc; ++i) {
+    std::vector<std::string> inputs;
+    std::string    outputArg;
+    std::string    outDir;
+    CompileOptions opts;
+    unsigned       jobs = std::thread::hardware_concurrency();
+    bool           interpret  = false;
+    bool           watch      = false;
+    bool           useCache   = true;
+    bool           cacheStats = false;
+    std::string    cacheDir   = ArtifactCache::defaultDir();
+    uint64_t       cacheMiB   = 1024;
+    TimeReportOutput timing;
+
+    for (int i = (run || batch) ? 2 : 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg.rfind("--config=", 0) == 0) {
             std::string val = arg.substr(9);
-            if      (val == "debug")       config = BuildConfig::Debug;
-            else if (val == "development") config = BuildConfig::Development;
-            else if (val == "shipping")    config = BuildConfig::Shipping;
+            if      (val == "debug")       opts.config = BuildConfig::Debug;
+            else if (val == "fast")        opts.config = BuildConfig::Fast;
+            else if (val == "development") opts.config = BuildConfig::Development;
+            else if (val == "shipping")    opts.config = BuildConfig::Shipping;
             else {
                 std::cerr << "Unknown config '" << val
-                          << "'. Expected debug, development, or shipping.\n";
+                          << "'. Expected debug, fast, development, or shipping.\n";
+                return 1;
+            }
+        } else if (arg.rfind("--target=", 0) == 0) {
+            opts.codegen.target.triple = arg.substr(9);
+        } else if (arg.rfind("--cpu=", 0) == 0) {
+            opts.codegen.target.cpu = arg.substr(6);
+        } else if (arg.rfind("--features=", 0) == 0) {
+            opts.codegen.target.features = arg.substr(11);
+        } else if (arg.rfind("--lto=", 0) == 0) {
+            std::string val = arg.substr(6);
+            if      (val == "full") opts.codegen.lto = LTOMode::Full;
+            else if (val == "thin") opts.codegen.lto = LTOMode::Thin;
+            else {
+                std::cerr << "Unknown LTO mode '" << val << "'. Expected full or thin.\n";
                 return 1;
             }
+        } else if (arg.rfind("--arith=", 0) == 0) {
+            if (!parseArithMode(arg.substr(8), opts.codegen.arith)) {
+                std::cerr << "Unknown arithmetic mode '" << arg.substr(8)
+                          << "'. Expected wrap, trap, or saturate.\n";
+                return 1;
+            }
+        } else if (arg.rfind("--instrument=", 0) == 0) {
+            if (arg.substr(13) != "lines") {
+                std::cerr << "Unknown instrumentation '" << arg.substr(13)
+                          << "'. Expected lines.\n";
+                return 1;
+            }
+            opts.codegen.instrumentLines = true;
+        } else if (arg == "--profile-generate") {
+            opts.codegen.profileGenerate = true;
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            opts.codegen.profileUse = arg.substr(14);
+        } else if (arg.rfind("--emit=", 0) == 0) {
+            std::string val = arg.substr(7);
+            if      (val == "exe") opts.emit = EmitKind::Executable;
+            else if (val == "obj") opts.emit = EmitKind::Object;
+            else if (val == "asm") opts.emit = EmitKind::Assembly;
+            else if (val == "ll")  opts.emit = EmitKind::IR;
+            else if (val == "bc")  opts.emit = EmitKind::Bitcode;
+            else if (val == "cwasm") opts.emit = EmitKind::Precompiled;
+            else {
+                std::cerr << "Unknown emit kind '" << val
+                          << "'. Expected exe, obj, asm, ll, bc, or cwasm.\n";
+                return 1;
+            }
+        } else if (run && arg == "--interpret") {
+            interpret = true;
+        } else if (timing.parse(arg)) {
+            // recorded in `timing`
         } else if (arg == "--wasm") {
-            wasm = true;
-        } else if (inputFile.empty()) {
-            inputFile = arg;
+            opts.wasm = true;
+        } else if (arg == "--wasm-startup") {
+            opts.wasm                = true;
+            opts.codegen.wasmStartup = true;
+        } else if (arg == "--ssa") {
+            opts.codegen.ssa = true;
+        } else if (arg.rfind("--codegen-threads=", 0) == 0) {
+            try {
+                opts.codegen.partitions = static_cast<unsigned>(std::stoul(arg.substr(18)));
+            } catch (const std::exception&) {
+                std::cerr << "Invalid thread count '" << arg.substr(18) << "'\n";
+                return 1;
+            }
+            opts.codegen.partitions = std::max(1u, opts.codegen.partitions);
+        } else if (!run && !batch && arg == "--watch") {
+            watch = true;
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--cache-stats") {
+            cacheStats = true;
+        } else if (arg.rfind("--cache-dir=", 0) == 0) {
+            cacheDir = arg.substr(12);
+        } else if (arg.rfind("--max-memory=", 0) == 0) {
+            try {
+                opts.maxMemory = std::stoull(arg.substr(13)) << 20;
+            } catch (const std::exception&) {
+                std::cerr << "Invalid memory budget '" << arg.substr(13) << "'\n";
+                return 1;
+            }
+        } else if (arg.rfind("--cache-size=", 0) == 0) {
+            try {
+                cacheMiB = std::stoull(arg.substr(13));
+            } catch (const std::exception&) {
+                std::cerr << "Invalid cache size '" << arg.substr(13) << "'\n";
+                return 1;
+            }
+        } else if (batch && (arg == "-j" || arg.rfind("--jobs=", 0) == 0)) {
+            const std::string val = arg == "-j" ? (i + 1 < argc ? argv[++i] : "")
+                                                : arg.substr(7);
+            try {
+                jobs = static_cast<unsigned>(std::stoul(val));
+            } catch (const std::exception&) {
+                std::cerr << "Invalid job count '" << val << "'\n";
+                return 1;
+            }
+        } else if (batch && arg.rfind("--out-dir=", 0) == 0) {
+            outDir = arg.substr(10);
+        } else if (batch) {
+            if (!appendInputs(arg, inputs)) return 1;
+        } else if (inputs.empty()) {
+            inputs.push_back(arg);
         } else {
             outputArg = arg;
         }
     }
 
-    if (inputFile.empty()) {
+    ArtifactCache cache(cacheDir, cacheMiB * 1024 * 1024);
+    if (inputs.empty() && cacheStats) {
+        cache.printStats(std::cout);
+        return 0;
+    }
+    if (inputs.empty()) {
         printUsage();
         return 1;
     }
-
-    const std::string outputFile = outputArg.empty()
-        ? defaultOutput(inputFile, wasm)
-        : outputArg;
-
-    // ── Read source ────────────────────────────────────────────────────────
-    std::ifstream file(inputFile);
-    if (!file) {
-        std::cerr << "Error: cannot open '" << inputFile << "'\n";
+    if (run && (opts.wasm || opts.emit != EmitKind::Executable || !outputArg.empty() ||
+                opts.codegen.lto != LTOMode::Full || !opts.codegen.target.triple.empty())) {
+        std::cerr << "'run' executes in-process; --wasm, --target, --emit, --lto=thin "
+                     "and an output path are not accepted.\n";
+        return 1;
+    }
+    if (opts.codegen.profiled()) {
+        const char* problem =
+            opts.codegen.profileGenerate && !opts.codegen.profileUse.empty()
+                ? "--profile-generate and --profile-use are separate builds"
+          : opts.config != BuildConfig::Development && opts.config != BuildConfig::Shipping
+                ? "profiles drive the optimiser: use --config=development or shipping"
+          : run && opts.codegen.profileGenerate
+                ? "'run' cannot link the profile runtime; build an executable"
+          : !opts.codegen.profileUse.empty() &&
+                    !std::filesystem::is_regular_file(opts.codegen.profileUse)
+                ? "--profile-use: no such file"
+                : nullptr;
+        if (problem) {
+            std::cerr << problem << "\n";
+            return 1;
+        }
+    }
+    if (opts.wasm && !opts.codegen.target.triple.empty()) {
+        std::cerr << "--wasm already selects wasm32-unknown-wasi; drop --target.\n";
+        return 1;
+    }
+    if (opts.emit == EmitKind::Precompiled && !opts.wasm) {
+        std::cerr << "--emit=cwasm precompiles a wasm module: add --wasm.\n";
+        return 1;
+    }
+    if (opts.emit == EmitKind::Executable && !targetsHost(opts)) {
+        std::cerr << "Executables are linked against the runtime built for this "
+                     "machine; for --target=" << opts.codegen.target.triple
+                  << " use --emit=obj, asm, ll or bc.\n";
+        return 1;
+    }
+    if (opts.codegen.lto == LTOMode::Thin &&
+        opts.emit != EmitKind::Executable && opts.emit != EmitKind::Bitcode &&
+        opts.emit != EmitKind::Precompiled) {
+        std::cerr << "--lto=thin leaves the backend to a ThinLTO link: use "
+                     "--emit=exe, cwasm or bc.\n";
         return 1;
     }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    const std::string source = ss.str();
 
-    // ── Compile ────────────────────────────────────────────────────────────
-    try {
-        Lexer lexer(source, inputFile);
-        auto  tokens = lexer.tokenize();
+    // ── JIT / interpreter ──────────────────────────────────────────────────
+    if (run && interpret) {
+        if (opts.codegen.instrumentLines) {
+            std::cerr << "--instrument=lines counts compiled code; drop --interpret.\n";
+            return 1;
+        }
+        if (opts.maxMemory) {
+            std::cerr << "--max-memory streams codegen; drop --interpret.\n";
+            return 1;
+        }
+        try {
+            return interpretFile(inputs.front(), timing.get(), opts.codegen.arith);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (run) {
+        try {
+            return runFile(inputs.front(), opts.config, opts.codegen, timing.get(),
+                           opts.maxMemory);
+        } catch (const std::exception& e) {
+            std::cerr << "Compilation error: " << e.what() << "\n";
+            return 1;
+        }
+    }
 
-        Parser parser(std::move(tokens));
-        auto   ast = parser.parse();
+    // ── Watch ──────────────────────────────────────────────────────────────
+    if (watch) {
+        if (opts.maxMemory) {
+            std::cerr << "--watch keeps the program resident; drop --max-memory.\n";
+            return 1;
+        }
+        const std::string& in = inputs.front();
+        return watchFile({in, outputArg.empty() ? defaultOutput(in, opts) : outputArg}, opts);
+    }
 
-        // Absolute paths so LLDB/Wasmtime can locate the source file
-        std::filesystem::path p = std::filesystem::absolute(inputFile);
-        const std::string srcFile = p.filename().string();
-        const std::string srcDir  = p.parent_path().string();
+    if (useCache)
+        opts.cache = &cache;
+    opts.timing = timing.get();
 
-        Codegen cg(srcFile, srcDir, config, wasm);
-        cg.generate(*ast);
+    // ── Batch ──────────────────────────────────────────────────────────────
+    if (batch) {
+        std::vector<CompileJob> work;
+        std::set<std::string>   seen;
+        for (const auto& in : inputs) {
+            CompileJob job{in, defaultOutput(in, opts, outDir)};
+            if (!seen.insert(job.output).second) {
+                std::cerr << "Error: '" << in << "' would overwrite '" << job.output
+                          << "' produced by another input; use distinct stems.\n";
+                return 1;
+            }
+            work.push_back(std::move(job));
+        }
+        if (!outDir.empty())
+            std::filesystem::create_directories(outDir);
 
-        const std::string tmpLL = outputFile + ".tmp.ll";
-        cg.writeIR(tmpLL);
+        const auto results = compileBatch(work, opts, jobs);
 
-        const int rc = linkArtifact(tmpLL, outputFile, config, wasm);
-        if (rc != 0) {
-            std::cerr << "Link step failed (exit " << rc << ")\n";
-            return 1;
+        size_t failed = 0, cached = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            cached += results[i].cached;
+            if (results[i].ok) continue;
+            ++failed;
+            std::cerr << "error: " << work[i].input << ": " << results[i].error << "\n";
         }
+        std::cout << "Built " << (results.size() - failed) << "/" << results.size()
+                  << " files [" << describe(opts) << " / "
+                  << (opts.wasm ? "wasm" : "native") << "]";
+        if (cached) std::cout << ", " << cached << " from cache";
+        if (failed) std::cout << ", " << failed << " failed";
+        std::cout << "\n";
 
-        // Summary line
-        const char* cfgStr  = config == BuildConfig::Debug      ? "debug / O0 / DWARF"
-                            : config == BuildConfig::Development ? "development / O2 / DWARF"
-                                                                 : "shipping / O3+LTO";
-        const char* fmtStr  = wasm ? "wasm" : "native";
-        std::cout << "Compiled '" << inputFile << "' → '" << outputFile
-                  << "' [" << cfgStr << " / " << fmtStr << "]\n";
-        std::cout << "Run:   "
-                  << (wasm ? "wasmtime " : "./") << outputFile << "\n";
+        if (useCache) cache.trim();
+        if (cacheStats) cache.printStats(std::cout);
+        return failed ? 1 : 0;
+    }
 
-    } catch (const std::exception& e) {
-        std::cerr << "Compilation error: " << e.what() << "\n";
+    // ── Single file ────────────────────────────────────────────────────────
+    const std::string& inputFile  = inputs.front();
+    const std::string  outputFile = outputArg.empty()
+        ? defaultOutput(inputFile, opts)
+        : outputArg;
+
+    const CompileResult result = compileFile({inputFile, outputFile}, opts);
+    if (useCache) cache.trim();
+    if (cacheStats) cache.printStats(std::cout);
+    if (!result.ok) {
+        std::cerr << "Compilation error: " << result.error << "\n";
         return 1;
     }
 
+    // Summary line
+    std::cout << "Compiled '" << inputFile << "' → '" << outputFile
+              << "' [" << describe(opts) << " / " << (opts.wasm ? "wasm" : "native")
+              << (result.cached ? " / cached" : "") << "]\n";
+    if (opts.emit == EmitKind::Executable)
+        std::cout << "Run:   "
+                  << (opts.wasm ? "wasmtime " : "./") << outputFile << "\n";
+    else if (opts.emit == EmitKind::Precompiled)
+        std::cout << "Run:   wasmtime run --allow-precompiled " << outputFile << "\n";
+
     return 0;
 }
+
+#endif // NANOSCRIPT_NO_LLVM
@@ -1,17 +1,42 @@
 #include "parser.hpp"
 #include <stdexcept>
 
-Parser::Parser(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
+// Operator tokens map 1:1 onto BinOp; anything else is a parser bug
+static BinOp binOpFor(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS:  return BinOp::Add;
+        case TokenType::MINUS: return BinOp::Sub;
+        case TokenType::STAR:  return BinOp::Mul;
+        case TokenType::SLASH: return BinOp::Div;
+        case TokenType::EQ:    return BinOp::Eq;
+        case TokenType::NEQ:   return BinOp::Ne;
+        case TokenType::LT:    return BinOp::Lt;
+        case TokenType::GT:    return BinOp::Gt;
+        case TokenType::LEQ:   return BinOp::Le;
+        case TokenType::GEQ:   return BinOp::Ge;
+        default: throw std::logic_error("token is not a binary operator");
+    }
+}
+
+Parser::Parser(Lexer& lexer)
+    : diag_(lexer.diagnostics()), lexer_(&lexer), base_(lexer.source().data()),
+      current_(fetch()) {}
+
+Parser::Parser(std::vector<Token> tokens, std::string_view source, DiagnosticEngine& diag)
+    : diag_(diag), tokens_(std::move(tokens)), base_(source.data()), current_(fetch()) {}
 
-const Token& Parser::peek(int offset) const {
-    size_t idx = pos_ + static_cast<size_t>(offset);
-    // Return the EOF token if we're past the end
-    return idx < tokens_.size() ? tokens_[idx] : tokens_.back();
+Token Parser::fetch() {
+    if (lexer_) return lexer_->next();
+    // Keep returning the EOF token once we're past the end
+    return pos_ < tokens_.size() ? tokens_[pos_++] : tokens_.back();
 }
 
-const Token& Parser::advance() {
-    if (pos_ < tokens_.size()) ++pos_;
-    return tokens_[pos_ - 1];
+Token Parser::advance() {
+    Token tok = current_;
+    last_     = tok;
+    if (current_.type != TokenType::EOF_TOKEN)
+        current_ = fetch();
+    return tok;
 }
 
 bool Parser::check(TokenType type) const {
@@ -23,125 +48,402 @@ bool Parser::match(TokenType type) {
     return false;
 }
 
-const Token& Parser::expect(TokenType type, const std::string& msg) {
+static std::string describe(const Token& tok) {
+    if (tok.type == TokenType::EOF_TOKEN) return "end of file";
+    return "'" + std::string(tok.text) + "'";
+}
+
+Token Parser::expect(TokenType type, const char* msg) {
     if (!check(type))
-        throw std::runtime_error(
-            "Parse error at line " + std::to_string(peek().line) +
-            ", col " + std::to_string(peek().col) +
-            ": " + msg + " (got '" + peek().value + "')");
+        fail(peek(), std::string(msg) + " (got " + describe(peek()) + ")");
     return advance();
 }
 
+void Parser::fail(const Token& at, std::string message) {
+    diag_.error(at.line, at.col, std::move(message));
+    throw Panic{};
+}
+
+// ── Recovery ──────────────────────────────────────────────────────────────
+
+StmtNode* Parser::parseStatementOrSync() {
+    try {
+        return parseStatement();
+    } catch (const Panic&) {
+        synchronize();
+        return nullptr;
+    }
+}
+
+// Skip to where the next statement can start: past a ';', or before a '}'
+// that closes an open body, or a keyword that starts a statement. A '}'
+// with no body open is skipped too. Every error is raised after its statement consumed a token
+// or at a token skipped here, so recovery always makes progress.
+void Parser::synchronize() {
+    for (;;) {
+        switch (peek().type) {
+            case TokenType::EOF_TOKEN:
+            case TokenType::IF:
+            case TokenType::WHILE:
+            case TokenType::FOR:
+            case TokenType::OUT:
+            case TokenType::RETURN:
+            case TokenType::FN:
+            case TokenType::INLINE:
+            case TokenType::NOINLINE:
+                return;
+            case TokenType::SEMICOLON:
+                advance();
+                return;
+            case TokenType::RBRACE:
+                if (depth_ == 0) advance();
+                return;
+            default:
+                advance();
+        }
+    }
+}
+
+// Consume up to and including the next `type` within this statement;
+// false (nothing past a ';' or '}' consumed) if it ends first. A for-header
+// has ';'s of its own: `pastSemicolons` skips over them.
+bool Parser::skipTo(TokenType type, bool pastSemicolons) {
+    while (!check(type)) {
+        if ((check(TokenType::SEMICOLON) && !pastSemicolons) ||
+            check(TokenType::RBRACE) || check(TokenType::EOF_TOKEN))
+            return false;
+        advance();
+    }
+    advance();
+    return true;
+}
+
 // ── Top-level ─────────────────────────────────────────────────────────────
 
 std::unique_ptr<ProgramNode> Parser::parse() {
-    auto prog = std::make_unique<ProgramNode>();
-    while (!check(TokenType::EOF_TOKEN))
-        prog->statements.push_back(parseStatement());
+    auto     prog = std::make_unique<ProgramNode>();
+    StmtSpan span;
+    while (StmtNode* stmt = parseTopLevel(*prog, span)) {
+        prog->statements.push_back(stmt);
+        prog->spans.push_back(span);
+    }
+    return prog;
+}
+
+StmtNode* Parser::parseTopLevel(ProgramNode& program, StmtSpan& span) {
+    prog_ = &program;
+    StmtNode* stmt = nullptr;
+    while (!stmt && !check(TokenType::EOF_TOKEN) && !diag_.full()) {
+        span.begin = offsetOf(peek());
+        stmt       = parseStatementOrSync();
+    }
+    if (stmt) {
+        // Tokens never span lines, so the end column follows from the text
+        span.end     = offsetOf(last_) + static_cast<uint32_t>(last_.text.size());
+        span.endLine = last_.line;
+        span.endCol  = last_.col + static_cast<int>(last_.text.size());
+    }
+    prog_ = nullptr;
+    return stmt;
+}
+
+std::unique_ptr<ProgramNode> parseSource(std::string_view source,
+                                         const std::string& filename,
+                                         TimeReport* timing) {
+    DiagnosticEngine             diag(filename);
+    std::unique_ptr<ProgramNode> prog;
+    if (!timing) {
+        // Tokens are pulled by the parser as it goes — never held all at once
+        Lexer  lexer(source, diag);
+        Parser parser(lexer);
+        prog = parser.parse();
+    } else {
+        std::vector<Token> tokens;
+        {
+            TimeReport::Scope t(timing, "lex");
+            tokens = Lexer(source, diag).tokenize();
+        }
+        TimeReport::Scope t(timing, "parse");
+        prog = Parser(std::move(tokens), source, diag).parse();
+    }
+    diag.throwIfErrors();
     return prog;
 }
 
 // ── Statements ────────────────────────────────────────────────────────────
 
-std::unique_ptr<StmtNode> Parser::parseStatement() {
+StmtNode* Parser::parseStatement() {
     if (check(TokenType::IF))         return parseIf();
+    if (check(TokenType::WHILE))      return parseWhile();
+    if (check(TokenType::FOR))        return parseFor();
     if (check(TokenType::OUT))        return parseOut();
+    if (check(TokenType::RETURN))     return parseReturn();
+    if (check(TokenType::FN) || check(TokenType::INLINE) || check(TokenType::NOINLINE))
+        return parseFunction();
     if (check(TokenType::IDENTIFIER)) return parseAssignment();
-    throw std::runtime_error(
-        "Parse error at line " + std::to_string(peek().line) +
-        ": unexpected token '" + peek().value + "'");
+    fail(peek(), "Unexpected token " + describe(peek()));
+}
+
+StmtNode* Parser::parseAssignment() {
+    StmtNode* assign = parseAssign();
+    expect(TokenType::SEMICOLON, "Expected ';' after expression");
+    return assign;
 }
 
-std::unique_ptr<StmtNode> Parser::parseAssignment() {
-    const Token& id = expect(TokenType::IDENTIFIER, "Expected identifier");
+StmtNode* Parser::parseAssign() {
+    const Token id = expect(TokenType::IDENTIFIER, "Expected identifier");
     int ln = id.line, cl = id.col;
+    const SymbolId name = prog_->symbols.intern(id.text);
+    if (match(TokenType::LBRACKET)) {
+        auto index = parseExpr();
+        expect(TokenType::RBRACKET, "Expected ']' after index");
+        expect(TokenType::ASSIGN, "Expected '=' after element");
+        auto val = parseExpr();
+        return make<IndexAssignNode>(name, index, val, ln, cl);
+    }
     expect(TokenType::ASSIGN, "Expected '=' after identifier");
     auto val = parseExpr();
-    expect(TokenType::SEMICOLON, "Expected ';' after expression");
-    return std::make_unique<AssignmentNode>(id.value, std::move(val), ln, cl);
+    return make<AssignmentNode>(name, val, ln, cl);
 }
 
-std::unique_ptr<StmtNode> Parser::parseIf() {
-    const Token& tok = expect(TokenType::IF, "Expected 'if'");
+StmtNode* Parser::parseIf() {
+    const Token tok = expect(TokenType::IF, "Expected 'if'");
     int ln = tok.line, cl = tok.col;
-    expect(TokenType::LPAREN, "Expected '(' after 'if'");
-    auto cond = parseExpr();
-    expect(TokenType::RPAREN, "Expected ')' after condition");
-    expect(TokenType::LBRACE, "Expected '{' to open if-body");
+    ExprNode* cond = nullptr;
+    try {
+        expect(TokenType::LPAREN, "Expected '(' after 'if'");
+        cond = parseExpr();
+        expect(TokenType::RPAREN, "Expected ')' after condition");
+        expect(TokenType::LBRACE, "Expected '{' to open if-body");
+    } catch (const Panic&) {
+        // A broken header: still check the body, if its '{' is in sight
+        if (!skipTo(TokenType::LBRACE)) throw;
+        cond = make<IntLiteralNode>(0, ln, cl);
+    }
 
-    std::vector<std::unique_ptr<StmtNode>> body;
-    while (!check(TokenType::RBRACE) && !check(TokenType::EOF_TOKEN))
-        body.push_back(parseStatement());
+    NodeList<StmtNode> body = parseBody("Expected '}' to close if-body");
+    return make<IfNode>(cond, body, ln, cl);
+}
 
-    expect(TokenType::RBRACE, "Expected '}' to close if-body");
-    return std::make_unique<IfNode>(std::move(cond), std::move(body), ln, cl);
+StmtNode* Parser::parseWhile() {
+    const Token tok = expect(TokenType::WHILE, "Expected 'while'");
+    int ln = tok.line, cl = tok.col;
+    ExprNode* cond = nullptr;
+    try {
+        expect(TokenType::LPAREN, "Expected '(' after 'while'");
+        cond = parseExpr();
+        expect(TokenType::RPAREN, "Expected ')' after condition");
+        expect(TokenType::LBRACE, "Expected '{' to open loop body");
+    } catch (const Panic&) {
+        if (!skipTo(TokenType::LBRACE)) throw;
+        cond = make<IntLiteralNode>(0, ln, cl);
+    }
+    NodeList<StmtNode> body = parseBody("Expected '}' to close loop body");
+    return make<WhileNode>(nullptr, cond, nullptr, body, ln, cl);
 }
 
-std::unique_ptr<StmtNode> Parser::parseOut() {
-    const Token& tok = expect(TokenType::OUT, "Expected 'out'");
+// for '(' assign? ';' expr ';' assign? ')' '{' body '}'
+StmtNode* Parser::parseFor() {
+    const Token tok = expect(TokenType::FOR, "Expected 'for'");
+    int ln = tok.line, cl = tok.col;
+    StmtNode* init = nullptr;
+    ExprNode* cond = nullptr;
+    StmtNode* step = nullptr;
+    try {
+        expect(TokenType::LPAREN, "Expected '(' after 'for'");
+        if (!check(TokenType::SEMICOLON)) init = parseAssign();
+        expect(TokenType::SEMICOLON, "Expected ';' after for-initialiser");
+        cond = parseExpr();
+        expect(TokenType::SEMICOLON, "Expected ';' after for-condition");
+        if (!check(TokenType::RPAREN)) step = parseAssign();
+        expect(TokenType::RPAREN, "Expected ')' after for-step");
+        expect(TokenType::LBRACE, "Expected '{' to open loop body");
+    } catch (const Panic&) {
+        if (!skipTo(TokenType::LBRACE, /*pastSemicolons=*/true)) throw;
+        init = step = nullptr;
+        cond = make<IntLiteralNode>(0, ln, cl);
+    }
+    NodeList<StmtNode> body = parseBody("Expected '}' to close loop body");
+    return make<WhileNode>(init, cond, step, body, ln, cl);
+}
+
+NodeList<StmtNode> Parser::parseBody(const char* what) {
+    // Children are collected on a shared stack, then copied into the arena
+    const size_t base = scratch_.size();
+    ++depth_;
+    while (!check(TokenType::RBRACE) && !check(TokenType::EOF_TOKEN) && !diag_.full())
+        if (StmtNode* stmt = parseStatementOrSync())
+            scratch_.push_back(stmt);
+    --depth_;
+    NodeList<StmtNode> body(prog_->arena, scratch_.data() + base, scratch_.size() - base);
+    scratch_.resize(base);
+
+    expect(TokenType::RBRACE, what);
+    return body;
+}
+
+StmtNode* Parser::parseOut() {
+    const Token tok = expect(TokenType::OUT, "Expected 'out'");
     int ln = tok.line, cl = tok.col;
     auto expr = parseExpr();
     expect(TokenType::SEMICOLON, "Expected ';' after out-expression");
-    return std::make_unique<OutNode>(std::move(expr), ln, cl);
+    return make<OutNode>(expr, ln, cl);
+}
+
+StmtNode* Parser::parseReturn() {
+    const Token tok = expect(TokenType::RETURN, "Expected 'return'");
+    if (!inFunction_) fail(tok, "'return' outside a function");
+    auto value = parseExpr();
+    expect(TokenType::SEMICOLON, "Expected ';' after return value");
+    return make<ReturnNode>(value, tok.line, tok.col);
+}
+
+// ('inline' | 'noinline')? 'fn' IDENT '(' (IDENT (',' IDENT)*)? ')' '{' body '}'
+StmtNode* Parser::parseFunction() {
+    // A nested definition is reported but still parsed, so recovery
+    // resumes after its body rather than inside it
+    const Token start  = peek();
+    const bool  nested = depth_ > 0;
+    if (nested) diag_.error(start.line, start.col, "Functions can only be defined at the top level");
+    InlineHint hint = InlineHint::None;
+    if (match(TokenType::INLINE))        hint = InlineHint::Inline;
+    else if (match(TokenType::NOINLINE)) hint = InlineHint::NoInline;
+    expect(TokenType::FN, "Expected 'fn' after inlining hint");
+    const Token    id   = expect(TokenType::IDENTIFIER, "Expected function name");
+    const SymbolId name = prog_->symbols.intern(id.text);
+
+    std::vector<VariableNode*> params;
+    try {
+        expect(TokenType::LPAREN, "Expected '(' after function name");
+        if (!check(TokenType::RPAREN)) {
+            do {
+                const Token p = expect(TokenType::IDENTIFIER, "Expected parameter name");
+                params.push_back(make<VariableNode>(prog_->symbols.intern(p.text), p.line, p.col));
+            } while (match(TokenType::COMMA));
+        }
+        expect(TokenType::RPAREN, "Expected ')' after parameters");
+        expect(TokenType::LBRACE, "Expected '{' to open function body");
+    } catch (const Panic&) {
+        // As for an if: still check the body, with the parameters read so far
+        if (!skipTo(TokenType::LBRACE)) throw;
+    }
+
+    const bool outer = inFunction_;
+    inFunction_ = true;
+    NodeList<StmtNode> body;
+    try {
+        body = parseBody("Expected '}' to close function body");
+    } catch (const Panic&) {
+        inFunction_ = outer;
+        throw;
+    }
+    inFunction_ = outer;
+    if (nested) return nullptr;
+    return make<FunctionNode>(name,
+                              NodeList<VariableNode>(prog_->arena, params.data(), params.size()),
+                              body, hint, id.line, id.col, start.line, start.col);
 }
 
 // ── Expressions ───────────────────────────────────────────────────────────
 
-std::unique_ptr<ExprNode> Parser::parseExpr() {
+ExprNode* Parser::parseExpr() {
     return parseComparison();
 }
 
-std::unique_ptr<ExprNode> Parser::parseComparison() {
+ExprNode* Parser::parseComparison() {
     auto left = parseAddSub();
     while (check(TokenType::EQ)  || check(TokenType::NEQ) ||
            check(TokenType::LT)  || check(TokenType::GT)  ||
            check(TokenType::LEQ) || check(TokenType::GEQ)) {
-        const Token& op = advance();
+        const Token op = advance();
         int ln = op.line, cl = op.col;
         auto right = parseAddSub();
-        left = std::make_unique<BinaryOpNode>(op.value, std::move(left), std::move(right), ln, cl);
+        left = make<BinaryOpNode>(binOpFor(op.type), left, right, ln, cl);
     }
     return left;
 }
 
-std::unique_ptr<ExprNode> Parser::parseAddSub() {
+ExprNode* Parser::parseAddSub() {
     auto left = parseMulDiv();
     while (check(TokenType::PLUS) || check(TokenType::MINUS)) {
-        const Token& op = advance();
+        const Token op = advance();
         int ln = op.line, cl = op.col;
         auto right = parseMulDiv();
-        left = std::make_unique<BinaryOpNode>(op.value, std::move(left), std::move(right), ln, cl);
+        left = make<BinaryOpNode>(binOpFor(op.type), left, right, ln, cl);
     }
     return left;
 }
 
-std::unique_ptr<ExprNode> Parser::parseMulDiv() {
+ExprNode* Parser::parseMulDiv() {
     auto left = parsePrimary();
     while (check(TokenType::STAR) || check(TokenType::SLASH)) {
-        const Token& op = advance();
+        const Token op = advance();
         int ln = op.line, cl = op.col;
         auto right = parsePrimary();
-        left = std::make_unique<BinaryOpNode>(op.value, std::move(left), std::move(right), ln, cl);
+        left = make<BinaryOpNode>(binOpFor(op.type), left, right, ln, cl);
     }
     return left;
 }
 
-std::unique_ptr<ExprNode> Parser::parsePrimary() {
+ExprNode* Parser::parsePrimary() {
     if (check(TokenType::INT_LITERAL)) {
-        const Token& tok = advance();
-        return std::make_unique<IntLiteralNode>(std::stoll(tok.value), tok.line, tok.col);
+        const Token tok = advance();
+        return make<IntLiteralNode>(tok.intValue, tok.line, tok.col);
     }
     if (check(TokenType::IDENTIFIER)) {
-        const Token& tok = advance();
-        return std::make_unique<VariableNode>(tok.value, tok.line, tok.col);
+        const Token    tok  = advance();
+        if (check(TokenType::LPAREN))
+            return parseCall(tok);
+        const SymbolId name = prog_->symbols.intern(tok.text);
+        if (match(TokenType::LBRACKET)) {
+            auto index = parseExpr();
+            expect(TokenType::RBRACKET, "Expected ']' after index");
+            return make<IndexNode>(name, index, tok.line, tok.col);
+        }
+        return make<VariableNode>(name, tok.line, tok.col);
     }
+    if (check(TokenType::LBRACKET))
+        return parseArray();
     if (check(TokenType::LPAREN)) {
         advance(); // consume '('
         auto expr = parseExpr();
         expect(TokenType::RPAREN, "Expected ')' to close expression");
         return expr;
     }
-    throw std::runtime_error(
-        "Parse error at line " + std::to_string(peek().line) +
-        ": expected expression, got '" + peek().value + "'");
+    fail(peek(), "Expected expression (got " + describe(peek()) + ")");
+}
+
+ExprNode* Parser::parseArray() {
+    const Token open = expect(TokenType::LBRACKET, "Expected '['");
+    int ln = open.line, cl = open.col;
+    auto first = parseExpr();
+    if (match(TokenType::SEMICOLON)) {
+        const Token count = expect(TokenType::INT_LITERAL, "Expected array length");
+        if (count.intValue < 1 || count.intValue > MAX_ARRAY_LENGTH)
+            fail(count, "Array length must be between 1 and " +
+                        std::to_string(MAX_ARRAY_LENGTH));
+        expect(TokenType::RBRACKET, "Expected ']' after array length");
+        return make<ArrayRepeatNode>(first, static_cast<uint32_t>(count.intValue), ln, cl);
+    }
+
+    // Collected here, then copied into the arena
+    std::vector<ExprNode*> elements{first};
+    while (match(TokenType::COMMA))
+        elements.push_back(parseExpr());
+    expect(TokenType::RBRACKET, "Expected ']' to close array");
+    return make<ArrayLiteralNode>(NodeList<ExprNode>(prog_->arena, elements.data(), elements.size()),
+                                  ln, cl);
+}
+
+ExprNode* Parser::parseCall(const Token& callee) {
+    expect(TokenType::LPAREN, "Expected '(' after function name");
+    std::vector<ExprNode*> args;
+    if (!check(TokenType::RPAREN)) {
+        do args.push_back(parseExpr());
+        while (match(TokenType::COMMA));
+    }
+    expect(TokenType::RPAREN, "Expected ')' after arguments");
+    return make<CallNode>(prog_->symbols.intern(callee.text),
+                          NodeList<ExprNode>(prog_->arena, args.data(), args.size()),
+                          callee.line, callee.col);
 }
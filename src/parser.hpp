@@ -1,38 +1,103 @@
 #pragma once
 #include "lexer.hpp"
 #include "ast.hpp"
+#include "timing.hpp"
 #include <memory>
+#include <string_view>
 #include <vector>
 
 class Parser {
 public:
-    explicit Parser(std::vector<Token> tokens);
+    /// Streaming: tokens are pulled from `lexer` on demand, one token of
+    /// lookahead, so the full token vector is never materialised. Syntax
+    /// errors go to the lexer's DiagnosticEngine.
+    explicit Parser(Lexer& lexer);
+    /// Pre-lexed: parse an already tokenized input (EOF_TOKEN last) of
+    /// `source`, which the tokens' text points into.
+    Parser(std::vector<Token> tokens, std::string_view source, DiagnosticEngine& diag);
+
+    /// Parse the whole input. Statements with syntax errors are reported and
+    /// left out, so check the DiagnosticEngine before using the result.
     std::unique_ptr<ProgramNode> parse();
 
+    /// Parse one top-level statement into `program` (its arena and symbol
+    /// table) and report where it sits in the source. Statements that fail
+    /// to parse are reported and skipped. Returns nullptr at EOF, or once
+    /// the diagnostics are full.
+    StmtNode* parseTopLevel(ProgramNode& program, StmtSpan& span);
+
+    /// The token the next statement starts with.
+    const Token& lookahead() const { return current_; }
+    /// Byte offset of `tok` in the source.
+    uint32_t offsetOf(const Token& tok) const {
+        return static_cast<uint32_t>(tok.text.data() - base_);
+    }
+
 private:
-    std::vector<Token> tokens_;
+    // Unwinds from an error (already reported) to the innermost statement
+    // loop, which resynchronises — panic-mode recovery. Valid input never
+    // throws it.
+    struct Panic {};
+
+    DiagnosticEngine&  diag_;
+    Lexer*             lexer_ = nullptr;  // streaming source, or ...
+    std::vector<Token> tokens_;           // ... pre-lexed tokens
     size_t             pos_ = 0;
+    const char*        base_ = nullptr;   // start of the source buffer
+    Token              current_;          // lookahead
+    Token              last_{};           // most recently consumed token
+    ProgramNode*       prog_ = nullptr;   // arena + symbols for new nodes
+    std::vector<StmtNode*> scratch_;      // statement stack for nested bodies
+    int                depth_ = 0;        // bodies open at the current token
+    bool               inFunction_ = false;
 
-    const Token& peek(int offset = 0) const;
-    const Token& advance();
+    template <typename T, typename... Args>
+    T* make(Args&&... args) { return prog_->arena.make<T>(std::forward<Args>(args)...); }
+
+    Token        fetch();
+    const Token& peek() const { return current_; }
+    Token        advance();
     bool         check(TokenType type) const;
     bool         match(TokenType type);
-    const Token& expect(TokenType type, const std::string& msg);
+    Token        expect(TokenType type, const char* msg);
+    [[noreturn]] void fail(const Token& at, std::string message);
+
+    StmtNode* parseStatementOrSync();
+    void      synchronize();
+    bool      skipTo(TokenType type, bool pastSemicolons = false);
 
-    std::unique_ptr<StmtNode> parseStatement();
-    std::unique_ptr<StmtNode> parseAssignment();
-    std::unique_ptr<StmtNode> parseIf();
-    std::unique_ptr<StmtNode> parseOut();
+    StmtNode* parseStatement();
+    StmtNode* parseAssignment();
+    StmtNode* parseAssign();   // IDENT ('[' expr ']')? '=' expr, no terminator
+    StmtNode* parseIf();
+    StmtNode* parseWhile();
+    StmtNode* parseFor();
+    StmtNode* parseOut();
+    StmtNode* parseReturn();
+    StmtNode* parseFunction();   // top level only
+    /// Statements up to the closing '}' of a body whose '{' was consumed.
+    NodeList<StmtNode> parseBody(const char* what);
 
     // Expression grammar (precedence climbing):
     //   expr       → comparison
     //   comparison → addSub (('==' | '!=' | '<' | '>' | '<=' | '>=') addSub)?
     //   addSub     → mulDiv (('+' | '-') mulDiv)*
     //   mulDiv     → primary (('*' | '/') primary)*
-    //   primary    → INT_LITERAL | IDENT | '(' expr ')'
-    std::unique_ptr<ExprNode> parseExpr();
-    std::unique_ptr<ExprNode> parseComparison();
-    std::unique_ptr<ExprNode> parseAddSub();
-    std::unique_ptr<ExprNode> parseMulDiv();
-    std::unique_ptr<ExprNode> parsePrimary();
+    //   primary    → INT_LITERAL | IDENT ('[' expr ']')? | call | '(' expr ')'
+    //              | '[' expr (',' expr)* ']' | '[' expr ';' INT_LITERAL ']'
+    ExprNode* parseExpr();
+    ExprNode* parseComparison();
+    ExprNode* parseAddSub();
+    ExprNode* parseMulDiv();
+    ExprNode* parsePrimary();
+    ExprNode* parseArray();
+    ExprNode* parseCall(const Token& callee);   // IDENT '(' (expr (',' expr)*)? ')'
 };
+
+/// Lex + parse `source`. Streams tokens into the parser, except when
+/// `timing` is set: then the whole input is tokenized first, so lexing and
+/// parsing are reported as separate phases. Throws SyntaxError listing
+/// every error in the file.
+std::unique_ptr<ProgramNode> parseSource(std::string_view source,
+                                         const std::string& filename,
+                                         TimeReport* timing = nullptr);
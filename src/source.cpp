@@ -0,0 +1,100 @@
+#include "source.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Buffered read — used for empty files (which cannot be mapped) and for
+// anything that is not a regular file.
+static std::string readWhole(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("cannot open '" + path + "'");
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+#ifdef _WIN32
+
+SourceFile::SourceFile(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("cannot open '" + path + "'");
+
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_) {
+            data_ = static_cast<const char*>(
+                MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (data_) {
+                size_   = static_cast<size_t>(size.QuadPart);
+                mapped_ = true;
+            } else {
+                CloseHandle(mapping_);
+                mapping_ = nullptr;
+            }
+        }
+    }
+    CloseHandle(file);   // the mapping keeps its own reference
+
+    if (!mapped_) {
+        fallback_ = readWhole(path);
+        data_     = fallback_.data();
+        size_     = fallback_.size();
+    }
+}
+
+SourceFile::~SourceFile() {
+    if (mapped_) {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+}
+
+#else // POSIX
+
+SourceFile::SourceFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open '" + path + "'");
+
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            // The lexer makes a single forward pass
+            ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data_   = static_cast<const char*>(p);
+            size_   = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);   // the mapping stays valid after close
+
+    if (!mapped_) {
+        fallback_ = readWhole(path);
+        data_     = fallback_.data();
+        size_     = fallback_.size();
+    }
+}
+
+SourceFile::~SourceFile() {
+    if (mapped_)
+        ::munmap(const_cast<char*>(data_), size_);
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/// Read-only contents of a source file, memory-mapped where the OS allows
+/// (mmap on POSIX, a file mapping on Windows) so the bytes are never copied
+/// onto the heap. Pipes and other unmappable inputs fall back to a read.
+///
+/// The Lexer and its Tokens hold views into text(), so the SourceFile must
+/// outlive them; the AST copies what it keeps and may outlive it.
+class SourceFile {
+public:
+    /// Throws std::runtime_error when the file cannot be opened.
+    explicit SourceFile(const std::string& path);
+    ~SourceFile();
+
+    SourceFile(const SourceFile&)            = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    std::string_view text() const { return {data_, size_}; }
+
+private:
+    const char* data_   = nullptr;
+    size_t      size_   = 0;
+    bool        mapped_ = false;
+#ifdef _WIN32
+    void*       mapping_ = nullptr;   // HANDLE from CreateFileMapping
+#endif
+    std::string fallback_;            // owns the bytes when not mapped
+};
@@ -0,0 +1,176 @@
+#include "timing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// ── Clocks ────────────────────────────────────────────────────────────────
+
+double TimeReport::wallSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+double TimeReport::threadCPUSeconds() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+        return 0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return static_cast<double>(ticks(kernel) + ticks(user)) * 1e-7;   // 100 ns units
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#endif
+}
+
+uint64_t TimeReport::peakRSSBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+#else
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(ru.ru_maxrss);          // bytes
+#else
+    return static_cast<uint64_t>(ru.ru_maxrss) * 1024;   // KiB
+#endif
+#endif
+}
+
+// ── Recording ─────────────────────────────────────────────────────────────
+
+TimeReport::Scope::Scope(TimeReport* report, std::string_view phase)
+    : report_(report), phase_(phase) {
+    if (!report_) return;
+    wall0_ = wallSeconds();
+    cpu0_  = threadCPUSeconds();
+}
+
+TimeReport::Scope::~Scope() {
+    if (report_)
+        report_->addPhase(phase_, wallSeconds() - wall0_, threadCPUSeconds() - cpu0_);
+}
+
+void TimeReport::add(std::vector<Entry>& list,
+                     std::unordered_map<std::string, size_t>& index,
+                     std::string_view name, double wall, double cpu, uint64_t rss) {
+    auto [it, inserted] = index.emplace(std::string(name), list.size());
+    if (inserted) list.push_back({std::string(name)});
+    Entry& e = list[it->second];
+    ++e.count;
+    e.wall   += wall;
+    e.cpu    += cpu;
+    e.peakRSS = std::max(e.peakRSS, rss);
+}
+
+void TimeReport::addPhase(std::string_view name, double wallSec, double cpuSec) {
+    const uint64_t rss = peakRSSBytes();
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(phases_, phaseIndex_, name, wallSec, cpuSec, rss);
+}
+
+void TimeReport::addPass(std::string_view name, double wallSec, double cpuSec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(passes_, passIndex_, name, wallSec, cpuSec, 0);
+}
+
+// ── Output ────────────────────────────────────────────────────────────────
+
+void TimeReport::print(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto flags = os.flags();
+    os << std::fixed;
+
+    double wall = 0, cpu = 0;
+    for (const Entry& e : phases_) { wall += e.wall; cpu += e.cpu; }
+
+    os << "===-------------------------------------------------------------===\n"
+       << "                      NanoScript time report\n"
+       << "===-------------------------------------------------------------===\n"
+       << "  Phase                 Wall (ms)    CPU (ms)  Peak RSS (MiB)  Count\n";
+    auto row = [&](const Entry& e, bool rss) {
+        os << "  " << std::left << std::setw(20) << e.name << std::right
+           << std::setprecision(3) << std::setw(11) << e.wall * 1e3
+           << std::setw(12) << e.cpu * 1e3;
+        if (rss)
+            os << std::setprecision(1) << std::setw(16) << e.peakRSS / (1024.0 * 1024.0);
+        else
+            os << std::setw(16) << "";
+        os << std::setw(7) << e.count << "\n";
+    };
+    for (const Entry& e : phases_) row(e, true);
+    os << "  " << std::left << std::setw(20) << "total" << std::right
+       << std::setprecision(3) << std::setw(11) << wall * 1e3
+       << std::setw(12) << cpu * 1e3
+       << std::setprecision(1) << std::setw(16) << peakRSSBytes() / (1024.0 * 1024.0)
+       << "\n";
+
+    if (!passes_.empty()) {
+        std::vector<const Entry*> sorted;
+        for (const Entry& e : passes_) sorted.push_back(&e);
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const Entry* a, const Entry* b) { return a->wall > b->wall; });
+        os << "\n  LLVM pass (exclusive)  Wall (ms)    CPU (ms)                  Count\n";
+        for (const Entry* e : sorted) row(*e, false);
+    }
+    os.flags(flags);
+}
+
+static void writeJSONString(std::ostream& os, std::string_view s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+        else os << c;
+    }
+    os << '"';
+}
+
+void TimeReport::printJSON(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+
+    auto list = [&](const char* key, const std::vector<Entry>& entries, bool rss) {
+        os << "\"" << key << "\":[";
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry& e = entries[i];
+            os << (i ? "," : "") << "{\"name\":";
+            writeJSONString(os, e.name);
+            os << ",\"count\":" << e.count
+               << ",\"wall_ms\":" << e.wall * 1e3
+               << ",\"cpu_ms\":" << e.cpu * 1e3;
+            if (rss) os << ",\"peak_rss_bytes\":" << e.peakRSS;
+            os << "}";
+        }
+        os << "]";
+    };
+
+    double wall = 0, cpu = 0;
+    for (const Entry& e : phases_) { wall += e.wall; cpu += e.cpu; }
+
+    os << "{";
+    list("phases", phases_, true);
+    os << ",";
+    list("passes", passes_, false);
+    os << ",\"total\":{\"wall_ms\":" << wall * 1e3
+       << ",\"cpu_ms\":" << cpu * 1e3
+       << ",\"peak_rss_bytes\":" << peakRSSBytes() << "}}\n";
+    os.flags(flags);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Wall time, CPU time and peak RSS per compile phase, plus per-pass cost
+/// of the LLVM pipelines — what `--time-report` prints.
+///
+/// Phases with the same name are summed, so a batch build reports totals
+/// across every file. Safe to record into from several worker threads;
+/// CPU time is measured per thread, so concurrent phases don't inflate it.
+class TimeReport {
+public:
+    /// Times one phase from construction to destruction. A null report
+    /// makes it a no-op, so call sites need no branches.
+    class Scope {
+    public:
+        Scope(TimeReport* report, std::string_view phase);
+        ~Scope();
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TimeReport*      report_;
+        std::string_view phase_;
+        double           wall0_ = 0, cpu0_ = 0;
+    };
+
+    void addPhase(std::string_view name, double wallSec, double cpuSec);
+    void addPass(std::string_view name, double wallSec, double cpuSec);
+
+    /// Human-readable tables.
+    void print(std::ostream& os) const;
+    /// The same data as one JSON object, for dashboards.
+    void printJSON(std::ostream& os) const;
+
+    // ── Clocks ────────────────────────────────────────────────────────────
+    static double   wallSeconds();      // monotonic
+    static double   threadCPUSeconds(); // CPU time of the calling thread
+    static uint64_t peakRSSBytes();     // high-water mark of the process
+
+private:
+    struct Entry {
+        std::string name;
+        uint64_t    count   = 0;
+        double      wall    = 0;
+        double      cpu     = 0;
+        uint64_t    peakRSS = 0;  // phases only: process peak when it ended
+    };
+
+    static void add(std::vector<Entry>& list,
+                    std::unordered_map<std::string, size_t>& index,
+                    std::string_view name, double wall, double cpu, uint64_t rss);
+
+    mutable std::mutex                      mutex_;
+    std::vector<Entry>                      phases_;   // first-seen order
+    std::vector<Entry>                      passes_;
+    std::unordered_map<std::string, size_t> phaseIndex_;
+    std::unordered_map<std::string, size_t> passIndex_;
+};
@@ -0,0 +1,234 @@
+#include "types.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+std::string typeName(uint32_t length) {
+    return length == 0 ? "int64" : "int64[" + std::to_string(length) + "]";
+}
+
+namespace {
+
+class TypeChecker {
+public:
+    explicit TypeChecker(ProgramNode& program)
+        : prog_(program),
+          lengths_(program.symbols.size(), 0),
+          declared_(program.symbols.size(), false),
+          functions_(program.symbols.size(), nullptr) {}
+
+    void run() {
+        defineFunctions();
+        block(prog_.statements.data(), prog_.statements.size());
+    }
+
+    // Every definition first: a call may precede its callee
+    void defineFunctions() {
+        uint32_t count = 0;
+        for (StmtNode* s : prog_.statements) {
+            if (s->kind != NodeKind::Function) continue;
+            auto& f = static_cast<FunctionNode&>(*s);
+            if (functions_[f.name])
+                fail(f, "Function " + quoted(f.name) + " is defined twice");
+            functions_[f.name] = &f;
+            f.index = count++;
+        }
+    }
+
+    // One more top-level statement, whose identifiers may be new
+    void topLevel(StmtNode& s) {
+        const size_t symbols = prog_.symbols.size();
+        lengths_.resize(symbols, 0);
+        declared_.resize(symbols, false);
+        functions_.resize(symbols, nullptr);
+        statement(s);
+    }
+
+private:
+    ProgramNode&          prog_;
+    std::vector<uint32_t> lengths_;    // SymbolId → length of its type
+    std::vector<bool>     declared_;   // SymbolId → assigned yet
+    std::vector<FunctionNode*> functions_;   // SymbolId → its definition
+
+    [[noreturn]] static void fail(const ASTNode& at, const std::string& message) {
+        throw std::runtime_error(message + " at line " + std::to_string(at.line));
+    }
+
+    std::string quoted(SymbolId id) const {
+        return "'" + std::string(prog_.symbols.name(id)) + "'";
+    }
+
+    // ── Expressions ───────────────────────────────────────────────────────
+
+    uint32_t expr(ExprNode& e, bool wholeValue = false) {
+        switch (e.kind) {
+            case NodeKind::IntLiteral:
+                e.length = 0;
+                break;
+            case NodeKind::Variable:
+                // Not yet declared: 0, and codegen reports the read
+                e.length = lengths_[static_cast<VariableNode&>(e).name];
+                break;
+            case NodeKind::Index: {
+                auto& n = static_cast<IndexNode&>(e);
+                element(n, n.array, *n.index);
+                e.length = 0;
+                break;
+            }
+            case NodeKind::ArrayLiteral: {
+                auto& n = static_cast<ArrayLiteralNode&>(e);
+                if (!wholeValue)
+                    fail(n, "An array literal must be the whole right-hand side of an assignment");
+                for (ExprNode* el : n.elements)
+                    scalar(*el, "An array element");
+                e.length = n.elements.size;
+                break;
+            }
+            case NodeKind::ArrayRepeat: {
+                auto& n = static_cast<ArrayRepeatNode&>(e);
+                scalar(*n.value, "An array element");
+                e.length = n.count;
+                break;
+            }
+            case NodeKind::Call: {
+                auto& n = static_cast<CallNode&>(e);
+                const FunctionNode* f = functions_[n.callee];
+                if (!f) fail(n, "Undefined function " + quoted(n.callee));
+                if (n.args.size != f->params.size)
+                    fail(n, "Function " + quoted(n.callee) + " takes " +
+                            std::to_string(f->params.size) + " argument" +
+                            (f->params.size == 1 ? "" : "s") + ", not " +
+                            std::to_string(n.args.size));
+                for (ExprNode* arg : n.args)
+                    scalar(*arg, "An argument");
+                n.function = f->index;
+                e.length   = 0;
+                break;
+            }
+            case NodeKind::BinaryOp: {
+                auto& n = static_cast<BinaryOpNode&>(e);
+                const uint32_t l = expr(*n.left), r = expr(*n.right);
+                // A scalar operand is broadcast; two arrays must match
+                if (l && r && l != r)
+                    fail(n, "Operands of '" + std::string(binOpSpelling(n.op)) + "' are " +
+                            typeName(l) + " and " + typeName(r));
+                e.length = std::max(l, r);
+                break;
+            }
+            default:
+                throw std::logic_error("Unknown expression kind in type checker");
+        }
+        return e.length;
+    }
+
+    void scalar(ExprNode& e, const char* what) {
+        if (expr(e) != 0)
+            fail(e, std::string(what) + " must be an int64, not " + typeName(e.length));
+    }
+
+    // `array[index]`, read or written
+    void element(const ASTNode& at, SymbolId array, ExprNode& index) {
+        scalar(index, "An index");
+        if (!declared_[array]) return;   // undefined: reported by codegen
+        const uint32_t length = lengths_[array];
+        if (length == 0)
+            fail(at, "Cannot index " + quoted(array) + " of type int64");
+        if (index.kind == NodeKind::IntLiteral) {
+            const int64_t i = static_cast<const IntLiteralNode&>(index).value;
+            if (i < 0 || i >= length)
+                fail(index, "Index " + std::to_string(i) + " out of range for " +
+                            typeName(length));
+        }
+    }
+
+    // ── Statements ────────────────────────────────────────────────────────
+
+    // Checked in a scope of its own: the caller's variables are set aside
+    void function(FunctionNode& f) {
+        std::vector<uint32_t> lengths(prog_.symbols.size(), 0);
+        std::vector<bool>     declared(prog_.symbols.size(), false);
+        std::swap(lengths_,  lengths);
+        std::swap(declared_, declared);
+        for (const VariableNode* p : f.params) {
+            if (declared_[p->name])
+                fail(*p, "Parameter " + quoted(p->name) + " appears twice");
+            declared_[p->name] = true;
+        }
+        block(f.body.data, f.body.size);
+        std::swap(lengths_,  lengths);
+        std::swap(declared_, declared);
+    }
+
+    void block(StmtNode* const* stmts, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            statement(*stmts[i]);
+    }
+
+    void statement(StmtNode& s) {
+        switch (s.kind) {
+            case NodeKind::Assignment: {
+                auto& n = static_cast<AssignmentNode&>(s);
+                const uint32_t length = expr(*n.value, /*wholeValue=*/true);
+                if (declared_[n.varName] && lengths_[n.varName] != length)
+                    fail(n, "Cannot assign " + typeName(length) + " to " + quoted(n.varName) +
+                            " of type " + typeName(lengths_[n.varName]));
+                declared_[n.varName] = true;
+                lengths_[n.varName]  = length;
+                break;
+            }
+            case NodeKind::IndexAssign: {
+                auto& n = static_cast<IndexAssignNode&>(s);
+                element(n, n.array, *n.index);
+                scalar(*n.value, "A stored element");
+                break;
+            }
+            case NodeKind::If: {
+                auto& n = static_cast<IfNode&>(s);
+                scalar(*n.condition, "A condition");
+                block(n.body.data, n.body.size);
+                break;
+            }
+            case NodeKind::While: {
+                auto& n = static_cast<WhileNode&>(s);
+                if (n.init) statement(*n.init);
+                scalar(*n.condition, "A condition");
+                block(n.body.data, n.body.size);
+                if (n.step) statement(*n.step);
+                break;
+            }
+            case NodeKind::Out:
+                expr(*static_cast<OutNode&>(s).expr);   // an array prints every element
+                break;
+            case NodeKind::Return:
+                scalar(*static_cast<ReturnNode&>(s).value, "A return value");
+                break;
+            case NodeKind::Function:
+                function(static_cast<FunctionNode&>(s));
+                break;
+            default:
+                throw std::logic_error("Unknown statement kind in type checker");
+        }
+    }
+};
+
+} // namespace
+
+void checkTypes(ProgramNode& program) {
+    TypeChecker(program).run();
+}
+
+struct StatementChecker::Impl {
+    TypeChecker checker;
+};
+
+StatementChecker::StatementChecker(ProgramNode& functions)
+    : impl_(new Impl{TypeChecker(functions)}) {
+    impl_->checker.run();
+}
+
+StatementChecker::~StatementChecker() = default;
+
+void StatementChecker::check(StmtNode& stmt) {
+    impl_->checker.topLevel(stmt);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "ast.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/// "int64" or "int64[N]", as diagnostics spell a length.
+std::string typeName(uint32_t length);
+
+/// Set every expression's ExprNode::length, number the function definitions
+/// and resolve every call to one, and check that the program is well typed,
+/// before it is folded. A variable takes the type of its first
+/// assignment in source order within its function (or the top level),
+/// which is the order codegen and the interpreter see it in; reads before
+/// that are left for them to report as undefined. Throws
+/// std::runtime_error at the first of:
+///   - a call of a function that is not defined, or with the wrong number
+///     of arguments, or a function defined twice,
+///   - an operator over two arrays of different lengths,
+///   - an array where an int64 is required: an index, a condition, an
+///     element, the value stored into an element, an argument or a
+///     return value,
+///   - indexing an int64, or a constant index out of range,
+///   - assigning a variable a type other than its own,
+///   - an array literal anywhere but the whole right-hand side.
+void checkTypes(ProgramNode& program);
+
+/// checkTypes() for a program lowered as it is parsed (--max-memory), one
+/// top-level statement at a time, by the same rules and with the same errors.
+class StatementChecker {
+public:
+    /// Numbers and checks `functions`, a program whose statements are all
+    /// of its function definitions and nothing else.
+    explicit StatementChecker(ProgramNode& functions);
+    ~StatementChecker();
+
+    /// The next top-level statement in source order; it belongs to the
+    /// same program (arena and symbols) as the definitions.
+    void check(StmtNode& stmt);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,103 @@
+#include "watch.hpp"
+
+#include "fold.hpp"
+#include "source.hpp"
+#include "types.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// ── Incremental build ─────────────────────────────────────────────────────
+
+IncrementalBuild::IncrementalBuild(std::string inputFile, CompileOptions opts)
+    : input_(inputFile), opts_(std::move(opts)), parse_(std::move(inputFile)) {}
+
+IncrementalBuild::Stats IncrementalBuild::update(std::string source) {
+    const IncrementalParse::Splice splice = parse_.update(std::move(source));
+    ProgramNode&                   program = *parse_.program();
+    // One linear pass; a type can change with any edit before its use
+    checkTypes(program);
+
+    if (!cg_) {
+        // Absolute paths so LLDB/Wasmtime can locate the source file
+        std::filesystem::path p = std::filesystem::absolute(input_);
+        cg_ = std::make_unique<Codegen>(p.filename().string(), p.parent_path().string(),
+                                        opts_.config, opts_.wasm, codegenOptions(opts_));
+    }
+
+    // Fold a copy, made afresh from the first statement on: the folder
+    // rewrites nodes in place, and what it knows about one statement comes
+    // from all the ones before it. Unchanged statements fold as they did
+    // last time, so codegen still resumes where `first` lands.
+    const Arena::Mark      mark = program.arena.mark();
+    std::vector<StmtNode*> parsed;
+    parsed.swap(program.statements);
+    for (const StmtNode* s : parsed)
+        if (s->kind == NodeKind::Function)
+            program.statements.push_back(cloneStatement(*s, program.arena));
+    StatementFolder        folder(program, codegenOptions(opts_).arith);
+    std::vector<StmtNode*> functions;
+    functions.swap(program.statements);
+    size_t first = 0, nextFunction = 0;
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        if (i == splice.first) first = program.statements.size();
+        if (parsed[i]->kind == NodeKind::Function)
+            program.statements.push_back(functions[nextFunction++]);
+        else
+            folder.fold(cloneStatement(*parsed[i], program.arena), program.statements);
+    }
+    if (splice.first >= parsed.size()) first = program.statements.size();
+
+    auto restore = [&] {
+        program.statements.swap(parsed);
+        program.arena.rewind(mark);
+    };
+    try {
+        cg_->generateFrom(program, first);
+    } catch (...) {
+        restore();
+        throw;
+    }
+    restore();
+    return {program.statements.size(), splice.inserted, splice.first};
+}
+
+// ── Watch loop ────────────────────────────────────────────────────────────
+
+int watchFile(const CompileJob& job, const CompileOptions& opts) {
+    IncrementalBuild build(job.input, opts);
+    std::filesystem::file_time_type seen{};
+    if (!std::filesystem::exists(job.input)) {
+        std::cerr << "Error: cannot read '" << job.input << "'\n";
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Watching '" << job.input << "' → '" << job.output << "' (Ctrl-C to stop)\n";
+    for (;;) {
+        std::error_code ec;
+        const auto mtime = std::filesystem::last_write_time(job.input, ec);
+        if (ec || mtime == seen) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        seen = mtime;
+
+        const double t0 = TimeReport::wallSeconds();
+        try {
+            const SourceFile file(job.input);
+            const IncrementalBuild::Stats s = build.update(std::string(file.text()));
+            build.codegen().withSnapshot(
+                [&] { emitArtifact(build.codegen(), job.output, opts, /*resident=*/true); });
+            std::cout << "[watch] rebuilt in " << (TimeReport::wallSeconds() - t0) * 1e3
+                      << " ms: " << s.reparsed << " of " << s.statements
+                      << " statements re-parsed, codegen from #" << s.codegenFrom + 1
+                      << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << "[watch] error: " << e.what() << std::endl;
+        }
+    }
+}
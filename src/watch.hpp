@@ -0,0 +1,45 @@
+#pragma once
+#include "driver.hpp"
+#include "incremental.hpp"
+
+#include <memory>
+#include <string>
+
+/// One program's AST (see IncrementalParse) and LLVM module kept resident
+/// between edits, so a rebuild only redoes what an edit can have changed.
+/// Codegen reruns from the first changed statement: variables flow
+/// forward, so everything after it may lower differently.
+///
+/// The AST is folded like any other build's, but on a fresh copy each
+/// time: the folder rewrites the tree in place, and the resident one has
+/// to stay as parsed for the next edit.
+class IncrementalBuild {
+public:
+    IncrementalBuild(std::string inputFile, CompileOptions opts);
+
+    struct Stats {
+        size_t statements  = 0;   // top-level statements in the program
+        size_t reparsed    = 0;   // of which lexed and parsed again
+        size_t codegenFrom = 0;   // first statement given new IR
+    };
+
+    /// Bring the AST and module up to date with `source`. Throws on a
+    /// lex or parse error (see IncrementalParse::update). A codegen error
+    /// (e.g. an undefined variable) throws too; the AST is current by then,
+    /// and the next update resumes codegen where it stopped.
+    Stats update(std::string source);
+
+    /// The resident module, for emission via Codegen::withSnapshot().
+    Codegen& codegen() { return *cg_; }
+
+private:
+    std::string              input_;
+    CompileOptions           opts_;
+    IncrementalParse         parse_;
+    std::unique_ptr<Codegen> cg_;
+};
+
+/// `--watch`: build `job`, then poll its source and rebuild incrementally
+/// after every save, printing a status line per rebuild. Returns only when
+/// the input does not exist at the start.
+int watchFile(const CompileJob& job, const CompileOptions& opts);